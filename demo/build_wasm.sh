@@ -0,0 +1,12 @@
+#!/bin/sh
+# Builds main.c for the browser with Emscripten. The page ends up in
+# demo/wasm/index.html and has to be served over HTTP, not opened as a
+# file. ASYNCIFY lets the game loop sleep without blocking the page.
+cd "$(dirname "$0")/.." || exit 1
+mkdir -p demo/wasm
+
+emcc -std=gnu11 -O2 -sASYNCIFY -sALLOW_MEMORY_GROWTH \
+    -sEXPORTED_FUNCTIONS=_main,_press_key \
+    -o demo/wasm/flappy-bird.js demo/wasm_main.c -lm || exit 1
+
+cp demo/wasm.html demo/wasm/index.html
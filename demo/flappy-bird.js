@@ -1,3 +1,30 @@
+/*
+ * Browser port of main.c for the online demo. The page gives it a
+ * canvas, a clock and the keyboard; everything is drawn into an RGB565
+ * framebuffer like the board's and shown with one blit per frame.
+ *
+ * The renderer follows main.c: the sky image, the grass strip, the
+ * shaded pipe sprites, the rotated and flapping bird frames and the
+ * bit-packed font with its outline are built the same way and give the
+ * same pixels. Pipe heights come from the same seeded generator.
+ *
+ * The game logic follows main.c's default build too: pixel collision
+ * against the frame the bird is drawn with, swept along each step.
+ *
+ * What stays diverged from main.c:
+ *  - Only the menu, game and game over screens exist. Replay, netplay,
+ *    the autopilot, ghosts, audio and the frame governor do not
+ *  - Text the board writes to the character buffer is drawn by the
+ *    page on top of the canvas, in the page's font
+ *  - The whole sky is redrawn every frame instead of only what the
+ *    pipes leave visible, which gives the same pixels
+ *
+ * demo/test.js plays a scripted game headless under Node and checks a
+ * hash of every frame against demo/test_hashes.json. test/test_session.c
+ * plays the same script on main.c and checks it against the same
+ * hashes.
+*/
+
 /* This files provides address values that exist in the system */
 const SDRAM_BASE = 0xC0000000;
 const FPGA_CHAR_BASE = 0xC9000000;
@@ -21,17 +48,27 @@ const RESOLUTION_Y = 240;
 /* Flappy bird specific constants */
 const SCROLL_VIEW_AMOUNT = 2;
 
-/* Score */
-const NUM_DIGITS = 10;
+/* Text */
+// Glyphs are FONT_CHAR_WIDTH x FONT_CHAR_HEIGHT, one number per row with
+// the leftmost pixel in bit FONT_CHAR_WIDTH - 1. Digits come first,
+// then A to Z
+const FONT_CHAR_WIDTH = 5;
+const FONT_CHAR_HEIGHT = 7;
+const NUM_FONT_GLYPHS = 36;
+
+// Blank columns between two glyphs, before scaling
+const FONT_CHAR_SPACING = 1;
 
-// Dimensions of the character font
-const SCORE_CHAR_WIDTH = 4;
-const SCORE_CHAR_HEIGHT = 6;
+// Text can be drawn at 1 to FONT_MAX_SCALE times its size
+const FONT_MAX_SCALE = 3;
 
 // Scaling; For example if 2, then font is drawn at twice
 // its normal size
 const SCORE_CHAR_SCALE = 2;
-const SCORE_POS_X = (RESOLUTION_X - 30);
+const TITLE_CHAR_SCALE = 3;
+
+// Top right corner of the score while playing
+const SCORE_POS_X = (RESOLUTION_X - 24);
 const SCORE_POS_Y = 10;
 
 /* Pipes */
@@ -43,6 +80,12 @@ const PIPE_VOID_HEIGHT = 70;
 const PIPE_SPACING = 120;
 const PIPE_START_X = 140;
 
+// The head is a pixel wider than the body on each side, outline included
+const PIPE_HEAD_WIDTH = (PIPE_WIDTH + 3);
+const PIPE_BODY_WIDTH = (PIPE_WIDTH + 1);
+// Pixels the head reaches past the body on each side
+const PIPE_HEAD_OVERHANG = 1;
+
 /* Birds */
 const BIRD_WIDTH = 34;
 const BIRD_HEIGHT = 24;
@@ -52,6 +95,29 @@ const BIRD_INITIAL_VELOCITY = -0.1;
 const BIRD_JUMP_VELOCITY = 3.2;
 const BIRD_GRAVITY = 0.4;
 
+// The sprite hangs 2 pixels left of the bird's x
+const BIRD_MASK_LEFT = -2;
+
+// The bird tilts by BIRD_DEGREES_PER_VELOCITY for every unit of
+// y_velocity, nose up when rising and diving when falling. Tilts are
+// rounded to one of NUM_BIRD_ANGLES angles BIRD_ANGLE_STEP degrees apart
+const BIRD_MIN_ANGLE = -30;
+const BIRD_ANGLE_STEP = 15;
+const NUM_BIRD_ANGLES = 9;
+const BIRD_DEGREES_PER_VELOCITY = 10;
+
+// Wing up, level and down, each held for WING_FRAME_TICKS frames. The
+// wing moves WING_FLAP_DY pixels up or down from level
+const NUM_WING_FRAMES = 3;
+const WING_FRAME_TICKS = 4;
+const WING_FLAP_DY = 2;
+
+// Any rotation of the sprite about its centre fits in a square canvas
+// of this size, drawn at this offset from the bird's position
+const BIRD_CANVAS_SIZE = 42;
+const BIRD_CANVAS_LEFT = -6;
+const BIRD_CANVAS_TOP = -9;
+
 /* Modes */
 const MODE_MENU = 0;
 const MODE_GAME = 1;
@@ -65,117 +131,138 @@ const SKY_THICKNESS = (RESOLUTION_Y - TOTAL_FLOOR_HEIGHT);
 const GRASS_SQUARE_WIDTH = 10;
 const SKY_IMG_NUM_OF_RUNS = 12994;
 
-// This is calulated from (RESOLUTION_X) / GRASS_SQUARE_WIDTH
-const NUM_GRASS_SQUARE = 34;
+// Grass alternates between two colors, so it repeats every two squares
+const GRASS_PERIOD = (GRASS_SQUARE_WIDTH * 2);
+
+// Rows of the screen the grass covers, outlines included. The strip it
+// is pre-rendered into is a period wider than the screen
+const GRASS_STRIP_TOP = (SKY_THICKNESS - 1);
+const GRASS_STRIP_HEIGHT = (GRASS_THICKNESS + 3);
+const GRASS_STRIP_WIDTH = (RESOLUTION_X + GRASS_PERIOD);
+
+/* Blending */
+// Alpha goes from 0 (keep destination) to 32 (use source)
+const GAME_OVER_DIM_ALPHA = 12;
+const GAME_OVER_FADE_FRAMES = 16;
 
 /* Key data */
 const SPACE_KEY = 0x29;
 const ENTER_KEY = 0x5A;
 const BACK_SPACE_KEY = 0x66;
 
-// Custom font for digits of image
-const digits_image = [
-    // Zero
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // One
-    [
-        [ 0, 0, 0, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-    ],
-
-    // Two
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // Three
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // Four
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-    ],
-
-    // Five
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // Six
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // Seven
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 1, 0, 0 ],
-        [ 0, 1, 0, 0 ],
-        [ 0, 1, 0, 0 ],
-    ],
-
-    // Eight
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-    ],
-
-    // Nine
-    [
-        [ 0, 0, 0, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 1, 0, 1, 0 ],
-        [ 1, 1, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-        [ 0, 0, 1, 0 ],
-    ]
+// Bit-packed font, one number per row. Bit FONT_CHAR_WIDTH - 1 is the
+// leftmost column
+const font_glyphs = [
+    [ 0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110 ], // 0
+    [ 0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 ], // 1
+    [ 0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111 ], // 2
+    [ 0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110 ], // 3
+    [ 0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010 ], // 4
+    [ 0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110 ], // 5
+    [ 0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110 ], // 6
+    [ 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000 ], // 7
+    [ 0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110 ], // 8
+    [ 0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100 ], // 9
+    [ 0b01110, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001 ], // A
+    [ 0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110 ], // B
+    [ 0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110 ], // C
+    [ 0b11100, 0b10010, 0b10001, 0b10001, 0b10001, 0b10010, 0b11100 ], // D
+    [ 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111 ], // E
+    [ 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000 ], // F
+    [ 0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01111 ], // G
+    [ 0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001 ], // H
+    [ 0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 ], // I
+    [ 0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100 ], // J
+    [ 0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001 ], // K
+    [ 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111 ], // L
+    [ 0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001 ], // M
+    [ 0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001 ], // N
+    [ 0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 ], // O
+    [ 0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000 ], // P
+    [ 0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101 ], // Q
+    [ 0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001 ], // R
+    [ 0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110 ], // S
+    [ 0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100 ], // T
+    [ 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 ], // U
+    [ 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100 ], // V
+    [ 0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b10101, 0b01010 ], // W
+    [ 0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001 ], // X
+    [ 0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100, 0b00100 ], // Y
+    [ 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111 ], // Z
 ];
 
+// Bird sprite as rectangles relative to the top left point of the
+// bird, drawn in this order: x0, y0, x1, y1 inclusive and color.
+// Modified based on this to draw bird:
+// https://www.pinterest.com/pin/559924166147577544/
+const bird_sprite = [
+    [  -2, 10, -1, 13, BLACK  ],
+    [   0,  8,  1,  9, BLACK  ],
+    [   0, 10,  1, 11, WHITE  ],
+    [   0, 12,  1, 13, YELLOW ],
+    [   0, 14,  1, 15, BLACK  ],
+    [  10,  0, 21,  1, BLACK  ],
+    [   6,  2,  9,  3, BLACK  ],
+    [  16,  2, 17,  3, YELLOW ],
+    [  18,  2, 19,  3, BLACK  ],
+    [  20,  2, 21,  3, WHITE  ],
+    [  22,  2, 23,  3, BLACK  ],
+    [   4,  4,  5,  5, BLACK  ],
+    [   6,  4,  9,  5, YELLOW ],
+    [  16,  4, 17,  9, BLACK  ],
+    [  22,  4, 23,  5, WHITE  ],
+    [  24,  4, 25,  5, BLACK  ],
+    [   2,  6,  7,  7, BLACK  ],
+    [   8,  6,  9,  7, YELLOW ],
+    [  18, 10, 19, 11, BLACK  ],
+    [  18,  4, 21,  9, WHITE  ],
+    [  22,  6, 23,  9, BLACK  ],
+    [  24,  6, 25, 11, WHITE  ],
+    [  26,  6, 27, 11, BLACK  ],
+    [   2,  8,  7, 13, WHITE  ],
+    [   8,  8,  9,  9, BLACK  ],
+    [  10,  2, 15,  9, YELLOW ],
+    [  20, 10, 23, 11, WHITE  ],
+    [   8, 10,  9, 11, WHITE  ],
+    [   8, 12,  9, 13, YELLOW ],
+    [  10, 10, 11, 13, BLACK  ],
+    [  12, 10, 17, 15, YELLOW ],
+    [  18, 12, 19, 13, YELLOW ],
+    [  20, 12, 29, 13, BLACK  ],
+    [   2, 14,  7, 15, YELLOW ],
+    [   8, 14,  9, 15, BLACK  ],
+    [  10, 14, 11, 15, YELLOW ],
+    [  18, 14, 19, 15, BLACK  ],
+    [  20, 14, 29, 15, ORANGE ],
+    [  30, 14, 31, 15, BLACK  ],
+    [   2, 16,  7, 17, BLACK  ],
+    [   8, 16, 15, 19, SAND   ],
+    [  16, 16, 17, 17, BLACK  ],
+    [  18, 16, 19, 17, ORANGE ],
+    [  20, 16, 29, 17, BLACK  ],
+    [   6, 18,  7, 19, BLACK  ],
+    [  16, 18, 17, 19, SAND   ],
+    [  18, 18, 19, 19, BLACK  ],
+    [  20, 18, 27, 19, ORANGE ],
+    [  28, 18, 29, 19, BLACK  ],
+    [   8, 20, 11, 21, BLACK  ],
+    [  12, 20, 19, 21, SAND   ],
+    [  20, 20, 29, 21, BLACK  ],
+    [  12, 22, 19, 23, BLACK  ],
+];
+
+// Body under the wing, shown where the wing was when it flaps up or
+// down. Wing pixels left of these are outside the body and turn
+// transparent instead. The wing covers rows y0 to y1 of these rects
+const bird_wing_underlay = [
+    [   2,  6,  3, 17, BLACK  ],
+    [   4,  6,  7, 17, YELLOW ],
+    [   8,  8,  9, 15, YELLOW ],
+];
+
+// cos and sin of each tilt angle, times 256
+const bird_angle_cos = [ 222, 247, 256, 247, 222, 181, 128, 66, 0 ];
+const bird_angle_sin = [ -128, -66, 0, 66, 128, 181, 222, 247, 256 ];
 
 // Adapted from https://flappybird.io/img/background.png
 // image for sky encoded using Run-Length Encoding in 565 RGB format
@@ -183,17 +270,77 @@ const sky_img_rle = [
 30298,320,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,319,28152,1,30298,213,32346,1,36506,12,34458,1,30298,92,28152,1,30298,213,40666,1,61404,1,61436,11,61404,1,32378,1,30298,91,28152,1,30298,213,40666,1,61436,12,61404,1,34426,1,30298,91,28152,1,30298,209,53115,1,59323,1,59355,3,61436,13,59355,4,46875,1,30298,87,28152,1,30298,209,55195,1,61436,21,48955,1,30298,87,28152,1,30298,13,46875,1,55195,12,46907,1,30298,139,32346,1,53115,1,55195,12,42747,1,30298,23,34426,1,55195,4,61404,1,61436,21,59355,1,55195,4,34426,1,30298,82,28152,1,30298,13,51035,1,61436,12,51067,1,30298,139,32346,1,59355,1,61436,12,46907,1,30298,23,36506,1,61436,31,34426,1,30298,82,28152,1,30298,8,32378,1,44795,4,55195,1,61436,12,57275,1,44795,4,32378,1,30298,130,34426,1,44795,3,44827,1,61404,1,61436,12,53115,1,44795,6,32346,1,30298,14,34426,1,44795,1,46907,1,61436,31,46875,1,44795,1,34426,1,30298,80,28152,1,30298,8,36506,1,61436,22,36506,1,30298,130,40634,1,61436,23,61404,1,32378,1,30298,14,40634,1,61436,35,38586,1,30298,80,28152,1,30298,4,36506,1,40634,3,44795,1,61436,22,44827,1,40634,3,36506,1,30298,59,32378,1,40634,12,38586,1,30298,49,38586,1,40634,3,46875,1,61436,24,42714,1,40666,1,40634,2,36506,1,30298,8,34426,1,40634,1,46875,1,61436,35,38586,1,30298,10,38586,1,40634,12,32378,1,30298,56,28152,1,30298,4,51067,1,61436,30,53115,1,30298,59,40634,1,61404,1,61436,11,55195,1,30298,49,55195,1,61436,32,48955,1,30298,8,44827,1,61404,1,61436,36,38586,1,30298,10,55195,1,61436,12,36506,1,30298,56,28152,1,30298,4,53115,1,61436,30,53115,1,30298,59,40666,1,61436,12,55195,1,30298,49,55195,1,61436,32,48955,1,30298,8,44827,1,61436,37,38586,1,30298,10,55195,1,61436,12,36506,1,30298,56,28152,1,30298,2,53115,1,57275,1,61404,1,61436,30,61404,1,57275,1,53115,1,30298,53,51035,1,57275,3,59323,1,61436,12,61404,1,57275,4,40634,1,30298,24,51035,1,57275,12,44827,1,30298,4,53115,1,57275,1,61404,1,61436,32,59355,1,57275,4,34426,1,30298,1,51035,1,57275,1,59355,1,61436,37,57275,2,44795,1,30298,3,34426,1,57275,4,61436,13,57275,4,48955,1,30298,24,51035,1,57275,12,38586,1,30298,12,34426,1,57275,1,55130,1,30298,2,55227,1,61436,34,57275,1,30298,53,55195,1,61436,21,42714,1,30298,24,55195,1,61436,12,48955,1,30298,4,57275,1,61436,39,34426,1,30298,1,55195,1,61436,41,46907,1,30298,3,36506,1,61436,21,51067,1,30298,24,55195,1,61436,12,40666,1,30298,12,36506,1,61436,1,59290,1,55195,2,61404,1,61436,34,61404,1,55195,1,53115,1,32378,1,30298,45,38586,1,55195,4,61403,1,61436,21,57275,1,55195,3,51035,1,30298,15,38586,1,55195,4,61403,1,61436,12,59323,1,55195,4,61404,1,61436,39,55195,2,61403,1,61436,41,59323,1,55195,4,61436,21,59355,1,55195,4,36506,1,30298,14,38586,1,55195,4,61403,1,61436,12,57275,1,55195,3,48987,1,30298,6,38586,1,55195,2,61436,1,59290,1,61436,39,59356,1,32378,1,30298,45,40666,1,61436,30,57275,1,30298,15,40666,1,61436,137,38586,1,30298,14,40666,1,61436,21,55195,1,30298,6,40666,1,61436,3,59290,1,61436,39,61404,1,44827,1,44795,1,32378,1,30298,41,40634,1,44795,1,51035,1,61436,30,59355,1,44795,1,42747,1,32346,1,30298,8,40666,1,44795,3,51035,1,61436,137,48955,1,44795,1,34458,1,30298,8,40666,1,44795,3,51035,1,61436,21,59323,1,44795,6,48987,1,61436,3,59290,1,61436,42,36506,1,30298,41,51035,1,61436,34,59356,1,32378,1,30298,8,55195,1,61436,143,42714,1,30298,8,55195,1,61436,36,59290,1,61436,42,36506,1,30298,39,36506,1,38586,1,55195,1,61436,34,61404,1,40666,1,38586,1,32346,1,30298,3,32378,1,38586,2,57275,1,61436,143,46907,1,38586,1,36506,1,30298,4,38586,2,57275,1,61436,36,59290,1,61436,42,36506,1,30298,39,55195,1,61436,39,36506,1,30298,3,40666,1,61404,1,61436,147,53115,1,30298,3,32346,1,59355,1,61436,38,59290,1,61436,42,40666,1,36506,1,32346,1,30298,10,32346,1,34458,12,34426,1,30298,11,34426,1,34458,1,57275,1,61436,39,40666,1,36506,1,34458,2,44795,1,61436,148,53147,1,36506,1,34458,2,36506,1,59355,1,61436,38,59290,1,61436,44,40666,1,30298,10,40634,1,61404,1,61436,11,55195,1,30298,10,32346,1,59355,1,61436,238,59290,1,61436,44,40666,1,30298,10,40666,1,61436,12,55195,1,32346,1,30298,9,32346,1,59355,1,61436,238,59290,1,61436,44,40666,1,30298,6,53115,1,59323,3,59355,1,61436,13,59323,4,40666,1,30298,5,32346,1,59355,1,61436,238,59290,1,61436,44,40666,1,30298,6,55195,1,61436,21,42714,1,30298,5,32346,1,59355,1,61436,238,59290,1,61436,44,57275,1,55195,6,61404,1,61436,21,57275,1,55195,6,61436,239,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,319,59290,1,61436,59,61435,1,53114,6,51034,1,46875,10,48987,1,61436,57,59355,1,53114,6,48955,1,46875,10,57276,1,61436,59,55194,1,53114,6,46907,1,46875,10,59324,1,61436,56,59355,1,53114,6,51034,1,46875,10,51067,1,61436,12,59290,1,61436,59,61435,1,51033,1,48985,5,46874,1,42715,10,46875,1,61436,57,59323,1,48985,6,44795,1,42715,10,55195,1,61436,59,53146,1,48985,5,48953,1,42715,11,57276,1,61436,56,59355,1,48985,6,46906,1,42715,10,48955,1,61436,12,59290,1,61436,59,61435,1,51033,1,48985,1,53113,4,48954,1,42715,1,42747,1,48955,6,46875,1,42715,1,46875,1,61436,57,59323,1,48985,1,51033,1,53113,4,44795,1,42715,1,46875,1,48955,6,44795,1,42715,1,55195,1,61436,59,53146,1,48985,1,51033,1,53113,4,42747,1,42715,1,46875,1,48955,5,46875,1,42715,2,57276,1,61436,56,59355,1,48985,2,53113,4,48954,1,42715,1,42747,1,48955,6,44795,1,42715,1,48955,1,61436,12,59290,1,61436,59,61435,1,51033,1,48985,1,57241,4,53082,1,42715,1,44795,1,57241,6,53114,1,42715,1,46875,1,61436,57,59323,1,48985,1,51033,1,57241,4,44795,1,42715,1,53082,1,57241,6,46843,1,42715,1,55195,1,61436,59,53146,1,48985,1,53113,1,57241,3,57242,1,42747,1,42715,1,55162,1,57241,5,55162,1,42715,2,57276,1,61436,56,59355,1,48985,2,55193,1,57241,3,53114,1,42715,1,44795,1,57241,6,46875,1,42715,1,48955,1,61436,12,59290,1,61436,33,61403,11,61435,1,61436,12,61404,1,57276,1,55227,1,48954,1,46906,1,53082,1,53114,3,51003,1,42715,1,44795,1,57241,3,55193,1,57241,2,53114,1,42715,1,46875,1,61436,31,61403,11,61436,13,59324,1,57276,1,53147,1,48954,2,53114,4,44795,1,42715,1,53082,1,57241,2,55193,1,57241,3,46843,1,42715,1,55195,1,61436,32,61435,1,61403,11,61436,13,57276,2,51034,1,48954,2,53114,3,53082,1,42747,1,42715,1,55162,1,57241,2,55193,1,57241,2,55162,1,42715,2,57276,1,61436,30,61403,11,61435,1,61436,12,61404,1,57276,1,55195,1,48954,1,46906,1,53082,1,53114,3,51002,1,42715,1,44795,1,57241,2,55193,2,57241,2,46875,1,42715,1,48955,1,61436,12,59290,1,61436,33,61371,1,59290,10,61403,1,61436,12,59324,1,42715,10,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,46875,1,61436,30,61403,1,59290,10,59291,1,61436,13,48955,1,42715,10,53082,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,55195,1,61436,32,61403,1,59290,10,61371,1,61436,13,46875,1,42715,10,55162,1,57241,1,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,57276,1,61436,30,61371,1,59290,10,61403,1,61436,12,55196,1,42747,1,42715,9,44795,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48955,1,61436,12,59290,1,61436,29,61403,4,61371,1,59290,10,61403,1,61436,12,59324,1,42715,2,44795,8,46875,1,57241,2,53113,1,51033,1,55193,1,57241,1,53114,1,42715,1,46875,1,61436,26,61435,1,61403,4,59290,10,59291,1,61436,13,48955,1,42715,2,44795,8,53114,1,57241,1,55193,1,51033,1,53113,1,57241,2,46843,1,42715,1,55195,1,61436,28,61435,1,61403,4,59290,10,61371,1,61436,13,46875,1,42715,1,44795,9,55162,1,57241,1,53113,1,51033,1,53113,1,57241,1,55162,1,42715,2,57276,1,61436,26,61403,4,59291,1,59290,10,61403,1,61436,12,55196,1,42715,2,44795,8,46875,1,57241,2,51033,2,57241,2,46875,1,42715,1,48955,1,61436,12,59290,1,61436,28,61403,1,59290,15,61403,1,61436,12,59324,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,46875,1,61436,26,61371,1,59290,14,59291,1,61436,13,48955,1,42715,1,46875,1,57241,15,46843,1,42715,1,55195,1,61436,28,61371,1,59290,14,61371,1,61436,13,46875,1,42715,1,53082,1,57241,14,55162,1,42715,2,57276,1,61436,25,61403,1,59290,15,61403,1,61436,12,55196,1,42715,1,44795,1,57241,15,46875,1,42715,1,48955,1,61436,12,59290,1,61436,28,61403,1,59290,15,61403,1,61436,12,59324,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,44827,1,61436,26,61371,1,59290,14,59291,1,61404,1,61436,12,48955,1,42715,1,46875,1,57241,15,46843,1,42715,1,55195,1,61436,28,61371,1,59290,14,59291,1,61436,13,46875,1,42715,1,53082,1,57241,14,55162,1,42715,2,57276,1,61436,25,61403,1,59290,15,61403,1,61436,12,55196,1,42715,1,44795,1,57241,15,46875,1,42715,1,48955,1,61404,1,61436,11,59290,1,44795,6,51035,1,61436,19,61403,1,59291,2,59290,10,59291,1,44795,15,48987,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,53081,1,51033,1,55193,1,57241,1,55193,1,51033,1,53081,1,57241,2,53081,1,51033,1,55161,1,57241,1,53114,1,42715,2,44795,6,57244,1,61436,17,61371,1,59291,1,59290,11,55131,1,44795,15,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,51033,2,57241,2,53081,1,51033,1,55193,1,57241,1,55193,1,51033,1,53081,1,57241,2,46843,1,42715,1,44795,6,44827,1,61404,1,61436,19,59291,2,59290,11,51003,1,44795,14,48955,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,51033,2,57241,2,51033,2,57241,2,53113,1,51033,1,53113,1,57241,1,55162,1,42715,2,44795,6,46907,1,61436,17,61403,1,59291,2,59290,10,57211,1,44795,15,57244,1,61436,1,55196,1,42715,1,44795,1,57241,2,53081,1,51033,1,55161,1,57241,1,55193,1,51033,2,57241,2,51033,2,57241,2,46875,1,42715,1,42747,1,44795,6,55196,1,61436,5,59290,1,42715,6,48955,1,61436,19,61403,1,59290,12,59291,1,44795,1,42715,14,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,8,55196,1,61436,17,61371,1,59290,12,55131,1,42715,15,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,7,42747,1,61404,1,61436,19,59291,1,59290,12,48923,1,42715,14,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,8,46875,1,61436,17,61403,1,59290,12,57211,1,42715,15,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,8,55195,1,61436,5,59290,1,48954,2,53114,1,55162,1,46875,1,42715,1,48955,1,61436,17,61371,2,59291,1,59290,12,59291,1,44795,1,42715,1,51034,1,55162,8,48954,2,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48954,2,53114,1,55162,1,44795,1,42715,1,55196,1,61436,15,61371,2,59291,1,59290,12,55131,1,42715,1,44795,1,55162,8,53082,1,48954,1,46874,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48954,1,48986,1,55162,1,53082,1,42715,1,42747,1,61404,1,61436,16,61435,1,61371,2,59290,13,48923,1,42715,1,46875,1,55162,8,51034,1,48954,1,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,46874,1,48954,1,51034,1,55162,1,51034,1,42715,1,46875,1,61436,15,61371,2,59291,1,59290,12,57211,1,42715,2,51034,1,55162,7,53114,1,48954,2,42747,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48954,2,55162,2,44795,1,42715,1,55195,1,61436,5,59290,1,48985,2,57241,2,46875,1,42715,1,48955,1,61436,17,61371,1,59290,14,59291,1,44795,1,42715,1,55162,1,57241,8,51033,1,48985,1,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,44795,1,42715,1,55196,1,61436,15,59291,1,59290,14,55131,1,42715,1,44795,1,57241,8,55193,1,48985,1,48953,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,1,55162,1,42715,1,42747,1,61404,1,61436,16,61403,1,59290,15,48923,1,42715,1,46875,1,57241,8,53113,1,48985,1,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,53114,1,42715,1,46875,1,61436,15,61371,1,59290,14,57211,1,42715,2,55162,1,57241,8,51033,1,48985,1,44795,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,46843,1,42715,1,55195,1,61436,5,59290,1,46874,2,51002,1,51034,1,44795,1,42715,1,46875,1,53115,8,55228,1,61436,8,61371,1,59290,14,59291,1,44795,1,42715,1,55162,1,57241,1,55193,1,55161,1,55193,1,57241,4,51033,1,48985,1,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,55161,1,53113,1,57241,3,53113,1,55161,1,57241,2,55161,1,53113,1,57241,2,53114,1,42715,1,42747,1,46874,2,51034,2,44795,1,42715,1,51035,1,53115,8,59356,1,61436,6,59291,1,59290,14,55131,1,42715,1,44795,1,57241,2,55161,2,57241,4,55193,1,48985,1,48953,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,53113,2,57241,2,55161,1,53113,1,57241,3,53113,1,55161,1,57241,2,46843,1,42715,1,44794,1,46874,1,48954,1,51034,1,48955,1,42715,2,53115,8,55196,1,61436,8,61403,1,59290,15,48923,1,42715,1,46875,1,57241,2,55161,2,57241,4,53113,1,48985,1,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,2,53113,2,57241,2,53113,2,57241,2,55161,1,53113,1,55161,1,57241,1,55162,1,42715,2,44826,1,46874,1,48954,1,51034,1,48955,1,42715,1,44795,1,53115,8,55228,1,61436,6,61371,1,59290,14,57211,1,42715,2,55162,1,57241,1,55193,1,55161,1,55193,1,57241,4,51033,1,48985,1,44795,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,55161,1,53113,1,57241,3,53113,2,57241,2,53113,2,57241,2,46875,1,42715,1,42747,1,46874,2,51034,2,44795,1,42715,1,48955,1,53115,5,50970,1,42715,15,48955,1,61436,8,61371,1,59290,14,59291,1,44795,1,42715,1,55162,1,57241,1,53113,1,48985,1,53081,1,57241,4,51033,1,48985,1,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,17,55195,1,61436,6,59291,1,59290,14,55131,1,42715,1,44795,1,57241,2,51033,1,48985,1,57241,4,55193,1,48985,1,48953,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,15,46843,1,42715,16,46875,1,61436,8,61403,1,59290,15,48923,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,4,53113,1,48985,1,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,14,55162,1,42715,17,48955,1,61436,6,61371,1,59290,14,57211,1,42715,2,55162,1,57241,1,53113,1,48985,1,53113,1,57241,4,51033,1,48985,1,44795,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,15,46875,1,42715,14,40570,1,44795,2,46875,11,44795,1,42715,1,48955,1,61403,6,61436,2,61371,1,59290,8,57211,1,55131,6,42715,2,51034,1,53114,1,48954,3,53114,4,48954,1,46906,1,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,2,55193,1,57241,3,55193,1,57241,4,55193,1,57241,2,53114,1,42715,2,44795,2,46875,11,42747,1,42715,1,55163,1,61403,4,61436,2,59291,1,59290,8,55131,6,51003,1,42715,1,44795,1,53114,2,48954,1,46906,1,53082,1,53114,3,51034,1,48954,1,46874,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,55193,2,57241,3,55193,1,57241,3,55193,1,57241,3,46843,1,42715,1,42747,1,44795,2,46875,10,44795,1,42715,1,46875,1,61403,7,61436,1,61403,1,59290,8,59291,1,55131,6,46875,1,42715,1,46843,1,53114,1,53082,1,48954,2,53082,1,53114,3,48954,2,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,2,55193,1,57241,3,55193,2,57241,3,55193,1,57241,2,55162,1,42715,2,44795,2,46875,11,44795,1,42715,1,48955,1,61403,4,61435,1,61436,1,61371,1,59290,8,55163,1,55131,5,53083,1,42715,2,51034,1,53114,1,48954,3,53114,4,48954,1,46906,1,42747,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,3,55193,1,57241,3,55193,1,57241,3,55193,2,57241,2,46875,1,42715,2,44795,2,46875,10,44730,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,21,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,22,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,51033,2,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,21,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,51033,2,57241,2,51033,1,48985,1,57241,2,53113,1,51033,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,21,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,51033,2,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,21,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,22,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,21,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,21,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,46875,1,55162,12,53114,1,48953,4,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,53082,1,55162,12,51034,1,48953,3,46874,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,55162,13,48985,1,48953,3,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,51034,1,55162,13,48953,4,42747,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,46875,1,57241,13,48985,4,44795,1,42715,1,48955,1,61436,1,59324,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,55162,1,57241,12,53113,1,48985,3,48953,1,42715,2,57276,1,61436,1,48955,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,57241,13,51033,1,48985,3,46874,1,42715,1,46875,1,61436,2,46875,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,53082,1,57241,13,48985,4,44795,1,42715,1,55196,1,61436,1,55196,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,2,53113,1,51033,1,53113,1,57241,2,51033,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,53113,1,51033,1,53113,1,57241,2,48985,4,44795,1,42715,1,46875,1,59323,1,57243,1,42715,1,42747,1,57242,1,57241,2,55193,1,57241,3,55193,1,57241,4,55193,1,57241,2,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,53113,1,51033,1,55193,1,57241,1,55193,1,51033,1,53113,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48954,1,51033,1,55193,1,57241,2,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,53113,1,48985,3,48953,1,42715,2,57211,1,61371,1,48923,1,42715,1,46875,1,57241,2,55193,2,57241,3,55193,1,57241,3,55193,1,57241,3,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,51033,1,53081,1,57241,2,53113,1,51033,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,51033,2,57241,2,53113,1,51033,1,53113,1,57241,2,51033,1,53081,1,57241,2,51033,1,48985,3,46874,1,42715,1,46843,1,59323,1,61371,1,46875,1,42715,1,53082,1,57241,2,55193,1,57241,4,55193,1,57241,3,55193,1,57241,2,55162,1,42715,2,48953,1,48985,1,55161,1,57241,2,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,48954,1,51033,1,53113,1,57241,2,51033,2,57241,2,53113,1,51033,1,53113,1,57241,2,48985,4,44795,1,42715,1,55163,1,61371,1,55163,1,42715,1,44795,1,57241,3,55193,1,57241,3,55193,1,57241,4,55193,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,53113,1,51033,1,55193,1,57241,2,51033,1,53113,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,2,48985,4,44795,1,42715,1,46875,1,59290,1,57211,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,3,48953,1,42715,2,55163,1,59290,1,48923,1,42715,1,46875,1,57241,15,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,3,46874,1,42715,1,46843,1,59290,2,46843,1,42715,1,53082,1,57241,14,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,4,44795,1,42715,1,53083,1,59290,1,55131,1,42715,1,44795,1,57241,15,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,2,48985,4,44795,1,42715,1,46875,1,53114,1,51034,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,3,48953,1,42715,2,51034,1,53114,1,46875,1,42715,1,46875,1,57241,15,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,3,46874,1,42715,1,44795,1,53114,2,44795,1,42715,1,53082,1,57241,14,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,4,44795,1,42715,1,51002,1,53114,1,51002,1,42715,1,44795,1,57241,15,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,2,48985,4,44795,1,42715,1,44795,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,3,48953,1,42715,2,48953,1,48985,1,44795,1,42715,1,46875,1,57241,15,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,3,46874,1,42715,1,44795,1,48985,2,44795,1,42715,1,53082,1,57241,14,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,4,44795,1,42715,1,46906,1,48985,1,46874,1,42715,1,44795,1,57241,15,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,51033,1,53113,1,57241,2,51033,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,51033,1,53113,1,57241,2,53113,1,51033,1,57241,2,53113,1,51033,1,53081,1,53114,1,53082,1,48954,4,44795,1,42715,1,44795,1,48954,1,46874,1,42715,1,42747,1,57242,1,57241,2,55193,1,57241,3,55193,1,57241,4,55193,1,57241,2,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,53113,1,51033,1,55193,1,57241,2,53081,1,53113,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48954,1,51033,1,55193,1,57241,2,51033,1,53113,1,57241,2,53113,1,51033,1,53114,2,48954,4,46874,1,42715,2,46874,1,48954,1,44795,1,42715,1,46875,1,57241,2,55193,2,57241,3,55193,1,57241,3,55193,1,57241,3,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,51033,1,53081,1,57241,2,53113,1,51033,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,51033,2,57241,2,55161,1,51033,1,53113,1,57241,2,51033,2,53114,2,48954,4,46874,1,42715,1,42747,1,48954,2,42747,1,42715,1,53082,1,57241,2,55193,1,57241,4,55193,1,57241,3,55193,1,57241,2,55162,1,42715,2,48953,1,48985,1,55161,1,57241,2,51033,1,53113,1,57241,2,53113,1,51033,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,48954,1,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,55161,1,51033,1,53113,1,53114,1,53082,1,48954,4,42747,1,42715,1,46874,1,48954,1,46874,1,42715,1,44795,1,57241,3,55193,1,57241,3,55193,1,57241,4,55193,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,53113,1,51033,1,55193,1,57241,2,51033,1,53113,1,57241,1,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,46875,1,57241,10,53082,1,42715,12,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,55162,1,57241,10,44795,1,42715,12,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,57241,10,57242,1,44795,1,42715,12,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,53082,1,57241,10,53114,1,42715,12,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,46875,1,57241,10,53082,1,42715,2,44795,7,42747,2,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,53114,1,57241,10,44795,1,42715,1,44795,7,42747,2,42715,2,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,57241,10,55194,1,42747,1,42715,1,44795,7,42747,2,42715,2,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,53082,1,57241,10,53082,1,42715,2,44795,7,42747,1,42715,2,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,6,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,53082,1,57241,6,51033,1,48985,1,44795,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,55162,1,57241,6,48985,2,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,51033,1,48985,1,55193,1,57241,1,53113,1,48985,1,46906,1,42715,1,44795,1,57241,6,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,61403,1,61436,1,61371,1,59290,8,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,6,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,3,61371,1,61436,2,59291,1,59290,7,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,53082,1,57241,6,51033,1,48985,1,44795,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,6,61371,1,61436,1,61403,1,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,55162,1,57241,6,48985,2,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,61403,1,61436,1,61371,1,59290,8,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,46906,1,42715,1,44795,1,57241,6,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,6,59291,2,59290,9,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,53081,1,51033,1,55161,1,57241,1,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,4,59291,2,59290,8,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,53082,1,57241,1,55193,1,51033,1,53081,1,57241,2,51033,1,48985,1,44795,1,42715,1,46875,1,57241,15,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,7,59291,2,59290,8,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,55162,1,57241,1,53113,1,51033,1,53113,1,57241,2,48985,2,44795,1,42715,1,53082,1,57241,14,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,4,59291,2,59290,9,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,46906,1,42715,1,44795,1,57241,2,51033,2,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,15,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,2,53113,1,48985,1,53113,1,57241,2,48985,2,57241,2,46875,1,42715,1,46875,1,59290,17,48923,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,14,53114,1,42715,1,42747,1,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,53083,1,59290,14,57211,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,46875,1,57241,15,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,17,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,55162,1,57241,1,53113,1,48985,1,53081,1,57241,2,48985,2,44795,1,42715,1,53082,1,57241,14,55162,1,42715,2,48953,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,15,46843,1,42715,1,46906,1,48985,1,53081,1,57241,2,48985,2,55193,1,57241,1,53113,1,48985,1,46906,1,42715,1,44795,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,15,46875,1,42715,1,44795,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,1,55096,1,48985,2,57241,3,55193,1,57241,3,55193,2,57241,2,46875,1,42715,1,46875,1,59290,17,48923,1,42715,1,46875,1,55193,1,57241,4,55193,1,57241,3,55193,1,51034,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,1,53113,1,51033,1,55193,1,57241,1,55193,1,53081,1,53113,1,57241,2,53113,1,51033,1,55193,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,3,55193,1,57241,7,46843,1,42715,1,53083,1,59290,14,57211,1,42715,2,53114,1,55193,1,57241,3,55193,1,57241,4,55193,1,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,46875,1,57241,2,51033,1,53081,1,57241,2,53113,1,51033,1,55193,1,57241,1,55193,1,53081,1,53113,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,55193,2,57241,3,55193,1,57241,2,53082,1,42715,1,46843,1,59290,17,55131,1,42715,1,44795,1,55193,2,57241,3,55193,1,57241,3,55193,1,55161,1,42747,1,42715,1,55162,1,57241,1,53113,1,48985,1,53081,1,57241,2,48985,2,44795,1,42715,1,53082,1,57241,2,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,53113,1,51033,1,53113,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,2,55193,1,57241,4,55193,1,57241,2,46875,1,42715,1,48923,1,59290,15,46843,1,42715,1,51034,1,55193,1,57241,4,55193,1,57241,3,55193,1,51034,1,42715,1,44795,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,53113,1,51033,1,55193,1,57241,2,51033,1,53113,1,57241,2,53081,1,51033,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,3,55193,1,57241,3,55193,1,57241,2,55096,1,48985,2,57241,11,46875,1,42715,1,46875,1,59290,17,48923,1,42715,1,46875,1,57241,10,53082,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,48953,1,42715,1,42747,1,57242,1,57241,1,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,55161,1,57241,1,53114,1,42715,1,42747,1,48985,1,51033,1,57241,11,46843,1,42715,1,53083,1,59290,14,57211,1,42715,2,55162,1,57241,10,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,44795,1,42715,1,46875,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,10,53082,1,42715,1,46843,1,59290,17,55131,1,42715,1,44795,1,57241,10,57242,1,42747,1,42715,1,55162,1,57241,1,53113,1,48985,1,53081,1,57241,2,48985,2,44795,1,42715,1,53082,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,55162,1,42715,2,48953,1,48985,1,55161,1,57241,10,46875,1,42715,1,48923,1,59290,15,46843,1,42715,1,53082,1,57241,10,53114,1,42715,1,44795,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,46874,1,42715,1,44795,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,10,55096,1,44795,2,55194,1,57241,1,51034,1,48923,1,51034,1,57241,1,55194,1,48923,2,55194,1,57241,1,46875,1,42715,1,46875,1,59290,4,42709,8,44790,1,59290,4,48923,1,42715,1,44795,1,48923,1,51003,1,57241,1,57242,1,48955,1,48923,1,55194,1,57241,1,51034,1,48923,1,46875,1,42715,1,44795,1,57241,2,55193,1,55161,1,46870,1,40660,2,38580,1,36532,1,34453,1,36501,1,40660,2,44793,1,44794,1,53114,1,57241,1,53114,1,44795,1,46874,1,57241,2,48922,1,44795,1,53114,1,57241,1,51032,1,36501,2,38580,2,40660,4,53080,1,57241,2,53113,2,57241,2,46843,1,42715,1,53083,1,59290,14,55129,1,36501,1,34453,1,40629,1,40660,5,44789,1,57241,2,53113,2,44795,1,42715,1,53082,1,57241,1,51032,1,38580,2,40660,2,38580,2,36501,1,34453,1,42710,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,53113,2,57241,2,53113,2,57241,2,53082,1,42715,1,46843,1,59290,4,48919,1,42709,8,55161,1,59290,3,55131,1,42715,1,44795,1,53113,2,57241,2,55161,1,53113,1,55161,1,57241,2,53113,1,53081,1,42715,2,55162,1,57241,1,55193,1,55161,1,51032,1,40660,2,38580,2,36501,1,34453,1,38581,1,40660,1,42742,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,53113,1,36501,1,34453,1,36532,1,38580,1,40660,4,44789,1,57241,2,53113,2,57241,2,46875,1,42715,1,48923,1,59290,15,40630,1,34453,1,38581,1,40660,6,55160,1,57241,1,51034,1,48923,1,46875,1,42715,1,44795,1,57241,2,40661,1,38580,1,40660,2,38580,2,36500,1,34453,1,40630,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,4,46870,1,40660,5,38515,1,42715,2,55162,1,57241,1,46875,1,42715,1,46875,1,57241,1,55162,1,42715,2,55162,1,57241,1,46875,1,42715,1,46875,1,59290,4,34418,1,32337,7,36499,1,59290,4,48923,1,42715,3,44795,1,57241,1,57242,1,44795,1,42715,1,55162,1,57241,1,46875,1,42715,3,44795,1,57241,4,40660,1,32337,1,30289,5,32337,2,40633,1,42715,1,53082,1,57241,1,53082,1,42715,1,44795,1,57241,2,46843,1,42715,1,53082,1,57241,1,50999,1,32337,1,30289,3,32337,4,48951,1,57241,1,55193,1,51033,2,57241,2,46843,1,42715,1,53083,1,59290,14,55129,1,32338,1,30289,2,32337,5,36499,1,57241,2,51033,1,48985,1,44795,1,42715,1,53082,1,57241,1,48951,1,32338,1,30289,1,32337,2,30289,4,38580,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,55193,1,48985,1,51033,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,46843,1,59290,4,40661,1,32337,8,53081,1,59290,3,55131,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,55162,1,57241,3,48951,1,32370,1,30289,6,32337,1,36532,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,53113,1,48985,1,53081,1,57241,1,53080,1,32338,1,30289,4,32337,3,36499,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,48923,1,59290,15,36499,1,30289,2,32337,6,53080,1,57241,1,48923,1,42715,3,44795,1,57241,2,34418,1,30289,1,32337,2,30289,4,36499,1,57241,2,51033,1,48985,1,55161,1,57241,1,55193,1,48985,1,51033,1,57241,2,51033,1,48985,1,57241,2,46875,1,42715,1,44795,1,48985,1,51033,1,57241,4,40660,1,32337,5,30224,1,42715,2,55162,1,57241,1,46875,1,42715,1,46875,1,57241,1,55162,1,42715,2,55162,1,57241,1,46875,1,42715,1,44794,1,53080,3,51000,1,34450,1,32401,7,36531,1,53080,4,46842,1,42715,3,44795,1,57241,1,57242,1,44795,1,42715,1,55162,1,57241,1,46875,1,42715,3,44795,1,51031,4,38612,1,32401,8,38583,1,38585,1,46872,1,51031,1,48953,1,46875,1,48955,1,57241,2,44793,1,38585,1,46872,1,51031,1,44822,1,32401,8,44821,1,51031,1,48951,1,44823,1,46903,1,57241,2,46843,1,42715,1,53083,1,59290,10,55129,1,53080,3,48919,1,32402,1,32401,7,36531,1,51031,2,44823,2,40665,1,38585,1,46872,1,51031,1,44822,1,32402,1,32401,7,38611,1,51031,1,50999,1,44823,2,57241,2,53113,1,51033,1,55193,1,57241,2,53081,1,53113,1,57241,2,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,44795,1,53080,4,38612,1,32401,8,48919,1,53048,1,53080,2,48921,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,48952,1,51031,3,44822,1,32402,1,32401,7,36531,1,44823,1,46871,1,51031,2,51033,2,57241,2,48952,1,44823,1,46871,1,51031,1,46902,1,32402,1,32401,7,36531,1,51031,2,44823,2,55161,1,57241,1,46875,1,42715,1,48923,1,59290,11,53080,4,36531,1,32401,8,46870,1,51031,1,44792,1,38585,3,40665,1,51031,1,50999,1,34450,1,32401,7,36531,1,51031,2,46871,1,44823,1,53113,1,57241,2,51033,1,53113,1,57241,2,53113,1,51033,1,57241,2,46875,1,42715,1,44795,1,48985,2,51031,4,38612,1,32401,5,30256,1,42715,2,55162,1,57241,1,46875,1,42715,1,46875,1,57241,1,55162,1,42715,2,55162,1,57241,1,46875,1,42715,1,38584,1,32337,3,32369,1,34578,1,34610,7,34578,1,32337,4,38584,1,42715,3,44795,1,57241,1,57242,1,44795,1,42715,1,55162,1,57241,1,46875,1,42715,3,40634,1,32338,1,32337,3,34546,1,34610,8,32402,1,30289,2,32337,1,40660,1,57241,4,38579,1,32337,1,30289,1,32337,1,32402,1,34610,8,32434,1,32337,1,30289,2,36499,1,57241,2,46843,1,42715,1,53083,1,59290,10,40660,1,32370,1,32337,2,32402,1,34610,8,34578,1,32337,2,30289,5,32337,1,32402,1,34610,8,34546,1,32337,2,30289,1,32370,1,55161,1,57241,10,46843,1,42715,1,46874,1,48985,1,53113,1,57241,2,48985,1,51033,1,57241,2,51033,1,48985,1,55193,1,57241,1,53082,1,42715,1,40634,1,32338,1,32337,3,34546,1,34610,8,32402,1,32337,3,34453,1,42715,1,44795,1,48985,2,55193,1,57241,1,53113,1,48985,1,53113,1,57241,2,48985,1,48953,1,42715,2,34419,1,32337,3,32402,1,34610,8,34546,1,30289,2,32337,1,32370,1,55193,1,57241,3,40660,1,32338,1,30289,1,32337,1,32402,1,34610,8,34578,1,32337,2,30289,2,53080,1,57241,1,46875,1,42715,1,48923,1,59290,10,55129,1,32370,1,32337,3,34578,1,34610,8,32402,1,32337,1,30289,5,32337,1,32369,1,34578,1,34610,7,34578,1,32337,2,30289,2,48951,1,57241,10,46875,1,42715,1,44795,1,48985,1,46871,1,32338,1,32337,3,34546,1,34610,5,32465,1,42715,2,55162,1,57241,1,48955,1,44795,1,48955,1,57241,1,55162,1,44795,2,51033,1,53112,1,44793,1,40634,1,38583,1,32369,3,32401,1,34578,1,34610,7,34578,1,32369,4,36535,1,40634,3,42746,1,57241,1,57242,1,46875,1,44795,1,51033,1,53112,1,44793,1,40634,3,38584,1,30289,2,32369,2,34546,1,34610,8,32402,1,32369,3,38612,1,53080,1,53112,3,36531,1,32369,3,32434,1,34610,8,32434,1,32369,3,36531,1,53080,1,53112,1,42745,1,40634,1,51002,1,57211,2,59290,2,55129,6,38580,1,30289,1,30321,1,32369,1,32401,1,34610,8,34578,1,32369,4,30289,4,32401,1,34610,8,34546,1,32369,3,32402,1,51031,1,53112,3,57241,2,57242,1,55162,1,55161,1,53112,2,42745,1,40634,1,46873,1,48985,1,53113,1,57241,2,51033,2,57241,2,53113,1,51033,1,53112,2,48953,1,40634,1,38584,1,32370,1,32369,3,34546,1,34610,8,32402,1,32369,3,34452,1,40634,1,42713,1,46872,2,55161,1,57241,1,53113,1,51033,2,53112,1,53080,1,46872,2,40666,1,40634,1,32371,1,30289,1,32369,2,32434,1,34610,8,34546,1,32369,3,32402,1,51031,1,53112,3,38612,1,32369,3,32401,1,34610,8,34578,1,32369,4,48951,1,53112,1,44793,1,40634,1,44794,1,57211,2,59290,2,57209,1,55129,5,51000,1,30289,2,32369,2,34578,1,34610,8,32402,1,32369,4,30289,3,30321,1,34578,1,34610,7,34578,1,32369,4,46870,1,53112,3,55160,1,57241,4,55160,1,53112,1,44793,1,40634,1,42713,1,46872,1,42742,1,30289,2,32369,2,34546,1,34610,5,32465,1,42715,2,55162,1,57241,8,36499,1,32337,1,30289,2,32402,1,34610,17,32402,1,30289,3,36499,1,57241,4,36531,1,32337,2,30289,6,34546,1,34610,14,34546,1,32337,4,34546,1,34610,16,34578,1,32337,2,30289,2,38584,1,42715,1,48923,1,59290,1,55129,1,32370,1,32337,5,30289,2,32401,1,34610,15,32401,1,30289,3,32401,1,34610,13,32369,1,32337,3,48951,1,57241,1,53082,1,42715,1,40634,1,32338,1,32337,1,30289,2,42742,1,48985,1,53113,1,57241,8,40660,1,32370,1,32337,1,30289,1,32370,1,34610,17,34546,1,30289,4,51032,1,57241,3,50999,1,32370,1,32337,1,30289,6,34546,1,34610,15,32369,1,32337,3,34546,1,34610,17,32402,1,32337,2,30289,1,34421,1,42715,1,46843,1,59290,2,38579,1,32337,6,30289,1,30321,1,34578,1,34610,14,34546,1,30289,3,30321,1,34578,1,34610,12,32434,1,32337,3,36499,1,57241,2,51033,1,48985,1,36499,1,32337,2,30289,6,34546,1,34610,7,32465,1,42715,2,55162,1,57241,8,36499,1,30289,3,32401,1,34610,17,32402,1,30289,3,36499,1,57241,4,36499,1,30289,8,34546,1,34610,14,34546,1,30289,4,34546,1,34610,16,34578,1,30289,4,38584,1,42715,1,46875,1,59290,1,55129,1,32337,1,30289,7,32401,1,34610,15,32401,1,30289,3,32401,1,34610,13,30321,1,30289,3,48951,1,57241,1,53082,1,42715,1,40633,1,30289,4,42742,1,48985,1,53113,1,57241,8,40660,1,32337,1,30289,2,32369,1,34610,17,34546,1,30289,4,51032,1,57241,3,50999,1,30289,8,34546,1,34610,15,30321,1,30289,3,34546,1,34610,17,32401,1,30289,3,34420,1,42715,1,46843,1,59290,2,38547,1,30289,7,30321,1,34578,1,34610,14,34546,1,30289,3,30321,1,34578,1,34610,12,32402,1,30289,3,36499,1,57241,2,51033,1,48985,1,34451,1,30289,8,34546,1,34610,7,32465,1,34420,2,36532,1,38579,3,44789,1,57241,1,53112,1,38579,2,34546,4,34578,1,34610,17,32402,1,30289,3,32370,1,38579,4,34546,9,32434,1,32401,3,32434,1,34610,10,34578,1,34546,4,32434,1,32401,1,34546,1,34610,6,32401,9,34546,4,34483,1,34420,1,34452,1,38580,1,38579,1,34546,8,32466,1,32401,4,34578,1,34610,10,34578,1,34546,3,32466,1,32401,1,32433,1,34610,8,34578,1,32401,2,30289,4,36499,1,38579,1,36500,1,34420,1,34451,1,34546,4,34483,1,36499,2,38579,3,38580,1,57241,2,42709,1,38579,1,36562,1,34546,3,34578,1,34610,17,34578,1,34546,4,36531,1,38579,3,36563,1,34546,8,32434,1,32401,3,32433,1,34610,11,34546,4,32434,1,32401,1,32434,1,34610,6,32466,1,32401,8,34546,4,34514,1,34420,2,38580,2,34546,9,32401,4,34546,1,34610,10,34578,1,34546,4,32401,2,34578,1,34610,8,32434,1,32401,1,30321,1,30289,3,32370,1,38579,2,36499,2,34546,9,32434,1,32401,3,32434,1,34610,3,32465,1,30289,6,40660,1,57241,1,53080,1,30289,2,34546,1,34610,21,32402,1,30289,8,34578,1,34610,8,32401,1,30289,3,32401,1,34610,15,32401,1,30289,1,34546,1,34610,6,30321,1,30289,7,32369,1,34610,4,32402,1,30289,3,32369,1,34610,8,34546,1,30289,4,34546,1,34610,14,34546,1,30289,1,32369,1,34610,8,34578,1,30289,10,32369,1,34610,4,32402,1,30289,5,32370,1,55161,1,57241,1,36499,1,30289,1,34546,1,34610,26,32401,1,30289,3,32401,1,34610,8,32402,1,30289,3,32369,1,34610,15,32402,1,30289,1,32401,1,34610,6,32402,1,30289,8,34578,1,34610,3,34546,1,30289,4,34546,1,34610,8,30321,1,30289,3,34546,1,34610,15,30321,1,30289,1,34578,1,34610,8,32401,1,30289,10,34578,1,34610,8,32401,1,30289,3,32401,1,34610,3
 ];
 
-const sky_img = Array(210).fill().map(x => Array(320).fill(0));
-const canvas_buffer = Array(RESOLUTION_Y).fill().map(x => Array(RESOLUTION_X).fill(0));
+const sky_img = Array(210).fill().map(x => new Uint16Array(320));
+
+// Every glyph at every scale and its outline, built by initialize_font.
+// Bit i of row y is the pixel i, y from the top left of a one pixel
+// border, so the glyph itself starts at 1, 1
+const glyph_masks = Array(FONT_MAX_SCALE).fill().map((x, i) =>
+    Array(NUM_FONT_GLYPHS).fill().map(x => ({
+        fill: new Uint32Array(FONT_CHAR_HEIGHT * (i + 1) + 2),
+        outline: new Uint32Array(FONT_CHAR_HEIGHT * (i + 1) + 2)
+    }))
+);
+
+// Every tilt of every wing position, rendered once at startup. Pixel
+// i of a frame is part of the bird when opaque[i] is set
+const bird_frames = Array(NUM_WING_FRAMES).fill().map(x =>
+    Array(NUM_BIRD_ANGLES).fill().map(x => ({
+        pixels: new Uint16Array(BIRD_CANVAS_SIZE * BIRD_CANVAS_SIZE),
+        opaque: new Uint8Array(BIRD_CANVAS_SIZE * BIRD_CANVAS_SIZE)
+    }))
+);
+
+// Pixels from the bird's position covered by any cached frame or the
+// collision box, set by initialize_bird_frames
+let bird_hull_left = 0;
+let bird_hull_right = BIRD_WIDTH - 1;
+let bird_hull_top = 0;
+let bird_hull_bottom = BIRD_HEIGHT - 1;
+
+// Shaded pipe assets, built by initialize_pipe_sprites
+const pipe_head_sprite = new Uint16Array((PIPE_HEAD_HEIGHT + 1) * PIPE_HEAD_WIDTH);
+const pipe_body_slice = new Uint16Array(PIPE_BODY_WIDTH);
+
+// The grass band at scroll offset 0, GRASS_STRIP_WIDTH pixels wide
+const grass_strip = new Uint16Array(GRASS_STRIP_HEIGHT * GRASS_STRIP_WIDTH);
+
+// Counts frames shown, drives the wing animation
+let animation_tick = 0;
+
+// Everything is drawn into this RGB565 framebuffer, laid out like the
+// VGA pixel buffer on the board minus the row padding. The page turns
+// it into canvas pixels once per frame with convert_frame
+const frame_buffer = new Uint16Array(RESOLUTION_X * RESOLUTION_Y);
+
+// RGB565 to RGBA, as the little endian 32 bit word ImageData stores
+const rgb565_to_rgba = new Uint32Array(1 << 16);
+
+for (let color = 0; color < (1 << 16); color++) {
+    const r5 = (color & (0b11111 << 11)) >> 11;
+    const g6 = (color & (0b111111 << 5)) >> 5;
+    const b5 = color & 0b11111;
+
+    // https://stackoverflow.com/questions/2442576/how-does-one-convert-16-bit-rgb565-to-24-bit-rgb888
+    const r = ( r5 * 527 + 23 ) >> 6;
+    const g = ( g6 * 259 + 33 ) >> 6;
+    const b = ( b5 * 527 + 23 ) >> 6;
+
+    rgb565_to_rgba[color] = ((0xFF << 24) | (b << 16) | (g << 8) | r) >>> 0;
+}
 
 const game = {
-    grasses: Array(NUM_GRASS_SQUARE).fill().map(x => ({})),
     pipes: Array(NUM_PIPES).fill().map(x => ({})),
     bird: {},
     mode: 0,
     score: 0,
     best_score: 0,
-    frame_count: 0
+
+    // How far the grass has scrolled, modulo GRASS_PERIOD
+    grass_offset: 0,
+
+    // State of the generator pipe heights come from
+    seed: 0
 }
 
 async function main() {
@@ -237,36 +384,35 @@ function initialize_game(game) {
     game.mode = MODE_MENU;
     game.score = 0;
     game.best_score = 0;
-    game.frame_count = 0;
+    game.seed = rand();
 
-    initialize_pipes(game.pipes);
-    initialize_grasses(game.grasses);
+    initialize_pipes(game);
+    initialize_grasses(game);
     initialize_bird(game.bird);
     initialize_sky();
+    initialize_bird_frames();
+    initialize_font();
+    initialize_grass_strip();
+    initialize_pipe_sprites();
 }
 
-function initialize_pipe(pipe, i) {
+function initialize_pipe(game, i) {
+    const pipe = game.pipes[i];
+
     pipe.x = i * PIPE_SPACING + PIPE_START_X;
-    pipe.y = rand() % (RESOLUTION_Y - PIPE_VOID_HEIGHT * 2 - TOTAL_FLOOR_HEIGHT) + PIPE_VOID_HEIGHT;
+    pipe.y = random_pipe_y(game);
     pipe.width = PIPE_WIDTH;
     pipe.void_height = PIPE_VOID_HEIGHT;
     pipe.did_score_update = false;
 }
 
-function initialize_grass(grass, i) {
-    grass.right_x = i * GRASS_SQUARE_WIDTH;  
-    grass.left_x = grass.right_x - GRASS_SQUARE_WIDTH;
-}
-
-function initialize_grasses(grasses) {
-    for (let i = 0; i < NUM_GRASS_SQUARE; i++) {
-        initialize_grass(grasses[i], i);
-    }
+function initialize_grasses(game) {
+    game.grass_offset = 0;
 }
 
-function initialize_pipes(pipes) {
+function initialize_pipes(game) {
     for (let i = 0; i < NUM_PIPES; i++) {
-        initialize_pipe(pipes[i], i);
+        initialize_pipe(game, i);
     }
 }
 
@@ -274,6 +420,7 @@ function initialize_bird(bird) {
     bird.x = BIRD_INITIAL_X;
     bird.y = BIRD_INITIAL_Y;
     bird.y_velocity = BIRD_INITIAL_VELOCITY;
+    bird.wing_tick = 0;
 }
 
 function initialize_screen(game) {
@@ -282,6 +429,218 @@ function initialize_screen(game) {
     draw_background(game);
 }
 
+/**
+ * Renders the grass at scroll offset 0 into grass_strip. It is drawn on
+ * the framebuffer before anything else and its rows are copied out. The
+ * pattern repeats every GRASS_PERIOD pixels, so the columns past the
+ * screen are copies of the last period on it.
+*/
+function initialize_grass_strip() {
+    const grass_top = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT;
+    const grass_bottom = RESOLUTION_Y - GROUND_THICKNESS;
+
+    // The first square starts one square left of the screen so its
+    // slanted rows still cover the left edge
+    const first_x = -GRASS_SQUARE_WIDTH;
+
+    draw_rect(0, GRASS_STRIP_TOP, RESOLUTION_X - 1, GRASS_STRIP_TOP + GRASS_STRIP_HEIGHT - 1, BLACK);
+
+    // Draw grass blocks
+    for (let left_x = first_x, i = 0; left_x <= RESOLUTION_X; left_x += GRASS_SQUARE_WIDTH, i++){
+        const grass_color = i % 2 == 0 ? LIGHT_GREEN : DARK_GREEN;
+
+        draw_slanted_rect(
+            left_x,
+            grass_top,
+            left_x + GRASS_SQUARE_WIDTH,
+            grass_bottom,
+            grass_color
+        );
+    }
+
+    // Draw grass block outlines
+    for (let left_x = first_x; left_x <= RESOLUTION_X; left_x += GRASS_SQUARE_WIDTH){
+        draw_slanted_rect_outline(
+            left_x,
+            grass_top - 1,
+            left_x + GRASS_SQUARE_WIDTH,
+            grass_bottom + 1,
+            BLACK
+        );
+    }
+
+    for (let row = 0; row < GRASS_STRIP_HEIGHT; row++) {
+        const screen_row = (GRASS_STRIP_TOP + row) * RESOLUTION_X;
+        const strip_row = row * GRASS_STRIP_WIDTH;
+
+        grass_strip.set(frame_buffer.subarray(screen_row, screen_row + RESOLUTION_X), strip_row);
+        grass_strip.copyWithin(strip_row + RESOLUTION_X, strip_row + RESOLUTION_X - GRASS_PERIOD, strip_row + RESOLUTION_X);
+    }
+}
+
+/**
+ * Builds the shaded pipe head and body slice from PIPE_COLOR, with a
+ * black column on each side and a black row above and below the head
+*/
+function initialize_pipe_sprites() {
+    for (let y = 0; y <= PIPE_HEAD_HEIGHT; y++) {
+        for (let i = 0; i < PIPE_HEAD_WIDTH; i++) {
+            const edge = y == 0 || y == PIPE_HEAD_HEIGHT || i == 0 || i == PIPE_HEAD_WIDTH - 1;
+
+            pipe_head_sprite[y * PIPE_HEAD_WIDTH + i] = edge ? BLACK : pipe_shade(i - 1, PIPE_HEAD_WIDTH - 2);
+        }
+    }
+
+    for (let i = 0; i < PIPE_BODY_WIDTH; i++) {
+        const edge = i == 0 || i == PIPE_BODY_WIDTH - 1;
+
+        pipe_body_slice[i] = edge ? BLACK : pipe_shade(i - 1, PIPE_BODY_WIDTH - 2);
+    }
+}
+
+/**
+ * Renders the bird at every tilt and wing position into bird_frames.
+ * Each canvas pixel takes the sprite pixel its centre lands on when
+ * rotated back about the sprite's centre, in half pixel fixed point.
+*/
+function initialize_bird_frames() {
+    // The upright sprite, column i is BIRD_MASK_LEFT + i
+    const sprite = new Uint16Array(BIRD_HEIGHT * BIRD_WIDTH);
+    const sprite_opaque = new Uint8Array(BIRD_HEIGHT * BIRD_WIDTH);
+
+    for (const [x0, y0, x1, y1, color] of bird_sprite) {
+        for (let y = y0; y <= y1; y++) {
+            for (let x = x0; x <= x1; x++) {
+                sprite[y * BIRD_WIDTH + x - BIRD_MASK_LEFT] = color;
+                sprite_opaque[y * BIRD_WIDTH + x - BIRD_MASK_LEFT] = 1;
+            }
+        }
+    }
+
+    // The wing is every opaque pixel on the underlay's rows that is
+    // either under it or sticks out left of the body
+    const wing_area = new Uint8Array(BIRD_HEIGHT * BIRD_WIDTH);
+    const body_left = bird_wing_underlay[0][0] - BIRD_MASK_LEFT;
+
+    for (const [x0, y0, x1, y1] of bird_wing_underlay) {
+        for (let y = y0; y <= y1; y++) {
+            for (let x = 0; x < body_left; x++) wing_area[y * BIRD_WIDTH + x] = 1;
+            for (let x = x0; x <= x1; x++) wing_area[y * BIRD_WIDTH + x - BIRD_MASK_LEFT] = 1;
+        }
+    }
+
+    for (let frame = 0; frame < NUM_WING_FRAMES; frame++) {
+        const pixels = sprite.slice();
+        const opaque = sprite_opaque.slice();
+        const wing_dy = (frame - 1) * WING_FLAP_DY;
+
+        // Lift the wing off and fill the body in under it
+        for (let i = 0; i < opaque.length; i++) {
+            if (wing_area[i]) opaque[i] = 0;
+        }
+
+        for (const [x0, y0, x1, y1, color] of bird_wing_underlay) {
+            for (let y = y0; y <= y1; y++) {
+                for (let x = x0; x <= x1; x++) {
+                    pixels[y * BIRD_WIDTH + x - BIRD_MASK_LEFT] = color;
+                    opaque[y * BIRD_WIDTH + x - BIRD_MASK_LEFT] = 1;
+                }
+            }
+        }
+
+        // Put the wing back wing_dy rows lower
+        for (let y = 0; y < BIRD_HEIGHT; y++) {
+            const to_y = y + wing_dy;
+
+            if (is_out_of_bounds(to_y, 0, BIRD_HEIGHT - 1)) continue;
+
+            for (let x = 0; x < BIRD_WIDTH; x++) {
+                const i = y * BIRD_WIDTH + x;
+
+                if (!(sprite_opaque[i] && wing_area[i])) continue;
+
+                pixels[to_y * BIRD_WIDTH + x] = sprite[i];
+                opaque[to_y * BIRD_WIDTH + x] = 1;
+            }
+        }
+
+        for (let angle = 0; angle < NUM_BIRD_ANGLES; angle++) {
+            const out = bird_frames[frame][angle];
+            const c = bird_angle_cos[angle];
+            const s = bird_angle_sin[angle];
+
+            for (let cy = 0; cy < BIRD_CANVAS_SIZE; cy++) {
+                for (let cx = 0; cx < BIRD_CANVAS_SIZE; cx++) {
+                    // Twice the offset of the pixel centre from the
+                    // canvas centre, rotated back onto the sprite
+                    const dx = 2 * cx + 1 - BIRD_CANVAS_SIZE;
+                    const dy = 2 * cy + 1 - BIRD_CANVAS_SIZE;
+                    const sx = (c * dx + s * dy + 128) >> 8;
+                    const sy = (-s * dx + c * dy + 128) >> 8;
+                    const x = (sx + BIRD_WIDTH) >> 1;
+                    const y = (sy + BIRD_HEIGHT) >> 1;
+                    const i = cy * BIRD_CANVAS_SIZE + cx;
+
+                    out.pixels[i] = BLACK;
+                    out.opaque[i] = 0;
+                    if (is_out_of_bounds(x, 0, BIRD_WIDTH - 1)) continue;
+                    if (is_out_of_bounds(y, 0, BIRD_HEIGHT - 1)) continue;
+                    if (!opaque[y * BIRD_WIDTH + x]) continue;
+
+                    out.pixels[i] = pixels[y * BIRD_WIDTH + x];
+                    out.opaque[i] = 1;
+
+                    bird_hull_left = Math.min(bird_hull_left, BIRD_CANVAS_LEFT + cx);
+                    bird_hull_right = Math.max(bird_hull_right, BIRD_CANVAS_LEFT + cx);
+                    bird_hull_top = Math.min(bird_hull_top, BIRD_CANVAS_TOP + cy);
+                    bird_hull_bottom = Math.max(bird_hull_bottom, BIRD_CANVAS_TOP + cy);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Builds glyph_masks: every glyph at every scale, and its outline
+*/
+function initialize_font() {
+    for (let scale = 1; scale <= FONT_MAX_SCALE; scale++) {
+        for (let glyph = 0; glyph < NUM_FONT_GLYPHS; glyph++) {
+            const mask = glyph_masks[scale - 1][glyph];
+            const height = FONT_CHAR_HEIGHT * scale + 2;
+
+            mask.fill.fill(0);
+
+            // Each font pixel becomes a scale x scale block
+            for (let y = 0; y < FONT_CHAR_HEIGHT; y++) {
+                let row = 0;
+
+                for (let x = 0; x < FONT_CHAR_WIDTH; x++) {
+                    if (font_glyphs[glyph][y] & (1 << (FONT_CHAR_WIDTH - 1 - x))) {
+                        row |= ((1 << scale) - 1) << (1 + x * scale);
+                    }
+                }
+
+                for (let i = 0; i < scale; i++) {
+                    mask.fill[1 + y * scale + i] = row;
+                }
+            }
+
+            // Grow the glyph by a pixel in every direction and keep
+            // what was added
+            for (let y = 0; y < height; y++) {
+                let grown = mask.fill[y];
+
+                if (y > 0) grown |= mask.fill[y - 1];
+                if (y < height - 1) grown |= mask.fill[y + 1];
+
+                grown |= (grown << 1) | (grown >>> 1);
+                mask.outline[y] = grown & ~mask.fill[y];
+            }
+        }
+    }
+}
+
 
 // Graphics
 function is_out_of_bounds(x, min, max) {
@@ -305,10 +664,32 @@ function is_offscreen(x, y) {
     return false;
 }
 
-// No bounds checking
 function draw_pixel(x, y, color) {
-    change_color(color);
-    fill_rect(x, y, x, y);
+    // Don't display pixels outside of the screen
+    if (is_offscreen(x, y)) return;
+
+    frame_buffer[y * RESOLUTION_X + x] = color;
+}
+
+/**
+ * Converts the framebuffer to canvas pixels
+ * @param pixels - Uint32Array view of an ImageData's data
+*/
+function convert_frame(pixels) {
+    for (let i = 0; i < frame_buffer.length; i++) {
+        pixels[i] = rgb565_to_rgba[frame_buffer[i]];
+    }
+}
+
+// FNV-1a hash of the framebuffer, to compare frames when running headless
+function hash_frame() {
+    let hash = 0x811C9DC5;
+
+    for (let i = 0; i < frame_buffer.length; i++) {
+        hash = Math.imul(hash ^ frame_buffer[i], 0x01000193);
+    }
+
+    return hash >>> 0;
 }
 
 /**
@@ -328,8 +709,11 @@ function draw_rect(x0, y0, x1, y1, color) {
     const clamped_y0 = clamp(y0, 0, RESOLUTION_Y - 1);
     const clamped_y1 = clamp(y1, 0, RESOLUTION_Y - 1);
 
-    change_color(color);
-    fill_rect(clamped_x0, clamped_y0, clamped_x1, clamped_y1);
+    for (let y = clamped_y0; y <= clamped_y1; y++) {
+        const row = y * RESOLUTION_X;
+
+        frame_buffer.fill(color, row + clamped_x0, row + clamped_x1 + 1);
+    }
 }
 
 /**
@@ -392,6 +776,98 @@ function draw_slanted_rect_outline(x0, y0, x1, y1, line_color) {
     }
 }
 
+/**
+ * Draws a horizontal line, clipped to the screen
+ * @param x0 - left end
+ * @param x1 - right end (inclusive)
+ * @param y
+ * @param color
+*/
+function draw_hline(x0, x1, y, color) {
+    if (is_out_of_bounds(y, 0, RESOLUTION_Y - 1)) return;
+
+    x0 = clamp(x0, 0, RESOLUTION_X);
+    x1 = clamp(x1, -1, RESOLUTION_X - 1);
+
+    frame_buffer.fill(color, y * RESOLUTION_X + x0, y * RESOLUTION_X + x1 + 1);
+}
+
+/**
+ * Copies rows of pixels to the screen, clipped to it. Row i of src goes
+ * to line y0 + i. With a src_stride of 0 the same row is stamped on
+ * every line, which stretches a one row slice into a column.
+ * @param src - typed array holding the rows
+ * @param src_stride - pixels from one row of src to the next
+ * @param width - pixels per row
+ * @param x - left of the rows on the screen
+ * @param y0 - first line
+ * @param y1 - last line (inclusive)
+*/
+function blit_rows(src, src_stride, width, x, y0, y1) {
+    const x0 = clamp(x, 0, RESOLUTION_X);
+    const x1 = clamp(x + width - 1, -1, RESOLUTION_X - 1);
+    const clipped_y0 = clamp(y0, 0, RESOLUTION_Y);
+    const clipped_y1 = clamp(y1, -1, RESOLUTION_Y - 1);
+
+    if (x0 > x1) return;
+
+    for (let y = clipped_y0; y <= clipped_y1; y++) {
+        const row = (y - y0) * src_stride + (x0 - x);
+
+        frame_buffer.set(src.subarray(row, row + x1 - x0 + 1), y * RESOLUTION_X + x0);
+    }
+}
+
+/**
+ * Moves each RGB565 channel from dst towards src by alpha / 32,
+ * rounding towards dst, exactly like blend_pixel in main.c
+ * @param dst - color underneath
+ * @param src - color on top
+ * @param alpha - 0 to 32
+*/
+function blend_pixel(dst, src, alpha) {
+    const r = (dst >> 11) + ((((src >> 11) - (dst >> 11)) * alpha) >> 5);
+    const g = ((dst >> 5) & 63) + (((((src >> 5) & 63) - ((dst >> 5) & 63)) * alpha) >> 5);
+    const b = (dst & 31) + ((((src & 31) - (dst & 31)) * alpha) >> 5);
+
+    return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Blends a color over a rectangle, clipped like draw_rect
+ * @param x0 - top left corner
+ * @param y0 - top left corner
+ * @param x1 - bottom right corner
+ * @param y1 - bottom right corner
+ * @param color - color on top
+ * @param alpha - 0 to 32
+*/
+function blend_rect(x0, y0, x1, y1, color, alpha) {
+    x0 = clamp(x0, 0, RESOLUTION_X);
+    x1 = clamp(x1, -1, RESOLUTION_X - 1);
+    y0 = clamp(y0, 0, RESOLUTION_Y);
+    y1 = clamp(y1, -1, RESOLUTION_Y - 1);
+
+    for (let y = y0; y <= y1; y++) {
+        for (let i = y * RESOLUTION_X + x0; i <= y * RESOLUTION_X + x1; i++) {
+            frame_buffer[i] = blend_pixel(frame_buffer[i], color, alpha);
+        }
+    }
+}
+
+/**
+ * Color of column i of the inside of a pipe that is width pixels wide:
+ * a highlight a quarter of the way in that fades into shadow on the
+ * right, like the pipes of the original game
+*/
+function pipe_shade(i, width) {
+    const t = (i * 64 / (width - 1)) | 0;
+
+    if (t <= 16) return blend_pixel(PIPE_COLOR, WHITE, 2 + ((t * 6 / 16) | 0));
+    if (t <= 40) return blend_pixel(PIPE_COLOR, WHITE, (8 * (40 - t) / 24) | 0);
+    return blend_pixel(PIPE_COLOR, BLACK, ((t - 40) * 8 / 24) | 0);
+}
+
 function draw_pipe(pipe) {
     const x0 = pipe.x - (pipe.width / 2);
     const x1 = pipe.x + (pipe.width / 2);
@@ -404,15 +880,17 @@ function draw_pipe(pipe) {
     const y_bottom_pipe_edge = pipe.y + (pipe.void_height / 2);
     const y_screen_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
 
-    // Draw top pipe, outline, pipe head outline
-    draw_rect(x0, y_screen_top, x1, y_top_pipe_edge, PIPE_COLOR);
-    draw_rect_outline(x0, y_screen_top - 1, x1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, BLACK);
-    draw_rect_outline(x0 - 1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, x1 + 1, y_top_pipe_edge, BLACK);
-
-    // Draw bottom pipe
-    draw_rect(x0, y_bottom_pipe_edge, x1, y_screen_bottom, PIPE_COLOR);
-    draw_rect_outline(x0, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, x1, y_screen_bottom, BLACK);
-    draw_rect_outline(x0 - 1, y_bottom_pipe_edge, x1 + 1, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, BLACK);
+    // Draw top pipe body stretched down to the head, then the head
+    const y_top_head = y_top_pipe_edge - PIPE_HEAD_HEIGHT;
+    blit_rows(pipe_body_slice, 0, PIPE_BODY_WIDTH, x0, y_screen_top, y_top_head - 1);
+    blit_rows(pipe_head_sprite, PIPE_HEAD_WIDTH, PIPE_HEAD_WIDTH, x0 - 1, y_top_head, y_top_pipe_edge);
+
+    // Draw bottom pipe head, then the body down to the grass with an
+    // outline along the bottom
+    const y_bottom_head = y_bottom_pipe_edge + PIPE_HEAD_HEIGHT;
+    blit_rows(pipe_head_sprite, PIPE_HEAD_WIDTH, PIPE_HEAD_WIDTH, x0 - 1, y_bottom_pipe_edge, y_bottom_head);
+    blit_rows(pipe_body_slice, 0, PIPE_BODY_WIDTH, x0, y_bottom_head + 1, y_screen_bottom - 1);
+    draw_hline(x0, x1, y_screen_bottom, BLACK);
 }
 
 function draw_pipes(pipes) {
@@ -421,99 +899,146 @@ function draw_pipes(pipes) {
     }
 }
 
+// Index into bird_frames of the tilt closest to the bird's velocity
+function bird_angle_index(bird) {
+    const angle = Math.trunc(-bird.y_velocity * BIRD_DEGREES_PER_VELOCITY) - BIRD_MIN_ANGLE;
+    const index = Math.trunc((angle + BIRD_ANGLE_STEP / 2) / BIRD_ANGLE_STEP);
+
+    return clamp(index, 0, NUM_BIRD_ANGLES - 1);
+}
+
+// Index into bird_frames of the wing position for a bird's wing_tick.
+// The wing goes up, level, down, level and around again
+function bird_wing_frame(tick) {
+    const step = ((tick / WING_FRAME_TICKS) | 0) % 4;
+
+    return step == 3 ? 1 : step;
+}
+
 function draw_bird(bird) {
+    const frame = bird_frames[bird_wing_frame(bird.wing_tick)][bird_angle_index(bird)];
+
+    draw_bird_frame(frame, bird.x + BIRD_CANVAS_LEFT, Math.trunc(bird.y) + BIRD_CANVAS_TOP);
+}
+
+/**
+ * Copies the opaque pixels of a bird frame to the screen
+ * @param frame - frame to draw
+ * @param x - left of the canvas
+ * @param y - top of the canvas
+*/
+function draw_bird_frame(frame, x, y) {
+    for (let row = 0; row < BIRD_CANVAS_SIZE; row++) {
+        for (let column = 0; column < BIRD_CANVAS_SIZE; column++) {
+            const i = row * BIRD_CANVAS_SIZE + column;
 
-    //modified based on this to draw bird: https://www.pinterest.com/pin/559924166147577544/
-    draw_rect(bird.x - 2, bird.y + 10, bird.x - 1, bird.y + 13, BLACK);
-    draw_rect(bird.x, bird.y + 8, bird.x + 1, bird.y + 9, BLACK);
-	draw_rect(bird.x, bird.y + 10, bird.x + 1, bird.y + 11, WHITE);
-    draw_rect(bird.x, bird.y + 12, bird.x + 1, bird.y + 13, YELLOW);
-    draw_rect(bird.x, bird.y + 14, bird.x + 1, bird.y + 15, BLACK);
-    draw_rect(bird.x + 10, bird.y, bird.x + 21, bird.y + 1, BLACK);
-    draw_rect(bird.x + 6, bird.y + 2, bird.x + 9, bird.y + 3, BLACK);
-    draw_rect(bird.x + 16, bird.y + 2, bird.x + 17, bird.y + 3, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 2, bird.x + 19, bird.y + 3, BLACK);
-    draw_rect(bird.x + 20, bird.y + 2, bird.x + 21, bird.y + 3, WHITE);
-    draw_rect(bird.x + 22, bird.y + 2, bird.x + 23, bird.y + 3, BLACK); 
-    draw_rect(bird.x + 4, bird.y + 4, bird.x + 5, bird.y + 5, BLACK);
-    draw_rect(bird.x + 6, bird.y + 4, bird.x + 9, bird.y + 5, YELLOW);
-    draw_rect(bird.x + 16, bird.y + 4, bird.x + 17, bird.y + 9, BLACK);
-    draw_rect(bird.x + 22, bird.y + 4, bird.x + 23, bird.y + 5, WHITE);
-    draw_rect(bird.x + 24, bird.y + 4, bird.x + 25, bird.y + 5, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 6, bird.x + 7, bird.y + 7, BLACK);
-    draw_rect(bird.x + 8, bird.y + 6, bird.x + 9, bird.y + 7, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 10, bird.x + 19, bird.y + 11, BLACK);
-    draw_rect(bird.x + 18, bird.y + 4, bird.x + 21, bird.y + 9, WHITE); 
-    draw_rect(bird.x + 22, bird.y + 6, bird.x + 23, bird.y + 9, BLACK);
-    draw_rect(bird.x + 24, bird.y + 6, bird.x + 25, bird.y + 11, WHITE); 
-    draw_rect(bird.x + 26, bird.y + 6, bird.x + 27, bird.y + 11, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 8, bird.x + 7, bird.y + 13, WHITE);
-    draw_rect(bird.x + 8, bird.y + 8, bird.x + 9, bird.y + 9, BLACK);
-    draw_rect(bird.x + 10, bird.y + 2, bird.x + 15, bird.y + 9, YELLOW);
-    draw_rect(bird.x + 20, bird.y + 10, bird.x + 23, bird.y + 11, WHITE); 
-	draw_rect(bird.x + 8, bird.y + 10, bird.x + 9, bird.y + 11, WHITE);
-    draw_rect(bird.x + 8, bird.y + 12, bird.x + 9, bird.y + 13, YELLOW);
-    draw_rect(bird.x + 10, bird.y + 10, bird.x + 11, bird.y + 13, BLACK);
-    draw_rect(bird.x + 12, bird.y + 10, bird.x + 17, bird.y + 15, YELLOW); 
-    draw_rect(bird.x + 18, bird.y + 12, bird.x + 19, bird.y + 13, YELLOW);
-    draw_rect(bird.x + 20, bird.y + 12, bird.x + 29, bird.y + 13, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 14, bird.x + 7, bird.y + 15, YELLOW);
-    draw_rect(bird.x + 8, bird.y + 14, bird.x + 9, bird.y + 15, BLACK);
-    draw_rect(bird.x + 10, bird.y + 14, bird.x + 11, bird.y + 15, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 14, bird.x + 19, bird.y + 15, BLACK);
-    draw_rect(bird.x + 20, bird.y + 14, bird.x + 29, bird.y + 15, ORANGE);
-    draw_rect(bird.x + 30, bird.y + 14, bird.x + 31, bird.y + 15, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 16, bird.x + 7, bird.y + 17, BLACK);
-    draw_rect(bird.x + 8, bird.y + 16, bird.x + 15, bird.y + 19, SAND);
-    draw_rect(bird.x + 16, bird.y + 16, bird.x + 17, bird.y + 17, BLACK);
-    draw_rect(bird.x + 18, bird.y + 16, bird.x + 19, bird.y + 17, ORANGE);
-    draw_rect(bird.x + 20, bird.y + 16, bird.x + 29, bird.y + 17, BLACK); 
-    draw_rect(bird.x + 6, bird.y + 18, bird.x + 7, bird.y + 19, BLACK);
-    draw_rect(bird.x + 16, bird.y + 18, bird.x + 17, bird.y + 19, SAND);
-    draw_rect(bird.x + 18, bird.y + 18, bird.x + 19, bird.y + 19, BLACK);
-    draw_rect(bird.x + 20, bird.y + 18, bird.x + 27, bird.y + 19, ORANGE);
-    draw_rect(bird.x + 28, bird.y + 18, bird.x + 29, bird.y + 19, BLACK); 
-    draw_rect(bird.x + 8, bird.y + 20, bird.x + 11, bird.y + 21, BLACK);
-    draw_rect(bird.x + 12, bird.y + 20, bird.x + 19, bird.y + 21, SAND);
-    draw_rect(bird.x + 20, bird.y + 20, bird.x + 29, bird.y + 21, BLACK);
-    draw_rect(bird.x + 12, bird.y + 22, bird.x + 19, bird.y + 23, BLACK); 
-}
-
-function draw_digit(digit, x_offset, x, y, color) {
-    for (let i = 0; i < SCORE_CHAR_WIDTH; i++) {
-        for (let j = 0; j < SCORE_CHAR_HEIGHT; j++) {
-            const x_start = x + (i + x_offset) * SCORE_CHAR_SCALE;
-            const y_start = y + j * SCORE_CHAR_SCALE;
-            const x_end = x_start + SCORE_CHAR_SCALE;
-            const y_end = y_start + SCORE_CHAR_SCALE;
-
-            if (digits_image[digit][j][i])
-                draw_rect(x_start, y_start, x_end, y_end, color);
+            if (frame.opaque[i]) draw_pixel(x + column, y + row, frame.pixels[i]);
         }
     }
 }
 
-function draw_integer(n, x, y, color) {
-    let x_offset = 0;
+// Index into font_glyphs of a character, -1 when there is no glyph
+function glyph_index(c) {
+    if (c >= "0" && c <= "9") return c.charCodeAt(0) - 48;
+    if (c >= "A" && c <= "Z") return c.charCodeAt(0) - 65 + 10;
+    return -1;
+}
 
-    if (n == 0) return draw_digit(n, x_offset, x, y, color);
+// Width in pixels of text drawn at scale, outline excluded
+function text_width(text, scale) {
+    if (text.length == 0) return 0;
+    return (text.length * (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) - FONT_CHAR_SPACING) * scale;
+}
 
-    while (n > 0) {
-        const digit = n % 10;
+/**
+ * Draws one glyph and its outline from its mask
+ * @param glyph - index into font_glyphs
+ * @param x - left of the glyph, the outline starts a pixel further left
+ * @param y - top of the glyph, the outline starts a pixel higher
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+*/
+function draw_glyph(glyph, x, y, scale, color, outline_color) {
+    const mask = glyph_masks[scale - 1][glyph];
+    const width = FONT_CHAR_WIDTH * scale + 2;
+
+    for (let row = 0; row < mask.fill.length; row++) {
+        for (let bit = 0; bit < width; bit++) {
+            if ((mask.outline[row] >>> bit) & 1) draw_pixel(x - 1 + bit, y - 1 + row, outline_color);
+            if ((mask.fill[row] >>> bit) & 1) draw_pixel(x - 1 + bit, y - 1 + row, color);
+        }
+    }
+}
 
-        draw_digit(digit, x_offset, x, y, color);
+/**
+ * Draws outlined text. Digits, capital letters and spaces are drawn,
+ * anything else leaves a blank
+ * @param text
+ * @param x - left of the first glyph
+ * @param y - top of the glyphs
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+*/
+function draw_text(text, x, y, scale, color, outline_color) {
+    const advance = (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) * scale;
 
-        // Move to the left to render next digit. We have to move left
-        // since we get digits in reverse order so we display digits
-        // from right to left
-        x_offset -= SCORE_CHAR_WIDTH;
+    for (const c of text) {
+        const glyph = glyph_index(c);
 
-        // Move on to next digit
-        n = n / 10;
-        
-        // Cast to integer
-        n = n | 0;
+        if (glyph >= 0) draw_glyph(glyph, x, y, scale, color, outline_color);
+        x += advance;
+    }
+}
+
+/**
+ * Blends outlined text over what is already drawn, like draw_text with
+ * every pixel of the glyphs and their outlines at alpha. Outlines that
+ * neighbouring glyphs share are blended once, like draw_text_faded in
+ * main.c
+ * @param text
+ * @param x - left of the first glyph
+ * @param y - top of the glyphs
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+ * @param alpha - 0 to 32
+*/
+function draw_text_faded(text, x, y, scale, color, outline_color, alpha) {
+    const advance = (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) * scale;
+    const width = FONT_CHAR_WIDTH * scale + 2;
+    const height = FONT_CHAR_HEIGHT * scale + 2;
+    const top = new Map();
+
+    // Outlines first, so fill wins where the outline of a neighbour overlaps it
+    for (let pass = 0; pass < 2; pass++) {
+        let glyph_x = x;
+
+        for (const c of text) {
+            const glyph = glyph_index(c);
+
+            if (glyph >= 0) {
+                const mask = glyph_masks[scale - 1][glyph];
+
+                for (let row = 0; row < height; row++) {
+                    const bits = pass ? mask.fill[row] : mask.outline[row];
+
+                    for (let bit = 0; bit < width; bit++) {
+                        const px = glyph_x - 1 + bit;
+                        const py = y - 1 + row;
+
+                        if (((bits >>> bit) & 1) == 0) continue;
+                        if (px < 0 || px >= RESOLUTION_X || py < 0 || py >= RESOLUTION_Y) continue;
+                        top.set(py * RESOLUTION_X + px, pass ? color : outline_color);
+                    }
+                }
+            }
+            glyph_x += advance;
+        }
     }
+
+    for (const [i, src] of top) frame_buffer[i] = blend_pixel(frame_buffer[i], src, alpha);
 }
 
 /**
@@ -525,53 +1050,57 @@ function draw_integer(n, x, y, color) {
  * @param y
 */
 function draw_score(score, x, y) {
-    // Cheat to get outline on score
-    draw_integer(score, x + 1, y + 1, BLACK);
-    draw_integer(score, x - 1, y - 1, BLACK);
-    draw_integer(score, x + 1, y - 1, BLACK);
-    draw_integer(score, x - 1, y + 1, BLACK);
+    const text = String(score);
 
-    // Draw score
-    draw_integer(score, x, y, WHITE);
+    draw_text(text, x - text_width(text, SCORE_CHAR_SCALE), y, SCORE_CHAR_SCALE, WHITE, BLACK);
 }
 
 async function draw_game(game) {
-    initialize_pipes(game.pipes);
+    clear_read_FIFO();
+    game.seed = rand();
+    initialize_pipes(game);
     initialize_bird(game.bird);
 
-    game.frame_count = 0;
     while (!is_game_over(game)) {
         redraw_background(game);
         draw_pipes(game.pipes);
         draw_bird(game.bird);
         draw_score(game.score, SCORE_POS_X, SCORE_POS_Y);
 
-        do_scroll_view(game);
-        do_bird_jump(game.bird);
-        do_bird_velocity(game.bird);
-        do_update_score(game);
+        const jump = is_jump_key_pressed();
+
+        do_scroll_grasses(game);
+        do_game_step(game, jump);
 
         await next_frame();
-        game.frame_count++;
+        animation_tick++;
     }
 
     game.mode = MODE_GAME_OVER;
 }
 
 async function draw_game_over(game) {
+    let frame = 0;
+
+    clear_read_FIFO();
     do_update_best_score(game);
 
-    game.frame_count = 0;
     while (game.mode == MODE_GAME_OVER) {
         redraw_background(game);
 
-        //get the outline of "GAME OVER"
-        draw_word_game_over(74, 30, BLACK);
-		draw_word_game_over(76, 30, BLACK);
-		draw_word_game_over(75, 29, BLACK);
-		draw_word_game_over(75, 31, BLACK);
+        // Dim the sky behind the panel so the text stands out
+        blend_rect(0, 0, RESOLUTION_X - 1, SKY_THICKNESS - 1, BLACK, GAME_OVER_DIM_ALPHA);
+
         //display "GAME OVER"
-        draw_word_game_over(75, 30, WHITE);
+        const text_for_title = "GAME OVER";
+        const title_x = ((RESOLUTION_X - text_width(text_for_title, TITLE_CHAR_SCALE)) / 2) | 0;
+        const title_alpha = clamp((frame * 32 / GAME_OVER_FADE_FRAMES) | 0, 0, 32);
+
+        if (title_alpha < 32) {
+            draw_text_faded(text_for_title, title_x, 30, TITLE_CHAR_SCALE, WHITE, BLACK, title_alpha);
+        } else {
+            draw_text(text_for_title, title_x, 30, TITLE_CHAR_SCALE, WHITE, BLACK);
+        }
 
         //display "SCORE: "
         //display "BEST: "
@@ -591,8 +1120,8 @@ async function draw_game_over(game) {
         draw_rect_outline(70, 162, RESOLUTION_X - 70, 162 + 22, BLACK);
 
         //sisplay score and best score
-        draw_score(game.score, 200, 67);
-        draw_score(game.best_score, 200, 100);
+        draw_score(game.score, 206, 67);
+        draw_score(game.best_score, 206, 100);
 
         //check whether Enter or Back has pressed
         change_mode(game);
@@ -606,26 +1135,26 @@ async function draw_game_over(game) {
         video_text(25, 43, text_for_menu);
 
         await next_frame();
-        game.frame_count++;
+        animation_tick++;
+        frame++;
     }
 }
 
 
 async function draw_menu(game, bird) {
-    
-    game.frame_count = 0;
+    clear_read_FIFO();
     game.best_score = 0;
     while (game.mode == MODE_MENU) {
         redraw_background(game);
+
+        // The bird stays put on the menu, so only its wing moves
+        bird.wing_tick = animation_tick;
         draw_bird(bird);
 
-        //get the outline of  "FLAPPY BIRD"
-        draw_flappy_bird(85, 45, BLACK);
-        draw_flappy_bird(87, 45, BLACK);
-        draw_flappy_bird(86, 44, BLACK);
-        draw_flappy_bird(86, 46, BLACK);
-         //display "FLAPPY BIRD"
-        draw_flappy_bird(86, 45, WHITE);
+        //display "FLAPPY BIRD"
+        const text_for_title = "FLAPPY BIRD";
+        const title_x = ((RESOLUTION_X - text_width(text_for_title, TITLE_CHAR_SCALE)) / 2) | 0;
+        draw_text(text_for_title, title_x, 45, TITLE_CHAR_SCALE, WHITE, BLACK);
         
         //display "PRESS SPACE TO LET THE BIRD JUMP"
         //display "PRESS ENTER TO START"
@@ -649,55 +1178,32 @@ async function draw_menu(game, bird) {
         video_text(37, 44, text_to_display);
 
         await next_frame();
-        game.frame_count++;
+        animation_tick++;
     }
 }
 
 
+/**
+ * Draws the grass scrolled by grass_offset, one row copy per scanline
+ * out of grass_strip
+ * @param grass_offset - 0 to GRASS_PERIOD - 1
+*/
+function draw_grasses(grass_offset){
+    for (let row = 0; row < GRASS_STRIP_HEIGHT; row++) {
+        const strip_row = row * GRASS_STRIP_WIDTH + grass_offset;
 
-function draw_grasses(grass){
-    const grass_top = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT;
-    const grass_bottom = RESOLUTION_Y - GROUND_THICKNESS;
-
-    // Draw grass blocks
-    for (let i = 0; i < NUM_GRASS_SQUARE; i++){
-        const grass_color = i % 2 == 0 ? LIGHT_GREEN : DARK_GREEN;
-
-        draw_slanted_rect(
-            grass[i].left_x, 
-            grass_top, 
-            grass[i].right_x, 
-            grass_bottom, 
-            grass_color
-        );
-    }
-
-    // Draw grass block outlines    
-    for (let i = 0; i < NUM_GRASS_SQUARE; i++){
-        draw_slanted_rect_outline(
-            grass[i].left_x, 
-            grass_top - 1, 
-            grass[i].right_x, 
-            grass_bottom + 1, 
-            BLACK
+        frame_buffer.set(
+            grass_strip.subarray(strip_row, strip_row + RESOLUTION_X),
+            (GRASS_STRIP_TOP + row) * RESOLUTION_X
         );
     }
 }
 
 
 function draw_sky() {
-    for (let i = 0; i < RESOLUTION_X; i++) {
-        for (let j = 0; j < SKY_THICKNESS; j++) {
-            draw_pixel(i, j, sky_img[j][i]);
-        }
-    }
-}
-
-function draw_sky_rect(x0, y0, x1, y1) {
-    for (let i = x0; i <= x1; i++) {
-        for (let j = y0; j <= y1; j++) {
-            draw_pixel(i, j, sky_img[j][i]);
-        }
+    // Copy whole rows of the sky at a time
+    for (let j = 0; j < SKY_THICKNESS; j++) {
+        frame_buffer.set(sky_img[j], j * RESOLUTION_X);
     }
 }
 
@@ -708,53 +1214,15 @@ function draw_background(game) {
     //draw ground
     draw_rect(0, RESOLUTION_Y - GROUND_THICKNESS + 1, RESOLUTION_X, RESOLUTION_Y, SAND);
     //draw grass
-    draw_grasses(game.grasses);
-}
-
-function draw_sky_partial_mode_game(game) {
-    // Clear column for first pipe
-    draw_sky_rect(0, 0, SCROLL_VIEW_AMOUNT * 3, SKY_THICKNESS - 1);
-
-    // Clear column for bird
-    draw_sky_rect(BIRD_INITIAL_X - 2, 0, BIRD_INITIAL_X + BIRD_WIDTH, SKY_THICKNESS - 1);
-
-    // Clear at each pipe
-    for (let i = 0; i < NUM_PIPES; i++) {
-        const pipe = game.pipes[i];
-        const pipe_x = pipe.x + PIPE_WIDTH / 2;
-
-        // Clear a column at the curr pipe coordinate 
-        draw_sky_rect(pipe_x, 0, pipe_x + SCROLL_VIEW_AMOUNT * 3, SKY_THICKNESS - 1);
-    }
-
-    // Clear out space for score
-    draw_sky_rect(
-        SCORE_POS_X - SCORE_CHAR_WIDTH * SCORE_CHAR_SCALE * 3, 
-        SCORE_POS_Y, 
-        SCORE_POS_X + SCORE_CHAR_WIDTH * SCORE_CHAR_SCALE, 
-        SCORE_POS_Y + SCORE_CHAR_HEIGHT * SCORE_CHAR_SCALE + 1
-    );
-}
-
-function draw_sky_partial_mode_game_over(game) {
-    // Clear score area
-    draw_sky_rect(70, 63, RESOLUTION_X - 70, 63 + 22);
-    draw_sky_rect(70, 97, RESOLUTION_X - 70, 97 + 22);
+    draw_grasses(game.grass_offset);
 }
 
 function redraw_background(game) {
-    // Draw only partial background after doing a full draw first
-    if (game.frame_count < 2) draw_sky();
-    else {
-        switch (game.mode) {
-            case MODE_GAME: draw_sky_partial_mode_game(game); break;
-            case MODE_GAME_OVER: draw_sky_partial_mode_game_over(game); break;
-            case MODE_MENU: draw_sky_partial_mode_game_over(game); break;
-        }
-    }
+    // draw sky
+    draw_sky();
     
     //draw grass
-    draw_grasses(game.grasses);
+    draw_grasses(game.grass_offset);
 }
 
 // Control bird's position
@@ -764,16 +1232,26 @@ function do_bird_velocity(bird) {
 
     //update y velocity
     bird.y_velocity -= BIRD_GRAVITY;
+
+    bird.wing_tick++;
 }
 
 function do_bird_jump(bird){
-    if (has_pressed_key(SPACE_KEY)) {
-        bird.y_velocity = BIRD_JUMP_VELOCITY;
-        clear_pressed_key(SPACE_KEY);
-    }
+    bird.y_velocity = BIRD_JUMP_VELOCITY;
 }
 
-function do_scroll_pipes(game) {
+function is_jump_key_pressed() {
+    if (!has_pressed_key(SPACE_KEY)) return false;
+
+    clear_pressed_key(SPACE_KEY);
+    return true;
+}
+
+/**
+ * Recycles the pipes that scrolled off the left of the screen
+ * @param game
+*/
+function cull_pipes(game) {
 
     let prev_pipe = game.pipes[NUM_PIPES - 1];
     
@@ -789,53 +1267,133 @@ function do_scroll_pipes(game) {
             curr_pipe.x = prev_pipe.x + PIPE_SPACING;
 			
 			// We also generate a new height for y position
-			curr_pipe.y = rand() % (RESOLUTION_Y - PIPE_VOID_HEIGHT * 2 - TOTAL_FLOOR_HEIGHT) + PIPE_VOID_HEIGHT;
-
-            // Cast to integer
-            curr_pipe.y |= 0; 
+			curr_pipe.y = random_pipe_y(game);
         }
 
         prev_pipe = curr_pipe;
     }
+}
 
-    // Scroll pipes
-    for (let i = 0; i < NUM_PIPES; i++) {
-        const pipe = game.pipes[i];
-
-        pipe.x -= SCROLL_VIEW_AMOUNT;
+function scroll_pipes(pipes, dx) {
+    for (const pipe of pipes) {
+        pipe.x -= dx;
     }
 }
 
 function do_scroll_grasses(game) {
-    // Scroll grasses
-    let prev_grass = game.grasses[NUM_GRASS_SQUARE - 1];
-    let curr_grass;
-
-    // Wrap around grasses
-    for (let i = 0; i < NUM_GRASS_SQUARE; i++) {
-        curr_grass = game.grasses[i];
-
-        if (curr_grass.right_x < 0) {
-            // Place grass square to the right of the rightmost square
-            curr_grass.left_x = prev_grass.right_x;
-            curr_grass.right_x = prev_grass.right_x + GRASS_SQUARE_WIDTH;  
-        }
+    game.grass_offset = (game.grass_offset + SCROLL_VIEW_AMOUNT) % GRASS_PERIOD;
+}
+
+/**
+ * Advances the game by one frame, in the order main.c does
+ * @param game
+ * @param jump - whether the bird jumps this frame
+*/
+function do_game_step(game, jump) {
+    cull_pipes(game);
+
+    const start = { ...game.bird };
+    if (jump) do_bird_jump(game.bird);
+    do_bird_velocity(game.bird);
+
+    const scroll = do_swept_collision(game, start, SCROLL_VIEW_AMOUNT);
+
+    scroll_pipes(game.pipes, scroll);
+    do_update_score(game);
+}
+
+/**
+ * Stops the step at the first pose where the bird hits a pipe, like
+ * do_swept_collision in main.c
+ * @param game - bird at the end of the step, pipes at the start
+ * @param start - bird at the start of the step
+ * @param scroll - how far the pipes move this step
+ * @return how far the pipes should scroll
+*/
+function do_swept_collision(game, start, scroll) {
+    const dy = game.bird.y - start.y;
+    const toi = sweep_pipes(game.pipes, start.x, start.y, scroll, dy);
+
+    if (toi > 1) return scroll;
+
+    const steps = clamp(Math.trunc(Math.abs(dy)) + 1, scroll, RESOLUTION_Y);
 
-        prev_grass = curr_grass;
+    // The end of the step is left to is_game_over, as without sweeping
+    for (let k = clamp(Math.trunc(toi * steps), 1, steps); k < steps; k++) {
+        const dx = Math.trunc(scroll * k / steps);
+        const moved = game.pipes.map(pipe => ({ ...pipe, x: pipe.x - dx }));
+        const bird = { ...game.bird, y: start.y + dy * k / steps };
+
+        if (collide_pipes(moved, bird) >= 0) {
+            game.bird.y = bird.y;
+            return dx;
+        }
     }
 
-    // Move all grasses
-    for (let i = 0; i < NUM_GRASS_SQUARE; i++) {
-        const grass = game.grasses[i];
+    return scroll;
+}
 
-        grass.left_x -= SCROLL_VIEW_AMOUNT;
-        grass.right_x -= SCROLL_VIEW_AMOUNT;
+/**
+ * Sweeps the bird's hull, padded by a pixel, along a straight line
+ * against every pipe
+ * @return time of first contact from 0 to 1, above 1 when there is none
+*/
+function sweep_pipes(pipes, x, y, dx, dy) {
+    const box = {
+        x0: x + bird_hull_left - 1, y0: y + bird_hull_top - 1,
+        x1: x + bird_hull_right + 1, y1: y + bird_hull_bottom + 1
+    };
+    let first = 2;
+
+    for (const pipe of pipes) {
+        first = Math.min(first, sweep_pipe(pipe, box, dx, dy));
     }
+
+    return first;
+}
+
+// Sweeps a box against the solid parts of a pipe, heads included
+function sweep_pipe(pipe, box, dx, dy) {
+    const pipe_x0 = pipe.x - pipe.width / 2 - PIPE_HEAD_OVERHANG;
+    const pipe_x1 = pipe.x + pipe.width / 2 + PIPE_HEAD_OVERHANG;
+    const void_y0 = pipe.y - pipe.void_height / 2;
+    const void_y1 = pipe.y + pipe.void_height / 2;
+    const span = { t0: 0, t1: 1 };
+    let first = 2;
+
+    // Times when the box overlaps the pipe's columns
+    if (!sweep_interval(box.x1 + 1 - pipe_x0, dx, span)) return first;
+    if (!sweep_interval(pipe_x1 + 1 - box.x0, -dx, span)) return first;
+
+    // Then when it reaches into the top pipe or the bottom pipe
+    const top = { ...span };
+    const bottom = { ...span };
+
+    if (sweep_interval(void_y0 + 1 - box.y0, -dy, top)) first = top.t0;
+    if (sweep_interval(box.y1 + 1 - void_y1, dy, bottom) && bottom.t0 < first) first = bottom.t0;
+
+    return first;
+}
+
+// Narrows span.t0..span.t1 to the times when a + b * t > 0, false when
+// that leaves nothing
+function sweep_interval(a, b, span) {
+    if (b == 0) return a > 0 && span.t0 <= span.t1;
+
+    const t = -a / b;
+
+    if (b > 0 && t > span.t0) span.t0 = t;
+    if (b < 0 && t < span.t1) span.t1 = t;
+
+    return span.t0 <= span.t1;
 }
 
-function do_scroll_view(game) {   
-    do_scroll_pipes(game);
-    do_scroll_grasses(game);
+function random_pipe_y(game) {
+    // Same constants as the C library's reference rand()
+    game.seed = (Math.imul(game.seed, 1103515245) + 12345) >>> 0;
+    const r = (game.seed >>> 16) & 0x7FFF;
+
+    return r % (RESOLUTION_Y - PIPE_VOID_HEIGHT * 2 - TOTAL_FLOOR_HEIGHT) + PIPE_VOID_HEIGHT;
 }
 
 function do_update_score(game) {
@@ -870,34 +1428,45 @@ function did_collide(bird, pipe){
     const pipe_void_y1 = pipe.y - (pipe.void_height / 2);
     const pipe_void_y2 = pipe.y + (pipe.void_height / 2);
 
-    //check whether the bird and the pipe collides
-    //the bird hasn't reached the pipe or the bird has already passed the pipe
-    if (bird.x + BIRD_WIDTH - 1 < pipe_void_x1 || bird.x > pipe_void_x2){
-        return false;
-    }
-    //some portion of the bird is in between the top and bottom pipe
-    else {
-        //y coordinate of the bird is within the void region
-        if (bird.y >= pipe_void_y1 && bird.y + BIRD_HEIGHT - 1 <= pipe_void_y2) {
-            return false;
-        }
-        //the bird and the pipe collide
-        else {
-            return true;
+    // The frame draw_bird shows for this bird, tilted and flapping
+    const frame = bird_frames[bird_wing_frame(bird.wing_tick)][bird_angle_index(bird)];
+    const left = bird.x + BIRD_CANVAS_LEFT;
+    const top = Math.trunc(bird.y) + BIRD_CANVAS_TOP;
+
+    for (let row = 0; row < BIRD_CANVAS_SIZE; row++) {
+        const y = top + row;
+
+        // Rows strictly between the two pipe edges are open
+        if (y > pipe_void_y1 && y < pipe_void_y2) continue;
+
+        // The pipe heads are drawn wider than the body on each side
+        const head = y >= pipe_void_y1 - PIPE_HEAD_HEIGHT && y <= pipe_void_y2 + PIPE_HEAD_HEIGHT;
+        const overhang = head ? PIPE_HEAD_OVERHANG : 0;
+        const x0 = Math.max(pipe_void_x1 - overhang - left, 0);
+        const x1 = Math.min(pipe_void_x2 + overhang - left, BIRD_CANVAS_SIZE - 1);
+
+        for (let x = x0; x <= x1; x++) {
+            if (frame.opaque[row * BIRD_CANVAS_SIZE + x]) return true;
         }
     }
+
+    return false;
+}
+
+// Index of the first pipe the bird overlaps, or -1
+function collide_pipes(pipes, bird) {
+    return pipes.findIndex(pipe => did_collide(bird, pipe));
 }
 
 function bird_in_screen(bird) {
-    return is_out_of_bounds(bird.y, 0, RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - BIRD_HEIGHT);
+    // main.c passes y as an int, so it is truncated first
+    return is_out_of_bounds(Math.trunc(bird.y), 0, RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - BIRD_HEIGHT);
 }
 
 // Game logic
 function is_game_over(game) {
-    for (let i = 0; i < NUM_PIPES; i++) {
-        if (did_collide(game.bird, game.pipes[i]))
-            return true;
-    }
+    if (collide_pipes(game.pipes, game.bird) >= 0)
+        return true;
 
     return bird_in_screen(game.bird);
 }
@@ -910,8 +1479,8 @@ function change_mode(game) {
             game.mode = MODE_GAME;
             game.score = 0;
 
-            initialize_pipes(game.pipes);
-            initialize_grasses(game.grasses);
+            initialize_pipes(game);
+            initialize_grasses(game);
             initialize_bird(game.bird);
         }
     }
@@ -921,8 +1490,8 @@ function change_mode(game) {
         game.mode = MODE_MENU;
         game.score = 0;
 
-        initialize_pipes(game.pipes);
-        initialize_grasses(game.grasses);
+        initialize_pipes(game);
+        initialize_grasses(game);
         initialize_bird(game.bird);
     }
 }
@@ -933,230 +1502,16 @@ function video_text(x, y, str) {
     fill_text(x * 4 - 10, y * 4 + 4, str);
 }
 
+// Forgets keys pressed so far, like emptying the PS/2 FIFO
+function clear_read_FIFO() {
+    for (const key of [SPACE_KEY, ENTER_KEY, BACK_SPACE_KEY]) clear_pressed_key(key);
+}
 
-function draw_flappy_bird(x, y, line_color){
-    //draw F
-    draw_rect(x + 1, y, x + 3, y + 17, line_color);
-    draw_rect(x + 3, y, x + 14, y + 2, line_color);
-    draw_rect(x + 3, y + 7, x + 12, y + 9, line_color);
-    //draw L
-	draw_rect(x + 20, y, x + 22, y + 17, line_color);
-    draw_rect(x + 22, y + 15, x + 32, y + 17, line_color);
-    //draw A
-    draw_rect(x + 44, y, x + 48, y + 1, line_color); 
-    draw_rect(x + 43, y + 2, x + 45, y + 4, line_color);
-    draw_rect(x + 42, y + 5, x + 44, y + 7, line_color);
-    draw_rect(x + 41, y + 8, x + 43, y + 10, line_color);
-    draw_rect(x + 40, y + 11, x + 42, y + 13, line_color);
-    draw_rect(x + 39, y + 14, x + 41, y + 16, line_color);
-    draw_rect(x + 38, y + 17, x + 40, y + 17, line_color);
-    draw_rect(x + 47, y + 2, x + 49, y + 4, line_color);
-    draw_rect(x + 48, y + 5, x + 50, y + 7, line_color);
-    draw_rect(x + 49, y + 8, x + 51, y + 10, line_color);
-    draw_rect(x + 50, y + 11, x + 52, y + 13, line_color);
-    draw_rect(x + 51, y + 14, x + 53, y + 16, line_color);
-    draw_rect(x + 52, y + 17, x + 54, y + 17, line_color);
-    draw_rect(x + 43, y + 9, x + 49, y + 11, line_color);
-    //draw P
-    draw_rect(x + 58, y, x + 60, y + 17, line_color); 
-    draw_rect(x + 61, y, x + 66, y + 1, line_color);
-    draw_rect(x + 67, y + 1, x + 69, y + 1, line_color);
-    draw_rect(x + 67, y + 2, x + 70, y + 2, line_color);
-    draw_rect(x + 69, y + 3, x + 71, y + 3, line_color);
-    draw_rect(x + 69, y + 4, x + 71, y + 5, line_color);
-    draw_rect(x + 69, y + 6, x + 71, y + 6, line_color);
-    draw_rect(x + 67, y + 7, x + 70, y + 7, line_color);
-    draw_rect(x + 67, y + 8, x + 69, y + 8, line_color);
-    draw_rect(x + 61, y + 8, x + 66, y + 9, line_color);
-    //draw P
-    draw_rect(x + 77, y, x + 79, y + 17, line_color); 
-    draw_rect(x + 80, y, x + 85, y + 1, line_color);
-    draw_rect(x + 86, y + 1, x + 88, y + 1, line_color);
-    draw_rect(x + 86, y + 2, x + 89, y + 2, line_color);
-    draw_rect(x + 88, y + 3, x + 90, y + 3, line_color);
-    draw_rect(x + 88, y + 4, x + 90, y + 5, line_color);
-    draw_rect(x + 88, y + 6, x + 90, y + 6, line_color);
-    draw_rect(x + 86, y + 7, x + 89 , y + 7, line_color);
-    draw_rect(x + 86, y + 8, x + 88, y + 8, line_color);
-    draw_rect(x + 80, y + 8, x + 85, y + 9, line_color);
-    //draw Y
-    draw_rect(x + 95, y, x + 97, y, line_color); 
-    draw_rect(x + 96, y + 1, x + 98, y + 2, line_color);
-    draw_rect(x + 97, y + 3, x + 99, y + 3, line_color);
-    draw_rect(x + 98, y + 4, x + 100, y + 5, line_color);
-    draw_rect(x + 99, y + 6, x + 101, y + 6, line_color);
-    draw_rect(x + 100, y + 7, x + 102, y + 7, line_color);
-    draw_rect(x + 101, y + 8, x + 104, y + 8, line_color);
-    draw_rect(x + 108, y, x + 110, y, line_color);
-    draw_rect(x + 107, y + 1, x + 109, y + 2, line_color);
-    draw_rect(x + 106, y + 3, x + 108, y + 3, line_color);
-    draw_rect(x + 105, y + 4, x + 107, y + 5, line_color);
-    draw_rect(x + 104, y + 6, x + 106, y + 6, line_color);
-    draw_rect(x + 103, y + 7, x + 105, y + 7, line_color);
-    draw_rect(x + 101, y + 9, x + 104, y + 17, line_color);
-
-    //starting point of B
-    const bird_x = x + 130;
-
-    //draw B
-    draw_rect(bird_x + 1, y, bird_x + 3, y + 17, line_color); 
-    draw_rect(bird_x + 4, y, bird_x + 9, y + 1, line_color);
-    draw_rect(bird_x + 10, y + 1, bird_x + 12, y + 1, line_color);
-    draw_rect(bird_x + 10, y + 2, bird_x + 13, y + 2, line_color);
-    draw_rect(bird_x + 12, y + 3, bird_x + 14, y + 3, line_color);
-    draw_rect(bird_x + 12, y + 4, bird_x + 14, y + 5, line_color);
-    draw_rect(bird_x + 12, y + 6, bird_x + 14, y + 6, line_color);
-    draw_rect(bird_x + 10, y + 7, bird_x + 13, y + 7, line_color);
-    draw_rect(bird_x + 4, y + 8, bird_x + 12, y + 9, line_color);
-    draw_rect(bird_x + 4, y + 16, bird_x + 9, y + 17, line_color);
-    draw_rect(bird_x + 10, y + 16, bird_x + 12, y + 16, line_color);
-    draw_rect(bird_x + 10, y + 15, bird_x + 13, y + 15, line_color);
-    draw_rect(bird_x + 12, y + 14, bird_x + 14, y + 14, line_color);
-    draw_rect(bird_x + 12, y + 12, bird_x + 14, y + 13, line_color);
-    draw_rect(bird_x + 12, y + 11, bird_x + 14, y + 11, line_color);
-    draw_rect(bird_x + 10, y + 10, bird_x + 13, y + 10, line_color);
-    //draw I
-    draw_rect(bird_x + 21, y, bird_x + 30, y + 2, line_color); 
-    draw_rect(bird_x + 24, y + 2, bird_x + 27, y + 15, line_color);
-    draw_rect(bird_x + 21, y + 15, bird_x + 30, y + 17, line_color);
-    //draw R
-    draw_rect(bird_x + 37, y, bird_x + 39, y + 17, line_color); 
-    draw_rect(bird_x + 40, y, bird_x + 45, y + 1, line_color);
-    draw_rect(bird_x + 46, y + 1, bird_x + 48, y + 1, line_color);
-    draw_rect(bird_x + 46, y + 2, bird_x + 49, y + 2, line_color);
-    draw_rect(bird_x + 48, y + 3, bird_x + 50, y + 3, line_color);
-    draw_rect(bird_x + 48, y + 4, bird_x + 50, y + 5, line_color);
-    draw_rect(bird_x + 48, y + 6, bird_x + 50, y + 6, line_color);
-    draw_rect(bird_x + 46, y + 7, bird_x + 49, y + 7, line_color);
-    draw_rect(bird_x + 46, y + 8, bird_x + 48, y + 8, line_color);
-    draw_rect(bird_x + 40, y + 8, bird_x + 45, y + 9, line_color);
-    draw_rect(bird_x + 43, y + 9, bird_x + 45, y + 10, line_color);
-	draw_rect(bird_x + 44, y + 10, bird_x + 46, y + 10, line_color);
-    draw_rect(bird_x + 45, y + 11, bird_x + 47, y + 11, line_color);
-    draw_rect(bird_x + 46, y + 12, bird_x + 48, y + 13, line_color);
-    draw_rect(bird_x + 47, y + 14, bird_x + 49, y + 14, line_color);
-    draw_rect(bird_x + 48, y + 15, bird_x + 50, y + 16, line_color);
-    draw_rect(bird_x + 49, y + 17, bird_x + 51, y + 17, line_color);
-    //draw D
-    draw_rect(bird_x + 57, y, bird_x + 59, y + 17, line_color); 
-    draw_rect(bird_x + 60, y, bird_x + 63, y + 1, line_color);
-    draw_rect(bird_x + 64, y + 1, bird_x + 65, y + 2, line_color);
-    draw_rect(bird_x + 65, y + 2, bird_x + 67, y + 3, line_color); 
-    draw_rect(bird_x + 66, y + 3, bird_x + 68, y + 4, line_color);
-    draw_rect(bird_x + 67, y + 5, bird_x + 69, y + 6, line_color);
-    draw_rect(bird_x + 68, y + 7, bird_x + 70, y + 10, line_color);
-    draw_rect(bird_x + 60, y + 16, bird_x + 63, y + 17, line_color);
-    draw_rect(bird_x + 64, y + 15, bird_x + 65, y + 16, line_color);
-    draw_rect(bird_x + 65, y + 14, bird_x + 67, y + 15, line_color); 
-    draw_rect(bird_x + 66, y + 13, bird_x + 68, y + 14, line_color);
-    draw_rect(bird_x + 67, y + 11, bird_x + 69, y + 12, line_color);
-}
-
-function draw_word_game_over(x, y, line_color){
-    //draw G 
-    draw_rect(x + 1, y + 6, x + 3, y + 11, line_color);
-    draw_rect(x + 2, y + 3, x + 4, y + 5, line_color);
-    draw_rect(x + 4, y + 1, x + 5, y + 3, line_color);
-    draw_rect(x + 6, y, x + 6, y + 2, line_color);
-    draw_rect(x + 7, y, x + 10, y + 1, line_color);  
-    draw_rect(x + 11, y, x + 11, y + 2, line_color);
-    draw_rect(x + 12, y + 1, x + 12, y + 3, line_color);
-    draw_rect(x + 13, y + 2, x + 14, y + 3, line_color);
-    draw_rect(x + 2, y + 12, x + 4, y + 14, line_color);
-    draw_rect(x + 4, y + 14, x + 5, y + 16, line_color);
-    draw_rect(x + 6, y + 15, x + 6, y + 17, line_color);
-    draw_rect(x + 7, y + 16, x + 10, y + 17, line_color);  
-    draw_rect(x + 10, y + 15, x + 11, y + 17, line_color);
-    draw_rect(x + 12, y + 14, x + 13, y + 16, line_color);
-    draw_rect(x + 14, y + 13, x + 15, y + 14, line_color);
-    draw_rect(x + 14, y + 8, x + 16, y + 12, line_color);
-    draw_rect(x + 9, y + 8, x + 14, y + 10, line_color);
-    //draw A
-    draw_rect(x + 26, y, x + 30, y + 1, line_color); 
-    draw_rect(x + 25, y + 2, x + 27, y + 4, line_color);
-    draw_rect(x + 24, y + 5, x + 26, y + 7, line_color);
-    draw_rect(x + 23, y + 8, x + 25, y + 10, line_color);
-    draw_rect(x + 22, y + 11, x + 24, y + 13, line_color);
-    draw_rect(x + 21, y + 14, x + 23, y + 16, line_color);  
-    draw_rect(x + 20, y + 17, x + 22, y + 17, line_color);
-    draw_rect(x + 29, y + 2, x + 31, y + 4, line_color);
-    draw_rect(x + 30, y + 5, x + 32, y + 7, line_color);
-    draw_rect(x + 31, y + 8, x + 33, y + 10, line_color);
-    draw_rect(x + 32, y + 11, x + 34, y + 13, line_color);
-    draw_rect(x + 33, y + 14, x + 35, y + 16, line_color);
-    draw_rect(x + 34, y + 17, x + 36, y + 17, line_color);
-    draw_rect(x + 25, y + 9, x + 31, y + 11, line_color);
-    //draw M
-    draw_rect(x + 40, y, x + 42, y + 17, line_color); 
-    draw_rect(x + 43, y, x + 43, y + 2, line_color);
-    draw_rect(x + 44, y + 1, x + 45, y + 9, line_color);
-    draw_rect(x + 45, y + 10, x + 46, y + 15, line_color);
-    draw_rect(x + 47, y + 15, x + 48, y + 17, line_color);
-    draw_rect(x + 53, y, x + 55, y + 17, line_color); 
-    draw_rect(x + 52, y, x + 52, y + 2, line_color);
-    draw_rect(x + 50, y + 1, x + 51, y + 9, line_color);
-    draw_rect(x + 49, y + 10, x + 50, y + 15, line_color);
-    //draw E
-    draw_rect(x + 60, y, x + 62, y + 17, line_color);
-    draw_rect(x + 62, y, x + 73, y + 2, line_color);
-    draw_rect(x + 62, y + 7, x + 71, y + 9, line_color);
-    draw_rect(x + 62, y + 15, x + 73, y + 17, line_color);
-
-    //starting point of O
-    const over_x = x + 94;
-
-    //draw O
-    draw_rect(over_x + 1, y + 6, over_x + 3, y + 11, line_color);
-    draw_rect(over_x + 2, y + 3, over_x + 4, y + 5, line_color);
-    draw_rect(over_x + 4, y + 1, over_x + 5, y + 3, line_color);
-    draw_rect(over_x + 6, y, over_x + 6, y + 2, line_color);
-    draw_rect(over_x + 7, y, over_x + 10, y + 1, line_color);  
-    draw_rect(over_x + 11, y, over_x + 11, y + 2, line_color);
-    draw_rect(over_x + 12, y + 1, over_x + 13, y + 3, line_color);
-    draw_rect(over_x + 13, y + 3, over_x + 15, y + 5, line_color);
-    draw_rect(over_x + 2, y + 12, over_x + 4, y + 14, line_color);
-    draw_rect(over_x + 4, y + 14, over_x + 5, y + 16, line_color);
-    draw_rect(over_x + 6, y + 15, over_x + 6, y + 17, line_color);
-    draw_rect(over_x + 7, y + 16, over_x + 10, y + 17, line_color);  
-    draw_rect(over_x + 11, y + 15, over_x + 11, y + 17, line_color);
-    draw_rect(over_x + 12, y + 14, over_x + 13, y + 16, line_color);
-    draw_rect(over_x + 13, y + 12, over_x + 15, y + 14, line_color);
-	draw_rect(over_x + 14, y + 6, over_x + 16, y + 11, line_color);
-    //draw V
-    draw_rect(over_x + 20, y, over_x + 22, y + 1, line_color);
-	draw_rect(over_x + 21, y + 1, over_x + 23, y + 2, line_color);
-	draw_rect(over_x + 22, y + 3, over_x + 24, y + 6, line_color);
-	draw_rect(over_x + 23, y + 7, over_x + 25, y + 8, line_color);
-    draw_rect(over_x + 24, y + 9, over_x + 26, y + 12, line_color);
-    draw_rect(over_x + 25, y + 13, over_x + 27, y + 14, line_color);
-    draw_rect(over_x + 26, y + 15, over_x + 29, y + 17, line_color);
-	draw_rect(over_x + 33, y, over_x + 35, y + 1, line_color);
-	draw_rect(over_x + 32, y + 1, over_x + 34, y + 2, line_color);
-	draw_rect(over_x + 31, y + 3, over_x + 33, y + 6, line_color);
-	draw_rect(over_x + 30, y + 7, over_x + 32, y + 8, line_color);
-    draw_rect(over_x + 29, y + 9, over_x + 31, y + 12, line_color);
-    draw_rect(over_x + 28, y + 13, over_x + 30, y + 14, line_color);
-    //draw E
-    draw_rect(over_x + 40, y, over_x + 42, y + 17, line_color);
-    draw_rect(over_x + 42, y, over_x + 53, y + 2, line_color);
-    draw_rect(over_x + 42, y + 7, over_x + 50, y + 9, line_color);
-    draw_rect(over_x + 42, y + 15, over_x + 53, y + 17, line_color);
-    //draw R
-    draw_rect(over_x + 59, y, over_x + 61, y + 17, line_color); 
-    draw_rect(over_x + 62, y, over_x + 67, y + 1, line_color);
-    draw_rect(over_x + 68, y + 1, over_x + 70, y + 1, line_color);
-    draw_rect(over_x + 68, y + 2, over_x + 71, y + 2, line_color);
-    draw_rect(over_x + 70, y + 3, over_x + 72, y + 3, line_color);
-    draw_rect(over_x + 70, y + 4, over_x + 72, y + 5, line_color);
-    draw_rect(over_x + 70, y + 6, over_x + 72, y + 6, line_color);
-    draw_rect(over_x + 68, y + 7, over_x + 71, y + 7, line_color);
-    draw_rect(over_x + 68, y + 8, over_x + 70, y + 8, line_color);
-    draw_rect(over_x + 62, y + 8, over_x + 67, y + 9, line_color);
-    draw_rect(over_x + 65, y + 9, over_x + 67, y + 10, line_color);
-	draw_rect(over_x + 66, y + 10, over_x + 68, y + 10, line_color);
-    draw_rect(over_x + 67, y + 11, over_x + 69, y + 11, line_color);
-    draw_rect(over_x + 68, y + 12, over_x + 70, y + 13, line_color);
-    draw_rect(over_x + 69, y + 14, over_x + 71, y + 14, line_color);
-    draw_rect(over_x + 70, y + 15, over_x + 72, y + 16, line_color);
-    draw_rect(over_x + 71, y + 17, over_x + 73, y + 17, line_color);
+// Lets the game run headless under Node. The host has to provide rand,
+// next_frame, fill_text, has_pressed_key and clear_pressed_key globals
+if (typeof module !== "undefined") {
+    module.exports = {
+        game, main, frame_buffer, convert_frame, hash_frame,
+        SPACE_KEY, ENTER_KEY, BACK_SPACE_KEY, MODE_MENU, MODE_GAME, MODE_GAME_OVER
+    };
 }
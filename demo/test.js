@@ -0,0 +1,108 @@
+/*
+ * Headless test for the demo. Plays a scripted session under Node: the
+ * menu, a game flown by a simple bot until it stops flapping, the game
+ * over screen, back to the menu and into a second game. The framebuffer
+ * of every frame is hashed and checked against demo/test_hashes.json.
+ *
+ *   node demo/test.js            check the frames
+ *   node demo/test.js --update   rewrite the hashes after an intended change
+*/
+const fs = require("fs");
+const path = require("path");
+
+const FRAMES = 400;
+const HASHES_PATH = path.join(__dirname, "test_hashes.json");
+
+// Same constants as the C library's reference rand(), so pipe heights
+// are the same on every run
+let rand_seed = 1;
+
+globalThis.rand = function () {
+    rand_seed = (Math.imul(rand_seed, 1103515245) + 12345) >>> 0;
+    return (rand_seed >>> 16) & 0x7FFF;
+};
+
+const demo = require("./flappy-bird.js");
+
+// Flaps whenever the bird sinks below the middle of the next void
+function bot_should_jump(game) {
+    let next = null;
+
+    for (const pipe of game.pipes) {
+        if (pipe.x + pipe.width / 2 < game.bird.x) continue;
+        if (next == null || pipe.x < next.x) next = pipe;
+    }
+
+    return game.bird.y_velocity < 0 && game.bird.y + 12 > next.y;
+}
+
+// Keys pressed before the frame with this index is drawn. The bot plays
+// until frame 240 and then lets the bird drop
+function scripted_keys(frame) {
+    if (frame == 20 || frame == 340) return [demo.ENTER_KEY];
+    if (frame == 310) return [demo.BACK_SPACE_KEY];
+    if (demo.game.mode == demo.MODE_GAME && frame < 240 && bot_should_jump(demo.game)) return [demo.SPACE_KEY];
+    return [];
+}
+
+const pressed_keys = {};
+const hashes = [];
+const modes = [];
+let top_score = 0;
+
+globalThis.fill_text = function (x, y, text) {};
+globalThis.has_pressed_key = (key) => !!pressed_keys[key];
+globalThis.clear_pressed_key = (key) => { pressed_keys[key] = false; };
+
+globalThis.next_frame = function () {
+    hashes.push(demo.hash_frame().toString(16).padStart(8, "0"));
+    modes.push(demo.game.mode);
+    top_score = Math.max(top_score, demo.game.score);
+
+    if (hashes.length == FRAMES) {
+        finish();
+
+        // Never resolves, so the game loop stops here and Node exits
+        return new Promise(() => {});
+    }
+
+    for (const key of scripted_keys(hashes.length)) pressed_keys[key] = true;
+    return Promise.resolve();
+};
+
+// Frames at which the mode changes, to show what the script went through
+function mode_changes() {
+    const names = ["menu", "game", "game over"];
+    const changes = [];
+
+    for (let i = 0; i < modes.length; i++) {
+        if (i == 0 || modes[i] != modes[i - 1]) changes.push(`${names[modes[i]]} at ${i}`);
+    }
+
+    return changes.join(", ");
+}
+
+function finish() {
+    console.log(`${FRAMES} frames: ${mode_changes()}, top score ${top_score}`);
+
+    if (process.argv.includes("--update")) {
+        fs.writeFileSync(HASHES_PATH, JSON.stringify(hashes, null, 4) + "\n");
+        console.log(`wrote ${HASHES_PATH}`);
+        return;
+    }
+
+    const expected = JSON.parse(fs.readFileSync(HASHES_PATH, "utf8"));
+    let failures = expected.length == FRAMES ? 0 : 1;
+
+    if (failures) console.log(`FAIL expected ${expected.length} hashes`);
+
+    for (let i = 0; i < FRAMES; i++) {
+        if (hashes[i] == expected[i]) continue;
+        if (failures++ < 10) console.log(`FAIL frame ${i}: ${hashes[i]}, expected ${expected[i]}`);
+    }
+
+    console.log(failures ? "FAIL" : "PASS");
+    process.exitCode = failures ? 1 : 0;
+}
+
+demo.main();
@@ -0,0 +1,34 @@
+/*
+ * Runs main.c itself in the browser. The board code runs unchanged on
+ * the host platform layer; this file only shows each frame and the
+ * character buffer on the page and feeds it the keys. There is no
+ * sound, the host codec FIFO just fills up.
+ *
+ * Built by demo/build_wasm.sh, which needs Emscripten.
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+// Hands the front buffer and the character buffer to the page, then
+// lets the browser draw them
+void show_frame() {
+    const char *front = board_memory(*pixel_ctrl_ptr);
+
+    EM_ASM({
+        Module.show_frame(HEAPU16.subarray($0 >> 1, ($0 >> 1) + $1 * $2), $1, HEAPU8.subarray($3, $3 + $4));
+    }, front, NATIVE_STRIDE_PIXELS, RESOLUTION_Y, host_char_buffer, CHAR_BUFFER_SIZE);
+
+    emscripten_sleep(0);
+}
+
+// Called by the page with each byte the keyboard would send
+EMSCRIPTEN_KEEPALIVE void press_key(int code) {
+    host_press_key(code);
+}
+
+int main(void) {
+    host_frame_hook = show_frame;
+    board_main();
+    return 0;
+}
@@ -1,9 +1,21 @@
 /* This files provides address values that exist in the system */
 #define SDRAM_BASE            0xC0000000
+#define FPGA_ONCHIP_BASE      0xC8000000
 #define FPGA_CHAR_BASE        0xC9000000
 
 /* Cyclone V FPGA devices */
 #define PS2_BASE              0xFF200100
+#define TIMER_BASE            0xFF202000
+#define AUDIO_BASE            0xFF203040
+#define PIXEL_CTRL_BASE       0xFF203020
+
+/* Cortex A9 MPCORE devices */
+#define MPCORE_PRIV_TIMER     0xFFFEC600
+#define MPCORE_GIC_CPUIF      0xFFFEC100
+#define MPCORE_GIC_DIST       0xFFFED000
+
+// The private timer counts at 200 MHz with a prescaler of zero
+#define TIMER_TICKS_PER_US 200
 
 /* VGA colors */
 #define WHITE 0xFFFF
@@ -18,20 +30,36 @@
 #define RESOLUTION_X 320
 #define RESOLUTION_Y 240
 
+// Pixels per row of the native frame, including padding. Rows are 1024
+// bytes apart like in the VGA pixel buffer
+#define NATIVE_STRIDE_PIXELS 512
+
 /* Flappy bird specific constants */
 #define SCROLL_VIEW_AMOUNT 2
 
-/* Score */
-#define NUM_DIGITS 10
+/* Text */
+// Glyphs are FONT_CHAR_WIDTH x FONT_CHAR_HEIGHT, one byte per row with
+// the leftmost pixel in bit FONT_CHAR_WIDTH - 1. Digits come first,
+// then A to Z
+#define FONT_CHAR_WIDTH 5
+#define FONT_CHAR_HEIGHT 7
+#define NUM_FONT_GLYPHS 36
+
+// Blank columns between two glyphs, before scaling
+#define FONT_CHAR_SPACING 1
 
-// Dimensions of the character font
-#define SCORE_CHAR_WIDTH 4
-#define SCORE_CHAR_HEIGHT 6
+// Text can be drawn at 1 to FONT_MAX_SCALE times its size. Masks are
+// kept for every scale, with a one pixel border for the outline
+#define FONT_MAX_SCALE 3
+#define FONT_MASK_HEIGHT (FONT_CHAR_HEIGHT * FONT_MAX_SCALE + 2)
 
 // Scaling; For example if 2, then font is drawn at twice
 // its normal size
 #define SCORE_CHAR_SCALE 2
-#define SCORE_POS_X (RESOLUTION_X - 30)
+#define TITLE_CHAR_SCALE 3
+
+// Top right corner of the score while playing
+#define SCORE_POS_X (RESOLUTION_X - 24)
 #define SCORE_POS_Y 10
 
 /* Pipes */
@@ -43,6 +71,23 @@
 #define PIPE_SPACING 120
 #define PIPE_START_X 140
 
+/* Entities */
+// Slots in an entity_store_t. Pipes always take the first NUM_PIPES
+// slots, other kinds of obstacles go after them
+#define MAX_ENTITIES 16
+// Values of entity_store_t.kind
+#define ENTITY_PIPE 0
+// Bits of entity_store_t.flags
+#define ENTITY_SCORED 0b01
+
+// Pipes are drawn from a cached head sprite, PIPE_HEAD_HEIGHT + 1 rows
+// tall, and a one row body slice stretched down to the head. Both
+// include the black outline
+#define PIPE_HEAD_WIDTH (PIPE_WIDTH + 3)
+#define PIPE_BODY_WIDTH (PIPE_WIDTH + 1)
+// Pixels the head reaches past the body on each side
+#define PIPE_HEAD_OVERHANG 1
+
 /* Birds */
 #define BIRD_WIDTH 34
 #define BIRD_HEIGHT 24
@@ -52,10 +97,53 @@
 #define BIRD_JUMP_VELOCITY 3.2
 #define BIRD_GRAVITY 0.4
 
+// The sprite hangs 2 pixels left of the bird's x and is 34 pixels wide,
+// so one row of it fits in a 64 bit mask
+#define BIRD_MASK_LEFT -2
+#define BIRD_MASK_BITS 64
+#define NUM_BIRD_SPRITE_RECTS 53
+#define NUM_BIRD_WING_RECTS 3
+
+// The bird tilts by BIRD_DEGREES_PER_VELOCITY for every unit of
+// y_velocity, nose up when rising and diving when falling. Tilts are
+// rounded to one of NUM_BIRD_ANGLES angles BIRD_ANGLE_STEP degrees apart
+#define BIRD_MIN_ANGLE -30
+#define BIRD_ANGLE_STEP 15
+#define NUM_BIRD_ANGLES 9
+#define BIRD_DEGREES_PER_VELOCITY 10
+
+// Wing up, level and down, each held for WING_FRAME_TICKS frames. The
+// wing moves WING_FLAP_DY pixels up or down from level
+#define NUM_WING_FRAMES 3
+#define WING_FRAME_TICKS 4
+// Ticks of a whole flap: up, level, down, level
+#define WING_CYCLE_TICKS (4 * WING_FRAME_TICKS)
+#define WING_FLAP_DY 2
+
+// Any rotation of the sprite about its centre fits in a square canvas
+// of this size, drawn at this offset from the bird's position so the
+// level bird lands exactly where the unrotated sprite did
+#define BIRD_CANVAS_SIZE 42
+#define BIRD_CANVAS_LEFT -6
+#define BIRD_CANVAS_TOP -9
+
+/* Collision */
+// COLLISION_BOX tests the bird's BIRD_WIDTH x BIRD_HEIGHT box against the
+// void. COLLISION_PIXEL tests the opaque pixels of the sprite against
+// the pipe as drawn, so transparent corners no longer count as hits
+#define COLLISION_BOX 0
+#define COLLISION_PIXEL 1
+#define COLLISION_MODE COLLISION_PIXEL
+// Also test the path the bird takes during a frame, not just where it
+// ends up, so fast scrolling can't carry it through a pipe corner
+#define CONTINUOUS_COLLISION 1
+
 /* Modes */
 #define MODE_MENU 0
 #define MODE_GAME 1
 #define MODE_GAME_OVER 2
+#define MODE_REPLAY 3
+#define MODE_NETPLAY 4
 
 /* Background */
 #define GROUND_THICKNESS 20
@@ -64,126 +152,271 @@
 #define SKY_THICKNESS (RESOLUTION_Y - TOTAL_FLOOR_HEIGHT)
 #define GRASS_SQUARE_WIDTH 10
 
-// This is calulated from (RESOLUTION_X) / GRASS_SQUARE_WIDTH
-#define NUM_GRASS_SQUARE 34
+// Grass alternates between two colors, so it repeats every two squares
+#define GRASS_PERIOD (GRASS_SQUARE_WIDTH * 2)
+
+// Rows of the screen the grass covers, outlines included. The strip it
+// is pre-rendered into is a period wider than the screen
+#define GRASS_STRIP_TOP (SKY_THICKNESS - 1)
+#define GRASS_STRIP_HEIGHT (GRASS_THICKNESS + 3)
+#define GRASS_STRIP_WIDTH (RESOLUTION_X + GRASS_PERIOD)
+
+/* Observations */
+// Size of the grid agents see. Each cell covers a square of
+// 1 << OBS_SCALE_SHIFT screen pixels on a side
+#define OBS_SCALE_SHIFT 2
+#define OBS_WIDTH (RESOLUTION_X >> OBS_SCALE_SHIFT)
+#define OBS_HEIGHT (RESOLUTION_Y >> OBS_SCALE_SHIFT)
+
+// Cell values. They are far apart so the grid also reads as grayscale
+#define OBS_EMPTY 0
+#define OBS_FLOOR 64
+#define OBS_PIPE 128
+#define OBS_BIRD 255
 
 /* Key data */
 #define SPACE_KEY 0x29
 #define ENTER_KEY 0x5A
 #define BACK_SPACE_KEY 0x66
+#define A_KEY 0x1C
+#define N_KEY 0x31
+#define L_KEY 0x4B
+#define R_KEY 0x2D
+#define LEFT_KEY 0x6B
+#define RIGHT_KEY 0x74
+// Sent before the code of a key that was released
+#define BREAK_CODE 0xF0
+// Bytes the PS/2 port buffers before it drops them
+#define PS2_FIFO_DEPTH 256
+// The character buffer is 80x60 with rows 128 bytes apart
+#define CHAR_BUFFER_SIZE (128 * 60)
+
+/* Input latency */
+// Histogram of the time from a key arriving to the frame showing it
+// being scanned out, in buckets of LATENCY_BUCKET_US. The last bucket
+// also counts everything slower
+#define LATENCY_BUCKET_US 250
+#define LATENCY_NUM_BUCKETS 256
+
+/* Frame governor */
+// Sleeps through the slack of each frame instead of spinning on vsync
+#define FRAME_GOVERNOR 1
+// The VGA controller swaps at 60 Hz
+#define FRAME_PERIOD_US 16667
+// Wake up this long before the expected swap and poll for the rest
+#define GOVERNOR_WAKE_MARGIN_US 1000
+// The interval timer counts at 100 MHz
+#define INTERVAL_TIMER_TICKS_PER_US 100
+#define INTERVAL_TIMER_IRQ 72
+#define PS2_IRQ 79
+#define AUDIO_IRQ 78
+
+/* Audio */
+// The codec plays 48k samples per second out of a 128 sample FIFO per
+// channel, about 2.7 ms of sound. Clips are mono and go to both sides
+#define AUDIO_ENABLED 1
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_FIFO_DEPTH 128
+// Samples mixed per call to mix_audio_block, a multiple of 8
+#define AUDIO_BLOCK_SAMPLES 32
+#define NUM_AUDIO_VOICES 4
+// Gains are Q15, 32767 is unity
+#define AUDIO_FULL_GAIN 32767
+#define FLAP_CLIP_SAMPLES (AUDIO_SAMPLE_RATE * 70 / 1000)
+#define SCORE_CLIP_SAMPLES (AUDIO_SAMPLE_RATE * 240 / 1000)
+#define HIT_CLIP_SAMPLES (AUDIO_SAMPLE_RATE * 250 / 1000)
+
+/* Autopilot */
+// How many frames ahead the autopilot searches
+#define AUTOPILOT_DEPTH 30
+// Frames between two jump decisions inside the search tree. Smaller
+// is more precise but the tree grows as 2^(depth / this)
+#define AUTOPILOT_DECISION_FRAMES 5
+
+/* Environment pool */
+// Host builds can step a pool of environments on several threads. Each
+// thread takes ENV_POOL_CHUNK games at a time until none are left, so
+// threads that finish early take over the rest of the work
+#define ENV_POOL_MAX_THREADS 64
+#define ENV_POOL_CHUNK 64
+
+/* Netplay */
+// Frames of inputs and snapshots kept for rollback. A player can run at
+// most this many frames ahead of the last input it got from the other
+#define NETPLAY_HISTORY 16
+#define NETPLAY_LOCAL 0
+#define NETPLAY_REMOTE 1
+// A kiosk can be at most 2 * NETPLAY_HISTORY frames ahead of what the
+// other has acknowledged, so every unacknowledged input fits in a packet
+#define NETPLAY_PACKET_INPUTS (2 * NETPLAY_HISTORY)
+#define NETPLAY_MAGIC 0x4E504246
+// Both kiosks race on the pipes of this seed
+#define NETPLAY_SEED 2024
+// Frames a finished kiosk keeps answering so the other one can finish too
+#define NETPLAY_LINGER_FRAMES 120
+
+/* Replay */
+// Every game is recorded into replay and can be watched from the game
+// over screen by pressing R. A keyframe is kept every
+// REPLAY_KEYFRAME_FRAMES frames; when the index is full every other
+// one is dropped and the interval doubles, so a session of any length
+// fits. Jumps are recorded until the input stream is full
+#define REPLAY_MAGIC 0x31524246
+#define REPLAY_KEYFRAME_FRAMES 300
+#define REPLAY_MAX_KEYFRAMES 256
+#define REPLAY_MAX_INPUT_BYTES 65536
+// A record is at most this long, 7 bits per byte
+#define REPLAY_MAX_RECORD_BYTES 5
+// How far the arrow keys move through a replay
+#define REPLAY_SCRUB_FRAMES 300
+
+/* Parameter sweep */
+// Set to 1 to run run_parameter_sweep() at boot instead of the game.
+// Results are printed to the JTAG UART as CSV
+#define PARAMETER_SWEEP 0
+#define SWEEP_GAMES 1000
+
+// Games still going after this many frames count as survivors
+#define SWEEP_MAX_FRAMES 3000
+
+// Survival is sampled every SWEEP_CURVE_STEP frames. Scores of
+// SWEEP_MAX_SCORE and up share the last histogram bucket
+#define SWEEP_CURVE_STEP 100
+#define SWEEP_CURVE_POINTS (SWEEP_MAX_FRAMES / SWEEP_CURVE_STEP + 1)
+#define SWEEP_MAX_SCORE 100
+
+// When above zero, this many configs are drawn at random from the
+// ranges of the grid instead of running the whole grid
+#define SWEEP_RANDOM_CONFIGS 0
+
+// The sweep bot aims at the void centre plus a random offset of up to
+// this many pixels, picked again every frame
+#define SWEEP_AIM_NOISE 10
+
+/* Deferred rendering */
+// When on, draw_* calls on the screen append commands to a display
+// list instead of writing pixels. next_frame bins the commands into
+// TILE_WIDTH x TILE_HEIGHT tiles and resolves each tile once, front to
+// back, so every pixel of the frame buffer is written exactly once.
+// Off by default: test_renderer finds it writes fewer pixels but takes
+// longer than drawing straight into the frame
+#define DEFERRED_RENDERING 0
+// A row of a tile is one bit per pixel in an unsigned int
+#define TILE_WIDTH 32
+#define TILE_HEIGHT 16
+// Tiles of the largest surface a display list can be used on
+#define MAX_TILES_X ((RESOLUTION_X + TILE_WIDTH - 1) / TILE_WIDTH)
+#define MAX_TILES_Y ((RESOLUTION_Y + TILE_HEIGHT - 1) / TILE_HEIGHT)
+// The list is resolved early when either runs out, which is still
+// correct but writes those pixels more than once
+#define MAX_DRAW_COMMANDS 1024
+#define MAX_BINNED_COMMANDS 8192
+
+// Kinds of draw_command_t
+#define DRAW_FILL 0
+#define DRAW_BLIT 1
+#define DRAW_SPRITE 2
+#define DRAW_GLYPH 3
+#define DRAW_BLEND 4
+
+/* Blending */
+// Alpha goes from 0 (keep destination) to BLEND_OPAQUE (use source)
+#define BLEND_OPAQUE 32
+#define GAME_OVER_DIM_ALPHA 12
+// The GAME OVER title fades in over this many frames
+#define GAME_OVER_FADE_FRAMES 16
+// Ghost birds let about half of what is behind them show through
+#define GHOST_ALPHA 18
 
 /* Includes */
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
-
-volatile int pixel_buffer_start;
-volatile int *pixel_ctrl_ptr = (int *) 0xFF203020;
-
-// Custom font for digits of image
-int digits_image[NUM_DIGITS][SCORE_CHAR_HEIGHT][SCORE_CHAR_WIDTH] = {
-
-    // Zero
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // One
-    {
-        { 0, 0, 0, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 0, 1, 0 },
-    },
-
-    // Two
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // Three
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // Four
-    {
-        { 0, 0, 0, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 0, 1, 0 },
-    },
-
-    // Five
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // Six
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // Seven
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 1, 0, 0 },
-        { 0, 1, 0, 0 },
-        { 0, 1, 0, 0 },
-    },
-
-    // Eight
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-    },
-
-    // Nine
-    {
-        { 0, 0, 0, 0 },
-        { 1, 1, 1, 0 },
-        { 1, 0, 1, 0 },
-        { 1, 1, 1, 0 },
-        { 0, 0, 1, 0 },
-        { 0, 0, 1, 0 },
-    }
+#include <string.h>
+#include <stdint.h>
+
+// Host builds get threads for the environment pool and UDP for netplay
+#if !defined(__arm__)
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#if defined(__EMSCRIPTEN__)
+#include <emscripten.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__arm__)
+volatile int *pixel_ctrl_ptr = (int *) PIXEL_CTRL_BASE;
+#else
+// Stands in for the pixel buffer controller on host builds: front
+// buffer, back buffer, resolution and status. The status never shows a
+// swap pending, wait_for_vsync does the swap itself
+int host_pixel_ctrl[4] = { 0, 0, RESOLUTION_Y << 16 | RESOLUTION_X, 0 };
+volatile int *pixel_ctrl_ptr = host_pixel_ctrl;
+#endif
+
+// Bit-packed font, one byte per row. Bit FONT_CHAR_WIDTH - 1 is the
+// leftmost column
+unsigned char font_glyphs[NUM_FONT_GLYPHS][FONT_CHAR_HEIGHT] = {
+    { 0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110 }, // 0
+    { 0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 }, // 1
+    { 0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111 }, // 2
+    { 0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110 }, // 3
+    { 0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010 }, // 4
+    { 0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110 }, // 5
+    { 0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110 }, // 6
+    { 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000 }, // 7
+    { 0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110 }, // 8
+    { 0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100 }, // 9
+    { 0b01110, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001 }, // A
+    { 0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110 }, // B
+    { 0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110 }, // C
+    { 0b11100, 0b10010, 0b10001, 0b10001, 0b10001, 0b10010, 0b11100 }, // D
+    { 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111 }, // E
+    { 0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000 }, // F
+    { 0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01111 }, // G
+    { 0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001 }, // H
+    { 0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110 }, // I
+    { 0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100 }, // J
+    { 0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001 }, // K
+    { 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111 }, // L
+    { 0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001 }, // M
+    { 0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001 }, // N
+    { 0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 }, // O
+    { 0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000 }, // P
+    { 0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101 }, // Q
+    { 0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001 }, // R
+    { 0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110 }, // S
+    { 0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100 }, // T
+    { 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110 }, // U
+    { 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100 }, // V
+    { 0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b10101, 0b01010 }, // W
+    { 0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001 }, // X
+    { 0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100, 0b00100 }, // Y
+    { 0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111 }, // Z
 };
 
+// A glyph blown up to one scale. Bit i of row y is the pixel i, y from
+// the top left of the border, so the glyph itself starts at 1, 1.
+// outline is every pixel next to the glyph, diagonals included
+typedef struct glyph_mask {
+    unsigned int fill[FONT_MASK_HEIGHT];
+    unsigned int outline[FONT_MASK_HEIGHT];
+} glyph_mask_t;
+
+// Indexed by scale - 1, then glyph
+glyph_mask_t glyph_masks[FONT_MAX_SCALE][NUM_FONT_GLYPHS];
 
 // Adapted from https://flappybird.io/img/background.png
 // image for sky encoded using Run-Length Encoding in 565 RGB format
@@ -205,83 +438,809 @@ typedef struct bird {
     // y_velocity is a double so we can
     // make gravity not jumpy
     double y_velocity;
-} bird_t;
 
-typedef struct pipe {
-    // Coordinates of the centre of void for the pipe
-    int x;
-    int y;
+    // Frames flown modulo WING_CYCLE_TICKS, which picks the wing
+    // position. It is part of the game so collisions see the wing
+    // where every kiosk draws it
+    unsigned int wing_tick;
+} bird_t;
 
-    // How wide the pipe should be
-    int width;
+// Obstacles stored one array per component, so the systems that
+// scroll, cull and collide them each run down a few plain arrays.
+// draw_entities, collide_entities and sweep_entities pick what to do
+// from the kind of each slot. Pipe slots are in ring order: the pipe
+// after slot i is slot i + 1, wrapping around at NUM_PIPES
+typedef struct entity_store {
+    int count;
+
+    // ENTITY_PIPE and so on
+    unsigned char kind[MAX_ENTITIES];
+
+    // Coordinates of the centre of each entity, the void for a pipe
+    int x[MAX_ENTITIES];
+    int y[MAX_ENTITIES];
+
+    // How wide each entity is, and how tall. For a pipe, how tall its void is
+    int width[MAX_ENTITIES];
+    int height[MAX_ENTITIES];
+
+    // ENTITY_* bits
+    unsigned char flags[MAX_ENTITIES];
+} entity_store_t;
+
+// Box swept against the entities, in pixels
+typedef struct sweep_box {
+    double x0;
+    double y0;
+    double x1;
+    double y1;
+} sweep_box_t;
 
-    // The height of the void where the bird
-    // can fit through
-    int void_height;
+typedef short int color_t;
 
-    // Keeps track of whether we already added going
-    // through this pipe to the score
-    bool did_score_update;
-} pipe_t;
+// Two pixels written with one 32 bit store. may_alias lets these stores
+// go into color_t buffers without breaking strict aliasing
+typedef unsigned int __attribute__((may_alias)) color_pair_t;
+
+typedef struct sprite_rect {
+    // Corners relative to the sprite's position, inclusive
+    signed char x0;
+    signed char y0;
+    signed char x1;
+    signed char y1;
+    color_t color;
+} sprite_rect_t;
+
+// Bird sprite as rectangles relative to the top left point of the
+// bird, drawn in this order. Modified based on this to draw bird:
+// https://www.pinterest.com/pin/559924166147577544/
+sprite_rect_t bird_sprite[NUM_BIRD_SPRITE_RECTS] = {
+    {  -2, 10, -1, 13, BLACK  },
+    {   0,  8,  1,  9, BLACK  },
+    {   0, 10,  1, 11, WHITE  },
+    {   0, 12,  1, 13, YELLOW },
+    {   0, 14,  1, 15, BLACK  },
+    {  10,  0, 21,  1, BLACK  },
+    {   6,  2,  9,  3, BLACK  },
+    {  16,  2, 17,  3, YELLOW },
+    {  18,  2, 19,  3, BLACK  },
+    {  20,  2, 21,  3, WHITE  },
+    {  22,  2, 23,  3, BLACK  },
+    {   4,  4,  5,  5, BLACK  },
+    {   6,  4,  9,  5, YELLOW },
+    {  16,  4, 17,  9, BLACK  },
+    {  22,  4, 23,  5, WHITE  },
+    {  24,  4, 25,  5, BLACK  },
+    {   2,  6,  7,  7, BLACK  },
+    {   8,  6,  9,  7, YELLOW },
+    {  18, 10, 19, 11, BLACK  },
+    {  18,  4, 21,  9, WHITE  },
+    {  22,  6, 23,  9, BLACK  },
+    {  24,  6, 25, 11, WHITE  },
+    {  26,  6, 27, 11, BLACK  },
+    {   2,  8,  7, 13, WHITE  },
+    {   8,  8,  9,  9, BLACK  },
+    {  10,  2, 15,  9, YELLOW },
+    {  20, 10, 23, 11, WHITE  },
+    {   8, 10,  9, 11, WHITE  },
+    {   8, 12,  9, 13, YELLOW },
+    {  10, 10, 11, 13, BLACK  },
+    {  12, 10, 17, 15, YELLOW },
+    {  18, 12, 19, 13, YELLOW },
+    {  20, 12, 29, 13, BLACK  },
+    {   2, 14,  7, 15, YELLOW },
+    {   8, 14,  9, 15, BLACK  },
+    {  10, 14, 11, 15, YELLOW },
+    {  18, 14, 19, 15, BLACK  },
+    {  20, 14, 29, 15, ORANGE },
+    {  30, 14, 31, 15, BLACK  },
+    {   2, 16,  7, 17, BLACK  },
+    {   8, 16, 15, 19, SAND   },
+    {  16, 16, 17, 17, BLACK  },
+    {  18, 16, 19, 17, ORANGE },
+    {  20, 16, 29, 17, BLACK  },
+    {   6, 18,  7, 19, BLACK  },
+    {  16, 18, 17, 19, SAND   },
+    {  18, 18, 19, 19, BLACK  },
+    {  20, 18, 27, 19, ORANGE },
+    {  28, 18, 29, 19, BLACK  },
+    {   8, 20, 11, 21, BLACK  },
+    {  12, 20, 19, 21, SAND   },
+    {  20, 20, 29, 21, BLACK  },
+    {  12, 22, 19, 23, BLACK  },
+};
 
-typedef struct grass {
-    // Unlike pipe, grass coordinates are not centered for
-    // ease of programming
-    int left_x;
-    int right_x;
-} grass_t;
+// Opaque pixels of each upright bird sprite row, which ghosts are
+// drawn from. Bit i is column BIRD_MASK_LEFT + i relative to the bird's x
+unsigned long long bird_mask[BIRD_HEIGHT];
+bool bird_mask_ready = false;
+
+// Pixels from the bird's position covered by any cached frame or the
+// collision box, set by initialize_bird_frames
+int bird_hull_left = 0;
+int bird_hull_right = BIRD_WIDTH - 1;
+int bird_hull_top = 0;
+int bird_hull_bottom = BIRD_HEIGHT - 1;
+
+// Body under the wing, shown where the wing was when it flaps up or
+// down. Wing pixels left of these are outside the body and turn
+// transparent instead. The wing covers rows y0 to y1 of these rects
+sprite_rect_t bird_wing_underlay[NUM_BIRD_WING_RECTS] = {
+    {   2,  6,  3, 17, BLACK  },
+    {   4,  6,  7, 17, YELLOW },
+    {   8,  8,  9, 15, YELLOW },
+};
 
-typedef short int color_t;
+// cos and sin of each tilt angle, times 256
+short bird_angle_cos[NUM_BIRD_ANGLES] = { 222, 247, 256, 247, 222, 181, 128, 66, 0 };
+short bird_angle_sin[NUM_BIRD_ANGLES] = { -128, -66, 0, 66, 128, 181, 222, 247, 256 };
+
+// The bird at one tilt and wing position. Bit i of opaque[y] is set
+// when pixels[y][i] is part of the bird. Collisions test the same bits
+typedef struct bird_frame {
+    color_t pixels[BIRD_CANVAS_SIZE][BIRD_CANVAS_SIZE];
+    unsigned long long opaque[BIRD_CANVAS_SIZE];
+} bird_frame_t;
+
+// Every tilt of every wing position, rendered once at startup so
+// drawing the bird is a single masked copy
+bird_frame_t bird_frames[NUM_WING_FRAMES][NUM_BIRD_ANGLES];
+bool bird_frames_ready = false;
+
+// Shaded pipe assets, built by initialize_pipe_sprites
+color_t pipe_head_sprite[PIPE_HEAD_HEIGHT + 1][PIPE_HEAD_WIDTH];
+color_t pipe_body_slice[PIPE_BODY_WIDTH];
+
+// Counts calls to next_frame, drives the wing animation
+unsigned int animation_tick = 0;
+
+typedef struct clip_rect {
+    // Inclusive bounds of the region draw_* calls may write to
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} clip_rect_t;
+
+// Tunable rules of a game. Every game carries its own copy so many
+// variants can be simulated side by side
+typedef struct game_config {
+    int pipe_void_height;
+
+    // Distance between two pipes. Below about a quarter of the screen
+    // plus a pipe, recycled pipes appear on screen
+    int pipe_spacing;
+    double bird_gravity;
+    double bird_jump_velocity;
+    int scroll_amount;
+} game_config_t;
+
+// The rules the game ships with
+game_config_t default_game_config = {
+    PIPE_VOID_HEIGHT,
+    PIPE_SPACING,
+    BIRD_GRAVITY,
+    BIRD_JUMP_VELOCITY,
+    SCROLL_VIEW_AMOUNT
+};
 
 typedef struct game_state {
-    grass_t grasses[NUM_GRASS_SQUARE];
-    pipe_t pipes[NUM_PIPES];
+    game_config_t config;
+    entity_store_t pipes;
     bird_t bird;
 
+    // How far the grass has scrolled, modulo GRASS_PERIOD. The position
+    // of every grass square follows from this
+    int grass_offset;
+
     // Can be any of the MODE_* in the #define
     int mode;
     int score;
     int best_score;
+
+    // State of the random number generator for pipe heights. It lives
+    // in the game state so a snapshot replays the same pipes
+    unsigned int seed;
+
+    // When true the bird is flown by the lookahead search instead of
+    // the keyboard
+    bool autopilot;
 } game_state_t;
 
+// Everything needed to rebuild the world of a game_state_t, packed into
+// 56 bytes. Pipes are always config.pipe_spacing apart in ring order, so
+// only the position of the leftmost pipe is stored. The config is not
+// part of it; a snapshot goes back into a game with the same config
+typedef struct world_snapshot {
+    double bird_y;
+    double bird_y_velocity;
+    unsigned int seed;
+    int score;
+    short pipe_head_x;
+
+    // Void centre of each pipe, indexed like game_state_t.pipes
+    unsigned char pipe_heights[NUM_PIPES];
+
+    // Index of the leftmost pipe
+    unsigned char pipe_head;
+
+    // Bit i is set once pipe i has been added to the score
+    unsigned char pipe_scored;
+    unsigned char grass_offset;
+
+    // bird_t wing_tick
+    unsigned char bird_wing_tick;
+
+    // entity_store_t count and kind of the game's pipes
+    unsigned char entity_count;
+    unsigned char entity_kinds[MAX_ENTITIES];
+} world_snapshot_t;
+
+// What an agent sees of a game after each env_step
+typedef struct observation {
+    double bird_y;
+    double bird_y_velocity;
+
+    // Offset from the bird to the centre of the void of the next pipe
+    // the bird still has to pass. RESOLUTION_X and 0 when there is none
+    int pipe_dx;
+    int pipe_dy;
+} observation_t;
+
+#if !defined(__arm__)
+// Games stepped together by a set of worker threads. Workers sleep
+// between steps and the calling thread works along with them
+typedef struct env_pool {
+    game_state_t *games;
+    int count;
+    observation_t *observations;
+    int *rewards;
+    bool *dones;
+
+    // Actions of the step in progress
+    const bool *actions;
+
+    pthread_t workers[ENV_POOL_MAX_THREADS];
+    int worker_count;
+
+    // Next chunk of ENV_POOL_CHUNK games to hand out this step
+    int next_chunk;
+
+    // Bumped to start a step. Workers that are done with it are counted
+    // in finished
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned int generation;
+    int finished;
+    bool stopping;
+} env_pool_t;
+#endif
+
+// State of both races at the start of one netplay frame
+typedef struct netplay_frame {
+    world_snapshot_t players[2];
+    bool alive[2];
+} netplay_frame_t;
+
+// Two birds racing on the same course. Each kiosk simulates both and
+// predicts the other's input until it arrives, rolling back when the
+// prediction was wrong
+typedef struct netplay {
+    // Index with NETPLAY_LOCAL and NETPLAY_REMOTE. Both start from the
+    // same seed so they see the same pipes
+    game_state_t players[2];
+    bool alive[2];
+
+    // Next frame to simulate
+    int frame;
+
+    // Next frame we expect the remote input for. Every frame before it
+    // has been confirmed
+    int remote_frame;
+
+    // Set once the other kiosk's bird is dead and we have all of its
+    // inputs up to then. Its later inputs don't matter
+    bool remote_done;
+
+    // Earliest simulated frame whose remote input turned out to be
+    // mispredicted, -1 when there is none. netplay_rollback fixes it
+    int rollback_frame;
+
+    // Ring buffers indexed by frame % NETPLAY_HISTORY
+    bool inputs[2][NETPLAY_HISTORY];
+    netplay_frame_t history[NETPLAY_HISTORY];
+
+    // How often a misprediction was rolled back, and how many frames
+    // were simulated again because of it
+    unsigned int rollbacks;
+    unsigned int resimulated_frames;
+} netplay_t;
+
+// Moves packets between the two kiosks. Packets may be lost,
+// duplicated or reordered
+typedef struct netplay_transport {
+    // Returns false when the packet could not be sent
+    bool (*send)(void *context, const void *data, int size);
+
+    // Copies one waiting packet into data and returns its size, or 0
+    // when nothing has arrived. Never waits
+    int (*receive)(void *context, void *data, int size);
+    void *context;
+} netplay_transport_t;
+
+// What kiosks send each other every frame
+typedef struct netplay_packet {
+    unsigned int magic;
+
+    // Inputs of the sender's bird for frames first_frame to
+    // first_frame + count - 1
+    int first_frame;
+    int count;
+    bool jumps[NETPLAY_PACKET_INPUTS];
+
+    // Number of frames of the receiver's inputs the sender has
+    int ack;
+
+    // The sender's bird is dead, so its inputs stop mattering
+    bool dead;
+
+    // The race is over for the sender
+    bool finished;
+} netplay_packet_t;
+
+// A race against another kiosk over a transport
+typedef struct netplay_session {
+    netplay_t net;
+    netplay_transport_t transport;
+
+    // Local inputs that may not have arrived yet, indexed by
+    // frame % NETPLAY_PACKET_INPUTS
+    bool local_inputs[NETPLAY_PACKET_INPUTS];
+
+    // Frames of local inputs the other kiosk has
+    int peer_ack;
+    bool peer_finished;
+
+    unsigned int packets_sent;
+    unsigned int packets_received;
+
+    // Frames that could not advance because the other kiosk was too far behind
+    unsigned int stalls;
+} netplay_session_t;
+
+#if !defined(__arm__)
+// Netplay over UDP on host builds
+typedef struct udp_transport {
+    int socket;
+    struct sockaddr_in peer;
+} udp_transport_t;
+#endif
+
+// Start of a replay. Positions inside a replay are offsets instead of
+// pointers, so a replay_t can be copied as one block. Its layout is
+// whatever the compiler makes of game_config_t and world_snapshot_t,
+// so only the same build can read those bytes back
+typedef struct replay_header {
+    // REPLAY_MAGIC when the rest of the replay is valid
+    unsigned int magic;
+    game_config_t config;
+    int frame_count;
+    int input_bytes;
+    int keyframe_count;
+
+    // Keyframe i is at frame i * keyframe_interval
+    int keyframe_interval;
+
+    // Frames since the last jump, written out with the next one
+    int idle_frames;
+
+    // Set once the input stream is full. Nothing after frame_count
+    // was recorded
+    bool full;
+} replay_header_t;
+
+typedef struct replay_keyframe {
+    int frame;
+
+    // Offset of the input record of the run this frame is part of, and
+    // how many frames of the run came before it
+    int input_offset;
+    int input_skip;
+
+    // State at the start of frame, before its input is applied
+    world_snapshot_t snapshot;
+} replay_keyframe_t;
+
+typedef struct replay {
+    replay_header_t header;
+    replay_keyframe_t keyframes[REPLAY_MAX_KEYFRAMES];
+
+    // One record per jump: how many frames without a jump came before
+    // it, 7 bits per byte, low bits first, with bit 7 set on every byte
+    // but the last
+    unsigned char inputs[REPLAY_MAX_INPUT_BYTES];
+} replay_t;
+
+// A position in a replay being played back
+typedef struct replay_cursor {
+    // Next frame to play
+    int frame;
+
+    // Offset of the next input record
+    int offset;
+
+    // Frames without a jump left before the next jump
+    int idle;
+} replay_cursor_t;
+
+// What a parameter sweep measured for one config
+typedef struct sweep_result {
+    game_config_t config;
+    int games;
+
+    // Games that ended with each score
+    int score_histogram[SWEEP_MAX_SCORE + 1];
+
+    // Games still alive at frame i * SWEEP_CURVE_STEP
+    int alive[SWEEP_CURVE_POINTS];
+} sweep_result_t;
+
+// Values the sweep grid tries for each parameter
+int sweep_pipe_void_heights[] = { 60, 70, 80, 90 };
+int sweep_pipe_spacings[] = { 100, 120, 140 };
+double sweep_bird_gravities[] = { 0.3, 0.4, 0.5 };
+double sweep_bird_jump_velocities[] = { 2.8, 3.2, 3.6 };
+int sweep_scroll_amounts[] = { 2, 3 };
+
+// One recorded draw_* call
+typedef struct draw_command {
+    // Any of the DRAW_* in the #define
+    int type;
+
+    // Pixels the command covers at most, already clipped (inclusive)
+    short x0;
+    short y0;
+    short x1;
+    short y1;
+
+    // DRAW_BLIT: the source pixel that lands on (x0, y0), and pixels
+    // from one source row to the next, 0 to stretch one row.
+    // DRAW_SPRITE: a bird_frame_t, DRAW_GLYPH: a glyph_mask_t, with
+    // canvas (0, 0) at (source_x, source_y).
+    // DRAW_BLEND: NULL for the whole rectangle, or rows of a mask like
+    // bird_mask with bit 0 of row 0 at (source_x, source_y). Masked
+    // blends with the same mask, color and alpha are blended once
+    // where they overlap, as one silhouette
+    const void *source;
+    int source_stride;
+    short source_x;
+    short source_y;
+
+    color_t color;
+    color_t outline_color;
+    int alpha;
+} draw_command_t;
+
+typedef struct display_list {
+    // In the order they were drawn, back to front
+    draw_command_t commands[MAX_DRAW_COMMANDS];
+    int count;
+
+    // Tiles touched by all commands together
+    int binned;
+
+    // Indices of the commands touching tile t are
+    // bins[bin_start[t]] to bins[bin_start[t + 1] - 1], back to front
+    unsigned short bins[MAX_BINNED_COMMANDS];
+    int bin_start[MAX_TILES_X * MAX_TILES_Y + 1];
+
+    // The tile being resolved. It stays in cache, unlike the frame buffer
+    color_t tile_pixels[TILE_HEIGHT][TILE_WIDTH];
+
+    // Frame buffer pixels written by resolve_display_list, in total
+    unsigned int pixels_written;
+} display_list_t;
+
+// A block of RGB565 pixels in memory that draw_* calls can target
+typedef struct surface {
+    // Address of the pixel at (0, 0)
+    char *base;
+    int width;
+    int height;
+
+    // Bytes from the start of one row to the next
+    int stride;
+
+    // Region that draw_* calls are allowed to write to
+    clip_rect_t clip;
+
+    // When set, draw_* calls are recorded here and only reach the
+    // pixels on resolve_display_list. At most MAX_TILES_X * TILE_WIDTH
+    // by MAX_TILES_Y * TILE_HEIGHT
+    display_list_t *list;
+} surface_t;
+
+// The display the game is shown on. When it is at least twice the
+// native resolution the game is drawn into native_frame and upscaled
+// by output_scale on every next_frame
+surface_t output_surface;
+surface_t native_surface;
+int output_scale = 1;
+
+// Where the game draws its frames: the VGA back buffer, or
+// native_frame when the output is upscaled
+surface_t screen_surface;
+short int native_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+
+// Commands of the frame being drawn on screen_surface
+display_list_t display_list;
+
+// The grass band at scroll offset 0, GRASS_STRIP_WIDTH pixels wide
+short int grass_strip[GRASS_STRIP_HEIGHT][GRASS_STRIP_WIDTH];
+
+typedef struct input_latency {
+    // When the oldest byte still in the PS/2 FIFO arrived
+    unsigned int arrival_time;
+    bool arrival_valid;
+
+    // The jump being tracked and how many buffer swaps are left until
+    // the frame that shows it is on screen. Zero when nothing is tracked
+    unsigned int jump_time;
+    int swaps_until_visible;
+
+    unsigned int histogram[LATENCY_NUM_BUCKETS];
+    unsigned int count;
+} input_latency_t;
+
+input_latency_t input_latency;
+
+typedef struct frame_governor {
+    // read_timer right after the last buffer swap
+    unsigned int last_swap;
+    bool started;
+
+    // Totals in timer ticks over every frame since start up
+    unsigned long long work_ticks;
+    unsigned long long sleep_ticks;
+    unsigned long long frame_ticks;
+    unsigned int frames;
+
+    // Frames that took long enough to miss at least one vsync
+    unsigned int missed;
+} frame_governor_t;
+
+frame_governor_t frame_governor;
+
+typedef struct audio_clip {
+    const short *samples;
+    int length;
+} audio_clip_t;
+
+typedef struct audio_voice {
+    // NULL when the voice is free
+    const audio_clip_t *clip;
+    int position;
+    short gain;
+} audio_voice_t;
+
+typedef struct audio_mixer {
+    audio_voice_t voices[NUM_AUDIO_VOICES];
+
+    // Whether the last top up wrote to the FIFO, and how many times it
+    // was found empty while a sound was still playing
+    bool playing;
+    unsigned int underruns;
+} audio_mixer_t;
+
+// PCM clips, built by initialize_audio
+short flap_samples[FLAP_CLIP_SAMPLES];
+short score_samples[SCORE_CLIP_SAMPLES];
+short hit_samples[HIT_CLIP_SAMPLES];
+audio_clip_t flap_clip = { flap_samples, FLAP_CLIP_SAMPLES };
+audio_clip_t score_clip = { score_samples, SCORE_CLIP_SAMPLES };
+audio_clip_t hit_clip = { hit_samples, HIT_CLIP_SAMPLES };
+
+audio_mixer_t audio_mixer;
+
+#if !defined(__arm__)
+// Stands in for the codec on host builds. Blocks go into a FIFO as deep
+// as the codec's, and audio_host_play takes samples out of it into a
+// mono WAV file the way the codec would play them, with silence where
+// the FIFO ran dry. With clocked set the codec plays as this thread's
+// CPU time passes instead, so the FIFO drains with the work done between
+// top ups but not while sleeping or while the host runs something else
+typedef struct host_audio {
+    FILE *wav;
+    short fifo[AUDIO_FIFO_DEPTH];
+    int fifo_start;
+    int fifo_count;
+    unsigned int samples_played;
+
+    // Samples played from an empty FIFO
+    unsigned int samples_dry;
+
+    bool clocked;
+    // CPU time in ns when clocked playing started, and samples played since
+    unsigned long long clock_start;
+    unsigned long long clock_samples;
+} host_audio_t;
+
+host_audio_t host_audio;
+
+// Stands in for the PS/2 port on host builds. host_press_key queues
+// bytes the way the keyboard would send them and ps2_read pops them
+typedef struct host_ps2 {
+    unsigned char fifo[PS2_FIFO_DEPTH];
+    int start;
+    int count;
+} host_ps2_t;
+
+host_ps2_t host_ps2;
+
+// The memory board_memory hands out on host builds. The host
+// controller reports the native resolution, so one frame each is enough
+char host_onchip[RESOLUTION_Y * NATIVE_STRIDE_PIXELS * sizeof(short int)];
+char host_sdram[RESOLUTION_Y * NATIVE_STRIDE_PIXELS * sizeof(short int)];
+char host_char_buffer[CHAR_BUFFER_SIZE];
+
+// Called by wait_for_vsync on host builds once the new frame is in
+// front, to show it or check it
+void (*host_frame_hook)() = NULL;
+
+// The game main is running, for host_frame_hook to look at
+const game_state_t *host_game = NULL;
+#endif
+
+// The last game played
+replay_t replay;
+
+// How this kiosk reaches the other one for netplay. The board has no
+// network stack of its own, so netplay is only offered once a
+// transport is installed here
+netplay_transport_t netplay_transport;
+netplay_session_t netplay_session;
+
 // Helpers
+int bird_angle_index(bird_t bird);
+color_t pipe_shade(int i, int width);
 bool bird_in_screen(bird_t bird);
-bool did_collide(bird_t bird, pipe_t pipe);
+unsigned long long bird_column_mask(int left, int x0, int x1);
+int bird_wing_frame(unsigned int tick);
+bool did_collide(bird_t bird, const entity_store_t *store, int i);
+int glyph_index(char c);
 bool is_game_over(game_state_t *game);
 bool is_out_of_bounds(int x, int min, int max);
-bool is_offscreen(int x, int y);
+bool is_offscreen(const surface_t *surface, int x, int y);
+bool is_clipped(const surface_t *surface, int x, int y);
+int text_width(const char *text, int scale);
 void change_mode(game_state_t *game);
+int random_pipe_y(game_state_t *game);
+void start_mode(game_state_t *game, int mode);
 
 // Game logic
-void do_bird_jump(bird_t* bird);
-void do_bird_velocity(bird_t* bird);
+void do_bird_jump(bird_t* bird, const game_config_t *config);
+void do_bird_velocity(bird_t* bird, const game_config_t *config);
+int do_game_fast_forward(game_state_t *game, int frames);
+void do_game_step(game_state_t *game, bool jump);
 void do_scroll_clouds(game_state_t *game);
 void do_scroll_grasses(game_state_t *game);
 void do_scroll_pipes(game_state_t *game);
 void do_scroll_view(game_state_t *game);
 void do_update_best_score(game_state_t *game);
 void do_update_score(game_state_t *game);
+bool is_jump_key_pressed();
+
+// Entity systems
+int collide_entities(const entity_store_t *store, bird_t bird);
+void cull_pipes(game_state_t *game);
+int do_swept_collision(game_state_t *game, bird_t start, int scroll);
+int entity_reach(int kind);
+void scroll_entities(entity_store_t *store, int dx);
+double sweep_entities(const entity_store_t *store, int x, double y, int height, double dx, double dy);
+bool sweep_interval(double a, double b, double *t0, double *t1);
+double sweep_pipe(const entity_store_t *store, int i, const sweep_box_t *box, double dx, double dy);
+
+// Snapshots and autopilot
+void restore_game_snapshot(game_state_t *game, const world_snapshot_t *snapshot);
+void save_game_snapshot(const game_state_t *game, world_snapshot_t *snapshot);
+bool autopilot_can_survive(const game_state_t *game, int frames);
+bool autopilot_should_jump(const game_state_t *game);
+
+// Environments
+void env_observe(const game_state_t *game, observation_t *observation);
+void fill_observation_rect(unsigned char grid[OBS_HEIGHT][OBS_WIDTH],
+    int x0, int y0, int x1, int y1, unsigned char value);
+void render_observation(const game_state_t *game, unsigned char grid[OBS_HEIGHT][OBS_WIDTH]);
+void render_observations(const game_state_t games[], int count,
+    unsigned char grids[][OBS_HEIGHT][OBS_WIDTH]);
+
+// Netplay
+bool netplay_advance(netplay_t *net, bool local_jump);
+bool netplay_race_over(const netplay_t *net);
+bool netplay_receive_remote_input(netplay_t *net, int frame, bool jump);
+void netplay_rollback(netplay_t *net);
+void netplay_simulate_frame(netplay_t *net);
+void netplay_start(netplay_t *net, unsigned int seed);
+bool netplay_session_frame(netplay_session_t *session, bool local_jump);
+bool netplay_session_finished(const netplay_session_t *session);
+void netplay_session_receive(netplay_session_t *session);
+void netplay_session_send(netplay_session_t *session);
+void netplay_session_start(netplay_session_t *session, const netplay_transport_t *transport, unsigned int seed);
+#if !defined(__arm__)
+int udp_transport_bind(udp_transport_t *udp, int port);
+void udp_transport_connect(udp_transport_t *udp, const char *address, int port, netplay_transport_t *transport);
+int udp_transport_receive(void *context, void *data, int size);
+bool udp_transport_send(void *context, const void *data, int size);
+#endif
+void env_reset(game_state_t *game, unsigned int seed);
+void env_reset_config(game_state_t *game, unsigned int seed, const game_config_t *config);
+void env_step(game_state_t games[], int count, const bool actions[],
+    observation_t observations[], int rewards[], bool dones[]);
+#if !defined(__arm__)
+void env_pool_run_chunks(env_pool_t *pool);
+void env_pool_start(env_pool_t *pool, game_state_t games[], int count,
+    observation_t observations[], int rewards[], bool dones[], int threads);
+void env_pool_step(env_pool_t *pool, const bool actions[]);
+void env_pool_stop(env_pool_t *pool);
+void *env_pool_worker(void *argument);
+#endif
+
+// Replay
+bool replay_next_input(const replay_t *replay, replay_cursor_t *cursor);
+void replay_read_run(const replay_t *replay, replay_cursor_t *cursor);
+bool replay_record_frame(replay_t *replay, const game_state_t *game, bool jump);
+int replay_seek(const replay_t *replay, int frame, game_state_t *game, replay_cursor_t *cursor);
+void replay_start(replay_t *replay, const game_state_t *game);
 
 // Draw code
-void draw_background(game_state_t *game);
-void redraw_background(game_state_t *game);
-void draw_bird(bird_t bird);
-void draw_digit(int digit, int x_offset, int x, int y, color_t color);
-void draw_flappy_bird(int x, int y, color_t line_color);
+void draw_background(const surface_t *surface, game_state_t *game);
+void redraw_background(const surface_t *surface, game_state_t *game);
+void redraw_background_behind_pipes(const surface_t *surface, game_state_t *game);
+void blit_rows(const surface_t *surface, const color_t *src, int src_stride, int width, int x, int y0, int y1);
+void draw_bird(const surface_t *surface, bird_t bird);
+void draw_bird_frame(const surface_t *surface, const bird_frame_t *frame, int x, int y);
+void draw_ghost_birds(const surface_t *surface, int x, int ghost_y[], int count, color_t color, int alpha);
+void draw_glyph(const surface_t *surface, int glyph, int x, int y, int scale, color_t color, color_t outline_color);
 void draw_game(game_state_t *game);
 void draw_game_over(game_state_t *game);
-void draw_grasses(grass_t grass[]);
-void draw_integer(int n, int x, int y, color_t color);
+void draw_grasses(const surface_t *surface, int grass_offset);
 void draw_menu(game_state_t *game, bird_t bird);
-void draw_pipe(pipe_t pipe);
-void draw_pipes(pipe_t pipes[]);
-void draw_pixel(int x, int y, color_t color);
-void draw_rect(int x0, int y0, int x1, int y1, color_t line_color);
-void draw_rect_outline(int x0, int y0, int x1, int y1, color_t line_color);
-void draw_score(int score, int x, int y);
-void draw_slanted_rect(int x0, int y0, int x1, int y1, color_t color);
-void draw_slanted_rect_outline(int x0, int y0, int x1, int y1, color_t line_color);
-void draw_word_game_over(int x, int y, color_t line_color);
+void draw_netplay(game_state_t *game);
+void draw_entities(const surface_t *surface, const entity_store_t *store);
+void draw_pipe(const surface_t *surface, const entity_store_t *store, int i);
+void draw_replay(game_state_t *game);
+void draw_hline(const surface_t *surface, int x0, int x1, int y, color_t color);
+void draw_pixel(const surface_t *surface, int x, int y, color_t color);
+void draw_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color);
+void draw_rect_outline(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color);
+void draw_score(const surface_t *surface, int score, int x, int y);
+void draw_slanted_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t color);
+void draw_slanted_line(const surface_t *surface, int x, int y0, int y1, color_t color);
+void draw_slanted_rect_outline(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color);
+void draw_text(const surface_t *surface, const char *text, int x, int y, int scale, color_t color, color_t outline_color);
+void draw_text_faded(const surface_t *surface, const char *text, int x, int y, int scale,
+    color_t color, color_t outline_color, int alpha);
+void draw_vline(const surface_t *surface, int x, int y0, int y1, color_t color);
+void fill_span(color_t *dst, int count, color_t color);
+color_t *surface_pixel(const surface_t *surface, int x, int y);
+
+// Deferred rendering
+unsigned int command_coverage(const draw_command_t *command, int tile_x, int y);
+void fill_runs(color_t *row, unsigned int bits, color_t color);
+draw_command_t *record_command(const surface_t *surface, int type, int x0, int y0, int x1, int y1);
+void resolve_display_list(const surface_t *surface);
+void resolve_tile(const surface_t *surface, const unsigned short *bin, int count,
+    int tile_x, int tile_y, unsigned int want[TILE_HEIGHT], bool load_uncovered,
+    const draw_command_t *merge);
+void shade_command(const draw_command_t *command, unsigned int bits, int tile_x, int y, color_t *row);
+unsigned int shift_row_mask(unsigned long long bits, int shift);
+
+// Blending
+color_t blend_pixel(color_t dst, color_t src, int alpha);
+void blend_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t color, int alpha);
+void blend_span_constant(color_t *dst, int count, color_t color, int alpha);
+void blend_span(color_t *dst, const color_t *src, const unsigned char *alpha, int count);
 
 // Erase text code
 void erase_game_over_texts();
@@ -289,16 +1248,81 @@ void erase_menu_texts();
 
 // Initializers 
 void initialize_bird(bird_t *bird);
+void initialize_bird_frames();
+void initialize_bird_mask();
+void initialize_font();
 void initialize_game(game_state_t *game);
-void initialize_grass(grass_t *grass, int i);
-void initialize_grasses(grass_t grasses[]);
-void initialize_pipe(pipe_t *pipe, int i);
-void initialize_pipes(pipe_t pipes[]);
+void initialize_grass_strip();
+void initialize_grasses(game_state_t *game);
+void initialize_pipe(game_state_t *game, int i);
+void initialize_pipe_sprites();
+void initialize_pipes(game_state_t *game);
+void initialize_audio();
+void initialize_frame_governor();
+void initialize_keyboard();
+void initialize_output_surface();
 void initialize_screen(game_state_t *game);
+void initialize_surface(surface_t *surface, char *base, int width, int height, int stride);
+void initialize_timer();
+
+// Platform
+char *board_memory(unsigned int address);
+int ps2_read();
+void ps2_write(int command);
+#if !defined(__arm__)
+void host_press_key(unsigned char code);
+#endif
+
+// Input latency
+unsigned int latency_percentile(int percent);
+void record_jump_applied(unsigned int arrival_time);
+void record_swap();
+void report_input_latency();
+void sample_keyboard_arrival();
+bool key_pending();
+unsigned int read_timer();
+
+// Audio
+int audio_fifo_space();
+void audio_fifo_write(const short *block, int count);
+int audio_phase_step(int frequency);
+void mix_audio_block(short *out, int count);
+void play_sound(const audio_clip_t *clip, short gain);
+void report_audio();
+short triangle_wave(unsigned int phase);
+void update_audio();
+#if !defined(__arm__)
+void audio_host_catch_up();
+unsigned long long audio_host_cpu_ns();
+void audio_host_play(int count);
+void audio_host_start_clock();
+void audio_wav_close();
+void audio_wav_header(unsigned char header[44], unsigned int samples);
+bool audio_wav_open(const char *path);
+#endif
+
+// Frame governor
+void acknowledge_interrupt();
+void governor_idle(unsigned int work_end);
+void governor_record_swap(unsigned int work_end, unsigned int wake_time);
+void report_frame_governor();
+void sleep_for_us(unsigned int us);
+
+// Parameter sweep
+void print_sweep_result(int index, const sweep_result_t *result);
+void run_parameter_sweep();
+void sweep_config(const game_config_t *config, int first_game, int count, sweep_result_t *result);
+bool sweep_bot_should_jump(const game_state_t *game, unsigned int *noise_seed);
+int sweep_score_percentile(const sweep_result_t *result, int percent);
 
 // Screen/VGA
 void clear_read_FIFO();
+void discard_keys();
 void next_frame();
+void reset_clip_rect(surface_t *surface);
+void set_clip_rect(surface_t *surface, int x0, int y0, int x1, int y1);
+void upscale_row(unsigned short *out, const unsigned short *in, int width, int scale);
+void upscale_surface(const surface_t *src, const surface_t *dst, int scale);
 void video_text(int x, int y, char * text_ptr);
 void wait_for_vsync();
 
@@ -307,7 +1331,23 @@ void wait_for_vsync();
 int main(void) {
     game_state_t game;
 
+    initialize_timer();
+
+#if PARAMETER_SWEEP
+    run_parameter_sweep();
+#endif
+
+    initialize_keyboard();
+#if FRAME_GOVERNOR
+    initialize_frame_governor();
+#endif
+#if AUDIO_ENABLED
+    initialize_audio();
+#endif
     initialize_game(&game);
+#if !defined(__arm__)
+    host_game = &game;
+#endif
     initialize_screen(&game);
 
     while (true) {
@@ -316,6 +1356,8 @@ int main(void) {
             case MODE_GAME: draw_game(&game); break;
             case MODE_GAME_OVER: draw_game_over(&game); break;
             case MODE_MENU: draw_menu(&game, game.bird); break;
+            case MODE_REPLAY: draw_replay(&game); break;
+            case MODE_NETPLAY: draw_netplay(&game); break;
 
             // By default, go to menu
             default: draw_menu(&game, game.bird); break;
@@ -344,42 +1386,48 @@ void initialize_sky() {
 }
 
 void initialize_game(game_state_t *game) {
+    game->config = default_game_config;
     game->mode = MODE_MENU;
     game->score = 0;
     game->best_score = 0;
+    game->seed = rand();
+    game->autopilot = false;
 
-    initialize_pipes(game->pipes);
-    initialize_grasses(game->grasses);
+    initialize_pipes(game);
+    initialize_grasses(game);
     initialize_bird(&game->bird);
     initialize_sky();
+    initialize_bird_mask();
+    initialize_bird_frames();
+    initialize_font();
+    initialize_grass_strip();
+    initialize_pipe_sprites();
 
 
     erase_game_over_texts();
     erase_menu_texts();
 }
 
-void initialize_pipe(pipe_t *pipe, int i) {
-    pipe->x = i * PIPE_SPACING + PIPE_START_X;
-    pipe->y = rand() % (RESOLUTION_Y - PIPE_VOID_HEIGHT * 2 - TOTAL_FLOOR_HEIGHT) + PIPE_VOID_HEIGHT;
-    pipe->width = PIPE_WIDTH;
-    pipe->void_height = PIPE_VOID_HEIGHT;
-    pipe->did_score_update = false;
-}
+void initialize_pipe(game_state_t *game, int i) {
+    entity_store_t *pipes = &game->pipes;
 
-void initialize_grass(grass_t *grass, int i) {
-    grass->right_x = i * GRASS_SQUARE_WIDTH;  
-    grass->left_x = grass->right_x - GRASS_SQUARE_WIDTH;
+    pipes->kind[i] = ENTITY_PIPE;
+    pipes->x[i] = i * game->config.pipe_spacing + PIPE_START_X;
+    pipes->y[i] = random_pipe_y(game);
+    pipes->width[i] = PIPE_WIDTH;
+    pipes->height[i] = game->config.pipe_void_height;
+    pipes->flags[i] = 0;
 }
 
-void initialize_grasses(grass_t grasses[]) {
-    for (int i = 0; i < NUM_GRASS_SQUARE; i++) {
-        initialize_grass(&grasses[i], i);
-    }
+void initialize_grasses(game_state_t *game) {
+    game->grass_offset = 0;
 }
 
-void initialize_pipes(pipe_t pipes[]) {
+void initialize_pipes(game_state_t *game) {
+    game->pipes.count = NUM_PIPES;
+
     for (int i = 0; i < NUM_PIPES; i++) {
-        initialize_pipe(&pipes[i], i);
+        initialize_pipe(game, i);
     }
 }
 
@@ -387,21 +1435,425 @@ void initialize_bird(bird_t *bird) {
     bird->x = BIRD_INITIAL_X;
     bird->y = BIRD_INITIAL_Y;
     bird->y_velocity = BIRD_INITIAL_VELOCITY;
+    bird->wing_tick = 0;
+}
+
+void initialize_timer() {
+#if defined(__arm__)
+    volatile int *timer_ptr = (int *)MPCORE_PRIV_TIMER;
+
+    // Free running: count down from the top, reload, no interrupts
+    *(timer_ptr) = 0xFFFFFFFF;
+    *(timer_ptr + 2) = 0b011;
+#endif
+}
+
+/**
+ * Synthesizes the sound effects. Tones are triangle waves from a phase
+ * accumulator and the hit is noise from a shift register, all with a
+ * linear fade out, so nothing needs floating point or a sample file.
+*/
+void initialize_audio() {
+    unsigned int phase = 0;
+    unsigned int noise = 0xACE1;
+
+    // Flap: a short chirp sweeping up from 400 to 900 Hz
+    for (int i = 0; i < FLAP_CLIP_SAMPLES; i++) {
+        int fade = FLAP_CLIP_SAMPLES - i;
+
+        phase += audio_phase_step(400 + 500 * i / FLAP_CLIP_SAMPLES);
+        flap_samples[i] = triangle_wave(phase) * fade / FLAP_CLIP_SAMPLES / 4;
+    }
+
+    // Score: two notes, B5 then E6
+    for (int i = 0; i < SCORE_CLIP_SAMPLES; i++) {
+        int fade = SCORE_CLIP_SAMPLES - i;
+        bool first_note = i < SCORE_CLIP_SAMPLES / 4;
+
+        phase += audio_phase_step(first_note ? 988 : 1319);
+        score_samples[i] = triangle_wave(phase) * fade / SCORE_CLIP_SAMPLES / 5;
+    }
+
+    // Hit: noise over a low thump
+    for (int i = 0; i < HIT_CLIP_SAMPLES; i++) {
+        int fade = HIT_CLIP_SAMPLES - i;
+
+        noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+        phase += audio_phase_step(110);
+
+        int sample = ((short) noise) / 2 + triangle_wave(phase) / 2;
+        hit_samples[i] = sample * fade / HIT_CLIP_SAMPLES / 3;
+    }
+}
+
+/**
+ * Routes the interval timer and PS/2 interrupts to this core. IRQs stay
+ * masked in the CPSR, so no handler ever runs: a pending interrupt is
+ * only there to wake the core from WFI, and acknowledge_interrupt
+ * clears it afterwards. Host builds just sleep and have nothing to
+ * route.
+*/
+void initialize_frame_governor() {
+#if defined(__arm__)
+    volatile int *cpu_interface = (int *)MPCORE_GIC_CPUIF;
+    volatile int *distributor = (int *)MPCORE_GIC_DIST;
+    volatile char *targets = (char *)(MPCORE_GIC_DIST + 0x800);
+    int irqs[] = { INTERVAL_TIMER_IRQ, PS2_IRQ, AUDIO_IRQ };
+
+    for (int i = 0; i < 3; i++) {
+        *(distributor + 0x40 + irqs[i] / 32) = 1 << (irqs[i] % 32);
+        targets[irqs[i]] = 1;
+    }
+
+    // Let every priority through, then enable both halves of the GIC
+    *(cpu_interface + 1) = 0xFFFF;
+    *(cpu_interface) = 1;
+    *(distributor) = 1;
+#endif
+}
+
+void initialize_keyboard() {
+#if defined(__arm__)
+    volatile int *PS2_ptr = (int *)PS2_BASE;
+
+    // Set RE so the RI bit of the control register tells us when the
+    // FIFO has data without having to pop it. The same bit raises
+    // PS2_IRQ, which initialize_frame_governor routes to this core so
+    // a key wakes it from WFI
+    *(PS2_ptr + 1) = 1;
+#endif
+}
+
+void initialize_bird_mask() {
+    if (bird_mask_ready) return;
+    bird_mask_ready = true;
+
+    for (int i = 0; i < NUM_BIRD_SPRITE_RECTS; i++) {
+        sprite_rect_t *rect = &bird_sprite[i];
+        int width = rect->x1 - rect->x0 + 1;
+        unsigned long long row_mask = ((1ULL << width) - 1) << (rect->x0 - BIRD_MASK_LEFT);
+
+        for (int y = rect->y0; y <= rect->y1; y++) {
+            bird_mask[y] |= row_mask;
+        }
+    }
+}
+
+/**
+ * Renders the grass at scroll offset 0 into grass_strip through a
+ * surface over the strip. Row 0 of the strip is screen row
+ * GRASS_STRIP_TOP, so the grass is drawn that many rows higher. The
+ * pattern repeats every GRASS_PERIOD pixels, so the columns past the
+ * screen are copies of the last period on it.
+*/
+void initialize_grass_strip() {
+    surface_t strip;
+
+    int grass_top = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - GRASS_STRIP_TOP;
+    int grass_bottom = RESOLUTION_Y - GROUND_THICKNESS - GRASS_STRIP_TOP;
+
+    // The first square starts one square left of the screen so its
+    // slanted rows still cover the left edge
+    int first_x = -GRASS_SQUARE_WIDTH;
+
+    initialize_surface(&strip, (char *) grass_strip, RESOLUTION_X, GRASS_STRIP_HEIGHT,
+        GRASS_STRIP_WIDTH * sizeof(color_t));
+
+    // Draw grass blocks
+    for (int left_x = first_x, i = 0; left_x <= RESOLUTION_X; left_x += GRASS_SQUARE_WIDTH, i++){
+        color_t grass_color = i % 2 == 0 ? LIGHT_GREEN : DARK_GREEN;
+
+        draw_slanted_rect(&strip,
+            left_x, 
+            grass_top, 
+            left_x + GRASS_SQUARE_WIDTH, 
+            grass_bottom, 
+            grass_color
+        );
+    }
+
+    // Draw grass block outlines    
+    for (int left_x = first_x; left_x <= RESOLUTION_X; left_x += GRASS_SQUARE_WIDTH){
+        draw_slanted_rect_outline(&strip,
+            left_x, 
+            grass_top - 1, 
+            left_x + GRASS_SQUARE_WIDTH, 
+            grass_bottom + 1, 
+            BLACK
+        );
+    }
+
+    for (int row = 0; row < GRASS_STRIP_HEIGHT; row++) {
+        memcpy(&grass_strip[row][RESOLUTION_X], &grass_strip[row][RESOLUTION_X - GRASS_PERIOD],
+            GRASS_PERIOD * sizeof(color_t));
+    }
+}
+
+/**
+ * Builds the shaded pipe head and body slice from PIPE_COLOR. The
+ * outline matches what draw_rect_outline used to draw around flat
+ * pipes: a black column on each side, and a black row above and below
+ * the head.
+*/
+void initialize_pipe_sprites() {
+    for (int y = 0; y <= PIPE_HEAD_HEIGHT; y++) {
+        for (int i = 0; i < PIPE_HEAD_WIDTH; i++) {
+            bool edge = y == 0 || y == PIPE_HEAD_HEIGHT || i == 0 || i == PIPE_HEAD_WIDTH - 1;
+
+            pipe_head_sprite[y][i] = edge ? BLACK : pipe_shade(i - 1, PIPE_HEAD_WIDTH - 2);
+        }
+    }
+
+    for (int i = 0; i < PIPE_BODY_WIDTH; i++) {
+        bool edge = i == 0 || i == PIPE_BODY_WIDTH - 1;
+
+        pipe_body_slice[i] = edge ? BLACK : pipe_shade(i - 1, PIPE_BODY_WIDTH - 2);
+    }
+}
+
+/**
+ * Renders the bird at every tilt and wing position into bird_frames.
+ * Each canvas pixel takes the sprite pixel its centre lands on when
+ * rotated back about the sprite's centre, in half pixel fixed point.
+ * The hull the swept collision test uses grows to cover every frame.
+*/
+void initialize_bird_frames() {
+    if (bird_frames_ready) return;
+    bird_frames_ready = true;
+
+    // The upright sprite, column i is BIRD_MASK_LEFT + i
+    color_t sprite[BIRD_HEIGHT][BIRD_WIDTH];
+    unsigned long long sprite_opaque[BIRD_HEIGHT] = { 0 };
+
+    for (int i = 0; i < NUM_BIRD_SPRITE_RECTS; i++) {
+        sprite_rect_t *rect = &bird_sprite[i];
+
+        for (int y = rect->y0; y <= rect->y1; y++) {
+            for (int x = rect->x0; x <= rect->x1; x++) {
+                sprite[y][x - BIRD_MASK_LEFT] = rect->color;
+                sprite_opaque[y] |= 1ULL << (x - BIRD_MASK_LEFT);
+            }
+        }
+    }
+
+    // The wing is every opaque pixel on the underlay's rows that is
+    // either under it or sticks out left of the body
+    unsigned long long wing_area[BIRD_HEIGHT] = { 0 };
+    int body_left = bird_wing_underlay[0].x0 - BIRD_MASK_LEFT;
+
+    for (int i = 0; i < NUM_BIRD_WING_RECTS; i++) {
+        sprite_rect_t *rect = &bird_wing_underlay[i];
+        int width = rect->x1 - rect->x0 + 1;
+
+        for (int y = rect->y0; y <= rect->y1; y++) {
+            wing_area[y] |= ((1ULL << width) - 1) << (rect->x0 - BIRD_MASK_LEFT);
+            wing_area[y] |= (1ULL << body_left) - 1;
+        }
+    }
+
+    for (int frame = 0; frame < NUM_WING_FRAMES; frame++) {
+        color_t pixels[BIRD_HEIGHT][BIRD_WIDTH];
+        unsigned long long opaque[BIRD_HEIGHT];
+        int wing_dy = (frame - 1) * WING_FLAP_DY;
+
+        memcpy(pixels, sprite, sizeof(pixels));
+        memcpy(opaque, sprite_opaque, sizeof(opaque));
+
+        // Lift the wing off and fill the body in under it
+        for (int y = 0; y < BIRD_HEIGHT; y++) {
+            opaque[y] &= ~wing_area[y];
+        }
+
+        for (int i = 0; i < NUM_BIRD_WING_RECTS; i++) {
+            sprite_rect_t *rect = &bird_wing_underlay[i];
+
+            for (int y = rect->y0; y <= rect->y1; y++) {
+                for (int x = rect->x0; x <= rect->x1; x++) {
+                    pixels[y][x - BIRD_MASK_LEFT] = rect->color;
+                    opaque[y] |= 1ULL << (x - BIRD_MASK_LEFT);
+                }
+            }
+        }
+
+        // Put the wing back wing_dy rows lower
+        for (int y = 0; y < BIRD_HEIGHT; y++) {
+            unsigned long long wing = sprite_opaque[y] & wing_area[y];
+            int to_y = y + wing_dy;
+
+            if (!wing || is_out_of_bounds(to_y, 0, BIRD_HEIGHT - 1)) continue;
+
+            for (int x = 0; x < BIRD_WIDTH; x++) {
+                if (wing & (1ULL << x)) pixels[to_y][x] = sprite[y][x];
+            }
+            opaque[to_y] |= wing;
+        }
+
+        for (int angle = 0; angle < NUM_BIRD_ANGLES; angle++) {
+            bird_frame_t *out = &bird_frames[frame][angle];
+            int c = bird_angle_cos[angle];
+            int s = bird_angle_sin[angle];
+
+            for (int cy = 0; cy < BIRD_CANVAS_SIZE; cy++) {
+                out->opaque[cy] = 0;
+
+                for (int cx = 0; cx < BIRD_CANVAS_SIZE; cx++) {
+                    // Twice the offset of the pixel centre from the
+                    // canvas centre, rotated back onto the sprite
+                    int dx = 2 * cx + 1 - BIRD_CANVAS_SIZE;
+                    int dy = 2 * cy + 1 - BIRD_CANVAS_SIZE;
+                    int sx = (c * dx + s * dy + 128) >> 8;
+                    int sy = (-s * dx + c * dy + 128) >> 8;
+                    int x = (sx + BIRD_WIDTH) >> 1;
+                    int y = (sy + BIRD_HEIGHT) >> 1;
+
+                    out->pixels[cy][cx] = BLACK;
+                    if (is_out_of_bounds(x, 0, BIRD_WIDTH - 1)) continue;
+                    if (is_out_of_bounds(y, 0, BIRD_HEIGHT - 1)) continue;
+                    if (!(opaque[y] & (1ULL << x))) continue;
+
+                    out->pixels[cy][cx] = pixels[y][x];
+                    out->opaque[cy] |= 1ULL << cx;
+                }
+
+                if (!out->opaque[cy]) continue;
+
+                int left = BIRD_CANVAS_LEFT + __builtin_ctzll(out->opaque[cy]);
+                int right = BIRD_CANVAS_LEFT + 63 - __builtin_clzll(out->opaque[cy]);
+
+                if (left < bird_hull_left) bird_hull_left = left;
+                if (right > bird_hull_right) bird_hull_right = right;
+                if (BIRD_CANVAS_TOP + cy < bird_hull_top) bird_hull_top = BIRD_CANVAS_TOP + cy;
+                if (BIRD_CANVAS_TOP + cy > bird_hull_bottom) bird_hull_bottom = BIRD_CANVAS_TOP + cy;
+            }
+        }
+    }
+}
+
+/**
+ * Builds glyph_masks: every glyph at every scale, and its outline
+*/
+void initialize_font() {
+    for (int scale = 1; scale <= FONT_MAX_SCALE; scale++) {
+        for (int glyph = 0; glyph < NUM_FONT_GLYPHS; glyph++) {
+            glyph_mask_t *mask = &glyph_masks[scale - 1][glyph];
+            int height = FONT_CHAR_HEIGHT * scale + 2;
+
+            memset(mask, 0, sizeof(glyph_mask_t));
+
+            // Each font pixel becomes a scale x scale block
+            for (int y = 0; y < FONT_CHAR_HEIGHT; y++) {
+                unsigned int row = 0;
+
+                for (int x = 0; x < FONT_CHAR_WIDTH; x++) {
+                    if (font_glyphs[glyph][y] & (1 << (FONT_CHAR_WIDTH - 1 - x))) {
+                        row |= ((1u << scale) - 1) << (1 + x * scale);
+                    }
+                }
+
+                for (int i = 0; i < scale; i++) {
+                    mask->fill[1 + y * scale + i] = row;
+                }
+            }
+
+            // Grow the glyph by a pixel in every direction and keep
+            // what was added
+            for (int y = 0; y < height; y++) {
+                unsigned int grown = mask->fill[y];
+
+                if (y > 0) grown |= mask->fill[y - 1];
+                if (y < height - 1) grown |= mask->fill[y + 1];
+
+                grown |= (grown << 1) | (grown >> 1);
+                mask->outline[y] = grown & ~mask->fill[y];
+            }
+        }
+    }
+}
+
+/**
+ * Reads the display resolution from the pixel buffer controller and
+ * picks the largest integer scale the native frame fits in
+*/
+void initialize_output_surface() {
+    int resolution = *(pixel_ctrl_ptr + 2);
+    int width = resolution & 0xFFFF;
+    int height = (resolution >> 16) & 0xFFFF;
+
+    // Fall back to the native size if the controller doesn't say
+    if (width < RESOLUTION_X || height < RESOLUTION_Y) {
+        width = RESOLUTION_X;
+        height = RESOLUTION_Y;
+    }
+
+    output_surface.width = width;
+    output_surface.height = height;
+
+    // The controller uses x-y addressing, so rows start at a power of two
+    output_surface.stride = 1;
+    while (output_surface.stride < width * 2) output_surface.stride <<= 1;
+
+    output_scale = width / RESOLUTION_X;
+    if (height / RESOLUTION_Y < output_scale) output_scale = height / RESOLUTION_Y;
+
+    initialize_surface(&native_surface, (char *) native_frame, RESOLUTION_X, RESOLUTION_Y,
+        NATIVE_STRIDE_PIXELS * sizeof(short int));
+}
+
+/**
+ * Describes a block of pixels, with the clip rectangle covering all of it
+ * @param surface
+ * @param base - address of the pixel at (0, 0)
+ * @param width
+ * @param height
+ * @param stride - bytes from one row to the next
+*/
+void initialize_surface(surface_t *surface, char *base, int width, int height, int stride) {
+    surface->base = base;
+    surface->width = width;
+    surface->height = height;
+    surface->stride = stride;
+    surface->list = NULL;
+    reset_clip_rect(surface);
 }
 
 void initialize_screen(game_state_t *game) {
+    initialize_output_surface();
+
+    if (output_scale > 1) {
+        int buffer_size = output_surface.stride * output_surface.height;
+
+        // Large frames don't fit in on-chip memory so both go in SDRAM.
+        // Clear them once, upscaling never touches the letterbox
+        *(pixel_ctrl_ptr + 1) = SDRAM_BASE;
+        wait_for_vsync();
+        *(pixel_ctrl_ptr + 1) = SDRAM_BASE + buffer_size;
+        memset(board_memory(SDRAM_BASE), 0, buffer_size * 2);
+
+        // Everything is drawn at native resolution from now on
+        screen_surface = native_surface;
+        draw_background(&screen_surface, game);
+#if DEFERRED_RENDERING
+        screen_surface.list = &display_list;
+#endif
+        return;
+    }
+
     /* set front pixel buffer to start of FPGA On-chip memory */
-    *(pixel_ctrl_ptr + 1) = 0xC8000000; // first store the address in the 
+    *(pixel_ctrl_ptr + 1) = FPGA_ONCHIP_BASE; // first store the address in the 
                                         // back buffer
     /* now, swap the front/back buffers, to set the front buffer location */
     wait_for_vsync();
-    /* initialize a boxer to the pixel buffer, used by drawing functions */
-    pixel_buffer_start = *pixel_ctrl_ptr;
-    draw_background(game); // pixel_buffer_start boxs to the pixel buffer
+    /* initialize a surface for the pixel buffer, used by drawing functions */
+    initialize_surface(&screen_surface, board_memory(*pixel_ctrl_ptr), RESOLUTION_X, RESOLUTION_Y,
+        NATIVE_STRIDE_PIXELS * sizeof(short int));
+    draw_background(&screen_surface, game); // screen_surface points to the pixel buffer
     /* set back pixel buffer to start of SDRAM memory */
-    *(pixel_ctrl_ptr + 1) = 0xC0000000;
-    pixel_buffer_start = *(pixel_ctrl_ptr + 1); // we draw on the back buffer
-    draw_background(game); // pixel_buffer_start boxs to the pixel buffer
+    *(pixel_ctrl_ptr + 1) = SDRAM_BASE;
+    screen_surface.base = board_memory(*(pixel_ctrl_ptr + 1)); // we draw on the back buffer
+    draw_background(&screen_surface, game); // screen_surface points to the pixel buffer
+#if DEFERRED_RENDERING
+    screen_surface.list = &display_list;
+#endif
 }
 
 
@@ -421,286 +1873,1194 @@ inline int clamp(int x, int min, int max) {
     return x;
 }
 
-inline void draw_pixel(int x, int y, color_t color) {
-    // Don't display offscreen pixels
-    if (is_offscreen(x, y)) return;
+inline void draw_pixel(const surface_t *surface, int x, int y, color_t color) {
+    // Don't display pixels outside of the clip rectangle
+    if (is_clipped(surface, x, y)) return;
+
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_FILL, x, y, x, y);
+        command->color = color;
+        return;
+    }
     
     // Actually plot pixel
-    *(color_t *)(pixel_buffer_start + (y << 10) + (x << 1)) = color;
+    *surface_pixel(surface, x, y) = color;
+}
+
+inline bool is_offscreen(const surface_t *surface, int x, int y) {
+    if (is_out_of_bounds(x, 0, surface->width - 1)) return true;
+    if (is_out_of_bounds(y, 0, surface->height - 1)) return true;
+    return false;
 }
 
-inline bool is_offscreen(int x, int y) {
-    if (is_out_of_bounds(x, 0, RESOLUTION_X - 1)) return true;
-    if (is_out_of_bounds(y, 0, RESOLUTION_Y - 1)) return true;
+inline bool is_clipped(const surface_t *surface, int x, int y) {
+    if (is_out_of_bounds(x, surface->clip.x0, surface->clip.x1)) return true;
+    if (is_out_of_bounds(y, surface->clip.y0, surface->clip.y1)) return true;
     return false;
 }
 
+// Index into font_glyphs of a character, -1 when there is no glyph
+int glyph_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return -1;
+}
+
+// Width in pixels of text drawn at scale, outline excluded
+int text_width(const char *text, int scale) {
+    int length = strlen(text);
+
+    if (length == 0) return 0;
+    return (length * (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) - FONT_CHAR_SPACING) * scale;
+}
+
+/**
+ * Restricts all following draw_* calls on a surface to the given
+ * rectangle. The rectangle is intersected with the surface so callers
+ * can pass bands or tiles that hang over the edge.
+ * @param surface
+ * @param x0 - top left corner
+ * @param y0 - top left corner
+ * @param x1 - bottom right corner (inclusive)
+ * @param y1 - bottom right corner (inclusive)
+*/
+void set_clip_rect(surface_t *surface, int x0, int y0, int x1, int y1) {
+    surface->clip.x0 = clamp(x0, 0, surface->width);
+    surface->clip.y0 = clamp(y0, 0, surface->height);
+    surface->clip.x1 = clamp(x1, -1, surface->width - 1);
+    surface->clip.y1 = clamp(y1, -1, surface->height - 1);
+}
+
+void reset_clip_rect(surface_t *surface) {
+    set_clip_rect(surface, 0, 0, surface->width - 1, surface->height - 1);
+}
+
+// Address of a pixel, no bounds checking
+inline color_t *surface_pixel(const surface_t *surface, int x, int y) {
+    return (color_t *)(surface->base + y * surface->stride) + x;
+}
+
 // No bounds checking
-inline void draw_pixel_optim(int x, int y, color_t color) {
-    *(color_t *)(pixel_buffer_start + (y << 10) + (x << 1)) = color;
+inline void draw_pixel_optim(const surface_t *surface, int x, int y, color_t color) {
+    *surface_pixel(surface, x, y) = color;
+}
+
+/**
+ * Fills count pixels with one color. Pixels are written in aligned
+ * pairs, or 8 at a time with NEON, with a single pixel before and
+ * after when the span does not start or end on a pair.
+ * @param dst - first pixel
+ * @param count - number of pixels, nothing is written if not positive
+ * @param color - color
+*/
+inline void fill_span(color_t *dst, int count, color_t color) {
+    if (count <= 0) return;
+
+    // Head: get to a 4 byte boundary
+    if ((uintptr_t) dst & 2) {
+        *dst++ = color;
+        count--;
+    }
+
+    unsigned int pair = (unsigned short) color * 0x10001u;
+    color_pair_t *out = (color_pair_t *) dst;
+    int pairs = count >> 1;
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    uint16x8_t octet = vdupq_n_u16(color);
+
+    // Get to a 16 byte boundary, then 8 pixels per store. Stored as
+    // 16 bit lanes so the vector store writes color_t's own type
+    for (; i < pairs && ((uintptr_t) (out + i) & 15); i++) out[i] = pair;
+    for (; i + 4 <= pairs; i += 4) vst1q_u16((uint16_t *) (dst + 2 * i), octet);
+#elif defined(__SSE2__)
+    __m128i quad = _mm_set1_epi32(pair);
+
+    for (; i + 4 <= pairs; i += 4) _mm_storeu_si128((__m128i *) (out + i), quad);
+#else
+    for (; i + 4 <= pairs; i += 4) {
+        out[i] = pair;
+        out[i + 1] = pair;
+        out[i + 2] = pair;
+        out[i + 3] = pair;
+    }
+#endif
+
+    for (; i < pairs; i++) out[i] = pair;
+
+    // Tail: the last pixel when an odd number is left
+    if (count & 1) dst[count - 1] = color;
+}
+
+// No bounds checking, draws x0..x1 inclusive on row y
+inline void draw_hline_optim(const surface_t *surface, int x0, int x1, int y, color_t color) {
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_FILL, x0, y, x1, y);
+        if (command) command->color = color;
+        return;
+    }
+
+    fill_span(surface_pixel(surface, x0, y), x1 - x0 + 1, color);
+}
+
+/**
+ * Draws a horizontal line clipped against the clip rectangle
+ * @param surface - surface to draw on
+ * @param x0 - left end
+ * @param x1 - right end (inclusive)
+ * @param y - row
+ * @param color - color
+*/
+inline void draw_hline(const surface_t *surface, int x0, int x1, int y, color_t color) {
+    if (is_out_of_bounds(y, surface->clip.y0, surface->clip.y1)) return;
+
+    x0 = clamp(x0, surface->clip.x0, surface->width);
+    x1 = clamp(x1, -1, surface->clip.x1);
+
+    draw_hline_optim(surface, x0, x1, y, color);
+}
+
+/**
+ * Draws a vertical line clipped against the clip rectangle
+ * @param surface - surface to draw on
+ * @param x - column
+ * @param y0 - top end
+ * @param y1 - bottom end (inclusive)
+ * @param color - color
+*/
+inline void draw_vline(const surface_t *surface, int x, int y0, int y1, color_t color) {
+    if (is_out_of_bounds(x, surface->clip.x0, surface->clip.x1)) return;
+
+    y0 = clamp(y0, surface->clip.y0, surface->height);
+    y1 = clamp(y1, -1, surface->clip.y1);
+
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_FILL, x, y0, x, y1);
+        if (command) command->color = color;
+        return;
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        draw_pixel_optim(surface, x, y, color);
+    }
+}
+
+/**
+ * Draws the line of pixels (x - i, y0 + i) for y0 + i <= y1, clipped
+ * against the clip rectangle. This is the left/right edge of a
+ * slanted rectangle.
+ * @param surface - surface to draw on
+ * @param x - column of the pixel on row y0
+ * @param y0 - top end
+ * @param y1 - bottom end (inclusive)
+ * @param color - color
+*/
+inline void draw_slanted_line(const surface_t *surface, int x, int y0, int y1, color_t color) {
+    // Solve surface->clip.x0 <= x - i <= surface->clip.x1 for i and intersect
+    // it with the rows of the clip rectangle
+    int i0 = x - surface->clip.x1;
+    int i1 = x - surface->clip.x0;
+
+    if (i0 < surface->clip.y0 - y0) i0 = surface->clip.y0 - y0;
+    if (i0 < 0) i0 = 0;
+    if (i1 > surface->clip.y1 - y0) i1 = surface->clip.y1 - y0;
+    if (i1 > y1 - y0) i1 = y1 - y0;
+
+    for (int i = i0; i <= i1; i++) {
+        if (surface->list) draw_pixel(surface, x - i, y0 + i, color);
+        else draw_pixel_optim(surface, x - i, y0 + i, color);
+    }
 }
 
 /**
  * Draws a rectangle where the coordinates are as specified
  * Note: We expect x0 < x1 and y0 < y1
+ * @param surface - surface to draw on
  * @param x0 - top left corner
  * @param y0 - top left corner
  * @param x1 - bottom right corner
  * @param y1 - bottom right corner
  * @param line_color - color
 */
-inline void draw_rect(int x0, int y0, int x1, int y1, color_t line_color) {
-
-    if (is_offscreen(x0, y0) && is_offscreen(x1, y1)) return;
+inline void draw_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color) {
+    int clipped_x0 = clamp(x0, surface->clip.x0, surface->width);
+    int clipped_x1 = clamp(x1, -1, surface->clip.x1);
+    int clipped_y0 = clamp(y0, surface->clip.y0, surface->height);
+    int clipped_y1 = clamp(y1, -1, surface->clip.y1);
 
-    int clamped_x0 = clamp(x0, 0, RESOLUTION_X - 1);
-    int clamped_x1 = clamp(x1, 0, RESOLUTION_X - 1);
-    int clamped_y0 = clamp(y0, 0, RESOLUTION_Y - 1);
-    int clamped_y1 = clamp(y1, 0, RESOLUTION_Y - 1);
+    if (clipped_x0 > clipped_x1) return;
 
-    for (int x = clamped_x0; x <= clamped_x1; x++) {
-        for (int y = clamped_y0; y <= clamped_y1; y++) {
-            draw_pixel_optim(x, y, line_color);
-        }
+    for (int y = clipped_y0; y <= clipped_y1; y++) {
+        draw_hline_optim(surface, clipped_x0, clipped_x1, y, line_color);
     }
 }
 
 /**
  * Draws a slanted rectangle where the coordinates are as specified
  * Note: We expect x0 < x1 and y0 < y1
+ * @param surface - surface to draw on
  * @param x0 - top left corner
  * @param y0 - top left corner
  * @param x1 - bottom right corner
  * @param y1 - bottom right corner
  * @param line_color - color
 */
-inline void draw_slanted_rect(int x0, int y0, int x1, int y1, color_t color) {
-    for (int x = x0; x <= x1; x++) {
-        for (int y = y0, i = 0; y <= y1; y++, i++) {
-            draw_pixel(x - i, y, color);
-        }
+inline void draw_slanted_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t color) {
+    int clipped_y0 = clamp(y0, surface->clip.y0, surface->height);
+    int clipped_y1 = clamp(y1, -1, surface->clip.y1);
+
+    // Each row is shifted one pixel to the left of the row above it
+    for (int y = clipped_y0; y <= clipped_y1; y++) {
+        int i = y - y0;
+        draw_hline(surface, x0 - i, x1 - i, y, color);
     }
 }
 
 /**
  * Draws a rectangle outline where the coordinates are as specified
  * Note: We expect x0 < x1 and y0 < y1
+ * @param surface - surface to draw on
  * @param x0 - top left corner
  * @param y0 - top left corner
  * @param x1 - bottom right corner
  * @param y1 - bottom right corner
  * @param line_color - color
 */
-void draw_rect_outline(int x0, int y0, int x1, int y1, color_t line_color) {
-    for (int x = x0; x <= x1; x++) {
-        draw_pixel(x, y0, line_color);
-        draw_pixel(x, y1, line_color);
-    }
-    for (int y = y0; y <= y1; y++) {
-        draw_pixel(x0, y, line_color);
-        draw_pixel(x1, y, line_color);
-    }
+void draw_rect_outline(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color) {
+    draw_hline(surface, x0, x1, y0, line_color);
+    draw_hline(surface, x0, x1, y1, line_color);
+    draw_vline(surface, x0, y0, y1, line_color);
+    draw_vline(surface, x1, y0, y1, line_color);
 }
 
 /**
  * Draws a slanted rectangle outline
  * Note: We expect x0 < x1 and y0 < y1
+ * @param surface - surface to draw on
  * @param x0 - top left corner
  * @param y0 - top left corner
  * @param x1 - bottom right corner
  * @param y1 - bottom right corner
  * @param line_color - color
 */
-void draw_slanted_rect_outline(int x0, int y0, int x1, int y1, color_t line_color) {
+void draw_slanted_rect_outline(const surface_t *surface, int x0, int y0, int x1, int y1, color_t line_color) {
     // TODO: known bug: we dont properly draw the horizontal lines of a slanted
     // rect in the right spots but this bug is not visually observable since
     // this is only used for drawing grass
-    for (int x = x0; x <= x1; x++) {
-        draw_pixel(x, y0, line_color);
-        draw_pixel(x, y1, line_color);
-    }
-    for (int y = y0, i = 0; y <= y1; y++, i++) {
-        draw_pixel(x0 - i, y, line_color);
-        draw_pixel(x1 - i, y, line_color);
-    }
+    draw_hline(surface, x0, x1, y0, line_color);
+    draw_hline(surface, x0, x1, y1, line_color);
+    draw_slanted_line(surface, x0, y0, y1, line_color);
+    draw_slanted_line(surface, x1, y0, y1, line_color);
 }
 
-void draw_pipe(pipe_t pipe) {
-    int x0 = pipe.x - (pipe.width / 2);
-    int x1 = pipe.x + (pipe.width / 2);
-
-    // Top Pipe
-    int y_screen_top = 0;
-    int y_top_pipe_edge = pipe.y - (pipe.void_height / 2);
-
-    // Bottom pipe
-    int y_bottom_pipe_edge = pipe.y + (pipe.void_height / 2);
-    int y_screen_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
+// Blending
+/**
+ * Scalar reference for every blend kernel. Each RGB565 channel moves
+ * from dst towards src by alpha / BLEND_OPAQUE, rounding towards dst.
+ * The vector kernels give bit-identical results.
+ * @param dst - color underneath
+ * @param src - color on top
+ * @param alpha - 0 to BLEND_OPAQUE
+*/
+inline color_t blend_pixel(color_t dst, color_t src, int alpha) {
+    int d = (unsigned short) dst;
+    int s = (unsigned short) src;
 
-    // Draw top pipe, outline, pipe head outline
-    draw_rect(x0, y_screen_top, x1, y_top_pipe_edge, PIPE_COLOR);
-    draw_rect_outline(x0, y_screen_top - 1, x1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, BLACK);
-    draw_rect_outline(x0 - 1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, x1 + 1, y_top_pipe_edge, BLACK);
+    int r = (d >> 11) + ((((s >> 11) - (d >> 11)) * alpha) >> 5);
+    int g = ((d >> 5) & 63) + (((((s >> 5) & 63) - ((d >> 5) & 63)) * alpha) >> 5);
+    int b = (d & 31) + ((((s & 31) - (d & 31)) * alpha) >> 5);
 
-    // Draw bottom pipe
-    draw_rect(x0, y_bottom_pipe_edge, x1, y_screen_bottom, PIPE_COLOR);
-    draw_rect_outline(x0, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, x1, y_screen_bottom, BLACK);
-    draw_rect_outline(x0 - 1, y_bottom_pipe_edge, x1 + 1, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, BLACK);
+    return (r << 11) | (g << 5) | b;
 }
 
-void draw_pipes(pipe_t pipes[]) {
-    for (int i = 0; i < NUM_PIPES; i++) {
-        draw_pipe(pipes[i]);
-    }
-}
-
-void draw_bird(bird_t bird){
-    //modified based on this to draw bird: https://www.pinterest.com/pin/559924166147577544/
-    draw_rect(bird.x - 2, bird.y + 10, bird.x - 1, bird.y + 13, BLACK);
-    draw_rect(bird.x, bird.y + 8, bird.x + 1, bird.y + 9, BLACK);
-	draw_rect(bird.x, bird.y + 10, bird.x + 1, bird.y + 11, WHITE);
-    draw_rect(bird.x, bird.y + 12, bird.x + 1, bird.y + 13, YELLOW);
-    draw_rect(bird.x, bird.y + 14, bird.x + 1, bird.y + 15, BLACK);
-    draw_rect(bird.x + 10, bird.y, bird.x + 21, bird.y + 1, BLACK);
-    draw_rect(bird.x + 6, bird.y + 2, bird.x + 9, bird.y + 3, BLACK);
-    draw_rect(bird.x + 16, bird.y + 2, bird.x + 17, bird.y + 3, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 2, bird.x + 19, bird.y + 3, BLACK);
-    draw_rect(bird.x + 20, bird.y + 2, bird.x + 21, bird.y + 3, WHITE);
-    draw_rect(bird.x + 22, bird.y + 2, bird.x + 23, bird.y + 3, BLACK); 
-    draw_rect(bird.x + 4, bird.y + 4, bird.x + 5, bird.y + 5, BLACK);
-    draw_rect(bird.x + 6, bird.y + 4, bird.x + 9, bird.y + 5, YELLOW);
-    draw_rect(bird.x + 16, bird.y + 4, bird.x + 17, bird.y + 9, BLACK);
-    draw_rect(bird.x + 22, bird.y + 4, bird.x + 23, bird.y + 5, WHITE);
-    draw_rect(bird.x + 24, bird.y + 4, bird.x + 25, bird.y + 5, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 6, bird.x + 7, bird.y + 7, BLACK);
-    draw_rect(bird.x + 8, bird.y + 6, bird.x + 9, bird.y + 7, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 10, bird.x + 19, bird.y + 11, BLACK);
-    draw_rect(bird.x + 18, bird.y + 4, bird.x + 21, bird.y + 9, WHITE); 
-    draw_rect(bird.x + 22, bird.y + 6, bird.x + 23, bird.y + 9, BLACK);
-    draw_rect(bird.x + 24, bird.y + 6, bird.x + 25, bird.y + 11, WHITE); 
-    draw_rect(bird.x + 26, bird.y + 6, bird.x + 27, bird.y + 11, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 8, bird.x + 7, bird.y + 13, WHITE);
-    draw_rect(bird.x + 8, bird.y + 8, bird.x + 9, bird.y + 9, BLACK);
-    draw_rect(bird.x + 10, bird.y + 2, bird.x + 15, bird.y + 9, YELLOW);
-    draw_rect(bird.x + 20, bird.y + 10, bird.x + 23, bird.y + 11, WHITE); 
-	draw_rect(bird.x + 8, bird.y + 10, bird.x + 9, bird.y + 11, WHITE);
-    draw_rect(bird.x + 8, bird.y + 12, bird.x + 9, bird.y + 13, YELLOW);
-    draw_rect(bird.x + 10, bird.y + 10, bird.x + 11, bird.y + 13, BLACK);
-    draw_rect(bird.x + 12, bird.y + 10, bird.x + 17, bird.y + 15, YELLOW); 
-    draw_rect(bird.x + 18, bird.y + 12, bird.x + 19, bird.y + 13, YELLOW);
-    draw_rect(bird.x + 20, bird.y + 12, bird.x + 29, bird.y + 13, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 14, bird.x + 7, bird.y + 15, YELLOW);
-    draw_rect(bird.x + 8, bird.y + 14, bird.x + 9, bird.y + 15, BLACK);
-    draw_rect(bird.x + 10, bird.y + 14, bird.x + 11, bird.y + 15, YELLOW);
-    draw_rect(bird.x + 18, bird.y + 14, bird.x + 19, bird.y + 15, BLACK);
-    draw_rect(bird.x + 20, bird.y + 14, bird.x + 29, bird.y + 15, ORANGE);
-    draw_rect(bird.x + 30, bird.y + 14, bird.x + 31, bird.y + 15, BLACK); 
-    draw_rect(bird.x + 2, bird.y + 16, bird.x + 7, bird.y + 17, BLACK);
-    draw_rect(bird.x + 8, bird.y + 16, bird.x + 15, bird.y + 19, SAND);
-    draw_rect(bird.x + 16, bird.y + 16, bird.x + 17, bird.y + 17, BLACK);
-    draw_rect(bird.x + 18, bird.y + 16, bird.x + 19, bird.y + 17, ORANGE);
-    draw_rect(bird.x + 20, bird.y + 16, bird.x + 29, bird.y + 17, BLACK); 
-    draw_rect(bird.x + 6, bird.y + 18, bird.x + 7, bird.y + 19, BLACK);
-    draw_rect(bird.x + 16, bird.y + 18, bird.x + 17, bird.y + 19, SAND);
-    draw_rect(bird.x + 18, bird.y + 18, bird.x + 19, bird.y + 19, BLACK);
-    draw_rect(bird.x + 20, bird.y + 18, bird.x + 27, bird.y + 19, ORANGE);
-    draw_rect(bird.x + 28, bird.y + 18, bird.x + 29, bird.y + 19, BLACK); 
-    draw_rect(bird.x + 8, bird.y + 20, bird.x + 11, bird.y + 21, BLACK);
-    draw_rect(bird.x + 12, bird.y + 20, bird.x + 19, bird.y + 21, SAND);
-    draw_rect(bird.x + 20, bird.y + 20, bird.x + 29, bird.y + 21, BLACK);
-    draw_rect(bird.x + 12, bird.y + 22, bird.x + 19, bird.y + 23, BLACK); 
-}
-
-void draw_digit(int digit, int x_offset, int x, int y, color_t color) {
-    for (int i = 0; i < SCORE_CHAR_WIDTH; i++) {
-        for (int j = 0; j < SCORE_CHAR_HEIGHT; j++) {
-            int x_start = x + (i + x_offset) * SCORE_CHAR_SCALE;
-            int y_start = y + j * SCORE_CHAR_SCALE;
-            int x_end = x_start + SCORE_CHAR_SCALE;
-            int y_end = y_start + SCORE_CHAR_SCALE;
-
-            if (digits_image[digit][j][i])
-                draw_rect(x_start, y_start, x_end, y_end, color);
-        }
-    }
-}
-
-void draw_integer(int n, int x, int y, color_t color) {
-    int x_offset = 0;
-    int digit_count = 0;
-
-    if (n == 0) return draw_digit(n, x_offset, x, y, color);
-
-    while (n > 0) {
-        int digit = n % 10;
-
-        draw_digit(digit, x_offset, x, y, color);
-
-        // Move to the left to render next digit. We have to move left
-        // since we get digits in reverse order so we display digits
-        // from right to left
-        x_offset -= SCORE_CHAR_WIDTH;
-
-        // Move on to next digit
-        n = n / 10;
-        digit_count++;
-    }
+#if defined(__ARM_NEON)
+// Blends 8 pixels per call, see blend_pixel
+static inline uint16x8_t blend8(uint16x8_t d, uint16x8_t s, int16x8_t a) {
+    int16x8_t dr = vreinterpretq_s16_u16(vshrq_n_u16(d, 11));
+    int16x8_t dg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(d, 5), vdupq_n_u16(63)));
+    int16x8_t db = vreinterpretq_s16_u16(vandq_u16(d, vdupq_n_u16(31)));
+    int16x8_t sr = vreinterpretq_s16_u16(vshrq_n_u16(s, 11));
+    int16x8_t sg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(s, 5), vdupq_n_u16(63)));
+    int16x8_t sb = vreinterpretq_s16_u16(vandq_u16(s, vdupq_n_u16(31)));
+
+    int16x8_t r = vaddq_s16(dr, vshrq_n_s16(vmulq_s16(vsubq_s16(sr, dr), a), 5));
+    int16x8_t g = vaddq_s16(dg, vshrq_n_s16(vmulq_s16(vsubq_s16(sg, dg), a), 5));
+    int16x8_t b = vaddq_s16(db, vshrq_n_s16(vmulq_s16(vsubq_s16(sb, db), a), 5));
+
+    return vorrq_u16(
+        vshlq_n_u16(vreinterpretq_u16_s16(r), 11),
+        vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(g), 5), vreinterpretq_u16_s16(b))
+    );
+}
+#elif defined(__SSE2__)
+// Blends 8 pixels per call, see blend_pixel
+static inline __m128i blend8(__m128i d, __m128i s, __m128i a) {
+    __m128i mask6 = _mm_set1_epi16(63);
+    __m128i mask5 = _mm_set1_epi16(31);
+
+    __m128i dr = _mm_srli_epi16(d, 11);
+    __m128i dg = _mm_and_si128(_mm_srli_epi16(d, 5), mask6);
+    __m128i db = _mm_and_si128(d, mask5);
+    __m128i sr = _mm_srli_epi16(s, 11);
+    __m128i sg = _mm_and_si128(_mm_srli_epi16(s, 5), mask6);
+    __m128i sb = _mm_and_si128(s, mask5);
+
+    __m128i r = _mm_add_epi16(dr, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sr, dr), a), 5));
+    __m128i g = _mm_add_epi16(dg, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sg, dg), a), 5));
+    __m128i b = _mm_add_epi16(db, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sb, db), a), 5));
+
+    return _mm_or_si128(_mm_slli_epi16(r, 11), _mm_or_si128(_mm_slli_epi16(g, 5), b));
 }
+#endif
 
 /**
- * Draws the score at x, y where x, y specifies the 
- * top-right corner of the text to be drawn. This means text
- * will appear to the left of x, y
- * @param score
- * @param x
- * @param y
+ * Blends one color over count pixels with the same alpha everywhere
+ * @param dst - pixels to blend into
+ * @param count - number of pixels
+ * @param color - color on top
+ * @param alpha - 0 to BLEND_OPAQUE
 */
-void draw_score(int score, int x, int y) {
-    // Cheat to get outline on score
-    draw_integer(score, x + 1, y + 1, BLACK);
-    draw_integer(score, x - 1, y - 1, BLACK);
-    draw_integer(score, x + 1, y - 1, BLACK);
-    draw_integer(score, x - 1, y + 1, BLACK);
+void blend_span_constant(color_t *dst, int count, color_t color, int alpha) {
+    int i = 0;
 
-    // Draw score
-    draw_integer(score, x, y, WHITE);
-}
+#if defined(__ARM_NEON)
+    uint16x8_t s = vdupq_n_u16(color);
+    int16x8_t a = vdupq_n_s16(alpha);
 
-void draw_game(game_state_t *game) {
-    clear_read_FIFO();
-    initialize_pipes(game->pipes);
-    initialize_bird(&game->bird);
+    for (; i + 8 <= count; i += 8) {
+        uint16_t *p = (uint16_t *)(dst + i);
+        vst1q_u16(p, blend8(vld1q_u16(p), s, a));
+    }
+#elif defined(__SSE2__)
+    __m128i s = _mm_set1_epi16(color);
+    __m128i a = _mm_set1_epi16(alpha);
 
-    while (!is_game_over(game)) {
-        redraw_background(game);
-        draw_pipes(game->pipes);
-        draw_bird(game->bird);
-        draw_score(game->score, SCORE_POS_X, SCORE_POS_Y);
+    for (; i + 8 <= count; i += 8) {
+        __m128i *p = (__m128i *)(dst + i);
+        _mm_storeu_si128(p, blend8(_mm_loadu_si128(p), s, a));
+    }
+#endif
 
-        do_scroll_view(game);
-        do_bird_jump(&game->bird);
-        do_bird_velocity(&game->bird);
-        do_update_score(game);
+    for (; i < count; i++) {
+        dst[i] = blend_pixel(dst[i], color, alpha);
+    }
+}
 
-        next_frame();
+/**
+ * Blends count source pixels over dst, each with its own alpha
+ * @param dst - pixels to blend into
+ * @param src - colors on top
+ * @param alpha - 0 to BLEND_OPAQUE for each pixel
+ * @param count - number of pixels
+*/
+void blend_span(color_t *dst, const color_t *src, const unsigned char *alpha, int count) {
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint16_t *p = (uint16_t *)(dst + i);
+        int16x8_t a = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(alpha + i)));
+        vst1q_u16(p, blend8(vld1q_u16(p), vld1q_u16((const uint16_t *)(src + i)), a));
     }
+#elif defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i *p = (__m128i *)(dst + i);
+        __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(alpha + i)), _mm_setzero_si128());
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128(p, blend8(_mm_loadu_si128(p), s, a));
+    }
+#endif
 
-    game->mode = MODE_GAME_OVER;
+    for (; i < count; i++) {
+        dst[i] = blend_pixel(dst[i], src[i], alpha[i]);
+    }
 }
 
-void draw_game_over(game_state_t *game) {
+/**
+ * Blends a color over a rectangle of a surface, clipped like draw_rect
+ * @param surface - surface to draw on
+ * @param x0 - top left corner
+ * @param y0 - top left corner
+ * @param x1 - bottom right corner
+ * @param y1 - bottom right corner
+ * @param color - color on top
+ * @param alpha - 0 to BLEND_OPAQUE
+*/
+void blend_rect(const surface_t *surface, int x0, int y0, int x1, int y1, color_t color, int alpha) {
+    int clipped_x0 = clamp(x0, surface->clip.x0, surface->width);
+    int clipped_x1 = clamp(x1, -1, surface->clip.x1);
+    int clipped_y0 = clamp(y0, surface->clip.y0, surface->height);
+    int clipped_y1 = clamp(y1, -1, surface->clip.y1);
+
+    if (clipped_x0 > clipped_x1) return;
+
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_BLEND, clipped_x0, clipped_y0, clipped_x1, clipped_y1);
+        if (command) {
+            command->source = NULL;
+            command->color = color;
+            command->alpha = alpha;
+        }
+        return;
+    }
+
+    for (int y = clipped_y0; y <= clipped_y1; y++) {
+        color_t *row = surface_pixel(surface, clipped_x0, y);
+        blend_span_constant(row, clipped_x1 - clipped_x0 + 1, color, alpha);
+    }
+}
+
+// Deferred rendering
+/**
+ * Appends a command covering x0..x1 by y0..y1 to the display list of a
+ * surface. The list is resolved first when it is full.
+ * @param surface - a surface with a display list
+ * @param type - any of the DRAW_* in the #define
+ * @return the command, for the caller to fill in, or NULL when the
+ * rectangle is empty
+*/
+draw_command_t *record_command(const surface_t *surface, int type, int x0, int y0, int x1, int y1) {
+    display_list_t *list = surface->list;
+
+    if (x0 > x1 || y0 > y1) return NULL;
+
+    int tiles = (x1 / TILE_WIDTH - x0 / TILE_WIDTH + 1) * (y1 / TILE_HEIGHT - y0 / TILE_HEIGHT + 1);
+
+    if (list->count == MAX_DRAW_COMMANDS || list->binned + tiles > MAX_BINNED_COMMANDS) {
+        resolve_display_list(surface);
+    }
+
+    draw_command_t *command = &list->commands[list->count++];
+    list->binned += tiles;
+
+    command->type = type;
+    command->x0 = x0;
+    command->y0 = y0;
+    command->x1 = x1;
+    command->y1 = y1;
+    return command;
+}
+
+/**
+ * Moves a row of a mask so that bit i is the pixel shift + i columns
+ * right of the left edge of a tile, and keeps the bits on the tile
+*/
+inline unsigned int shift_row_mask(unsigned long long bits, int shift) {
+    if (shift >= TILE_WIDTH || shift <= -64) return 0;
+
+    return shift >= 0 ? (unsigned int)(bits << shift) : (unsigned int)(bits >> -shift);
+}
+
+// Pixels of row y of the tile at tile_x a command covers, one bit each
+unsigned int command_coverage(const draw_command_t *command, int tile_x, int y) {
+    if (command->type == DRAW_SPRITE) {
+        const bird_frame_t *frame = command->source;
+        return shift_row_mask(frame->opaque[y - command->source_y], command->source_x - tile_x);
+    }
+
+    if (command->type == DRAW_GLYPH) {
+        const glyph_mask_t *mask = command->source;
+        int row = y - command->source_y;
+        return shift_row_mask(mask->fill[row] | mask->outline[row], command->source_x - tile_x);
+    }
+
+    if (command->type == DRAW_BLEND && command->source) {
+        const unsigned long long *rows = command->source;
+        return shift_row_mask(rows[y - command->source_y], command->source_x - tile_x);
+    }
+
+    return ~0u;
+}
+
+// Fills the pixels of a tile row whose bits are set
+void fill_runs(color_t *row, unsigned int bits, color_t color) {
+    unsigned long long runs = bits;
+
+    while (runs) {
+        int start = __builtin_ctzll(runs);
+        int length = __builtin_ctzll(~(runs >> start));
+
+        fill_span(row + start, length, color);
+        runs &= ~(((1ULL << length) - 1) << start);
+    }
+}
+
+/**
+ * Writes the pixels of an opaque command whose bits are set into row y
+ * of the tile buffer
+ * @param command
+ * @param bits - pixels to write, covered by the command
+ * @param tile_x - left of the tile
+ * @param y - row of the surface
+ * @param row - the tile buffer row for y
+*/
+void shade_command(const draw_command_t *command, unsigned int bits, int tile_x, int y, color_t *row) {
+    const color_t *src = NULL;
+
+    switch (command->type) {
+        case DRAW_FILL:
+            fill_runs(row, bits, command->color);
+            return;
+
+        case DRAW_GLYPH: {
+            const glyph_mask_t *mask = command->source;
+            int shift = command->source_x - tile_x;
+            unsigned int fill = shift_row_mask(mask->fill[y - command->source_y], shift) & bits;
+
+            // Fill wins where the outline of a neighbour overlaps it
+            fill_runs(row, fill, command->color);
+            fill_runs(row, bits & ~fill, command->outline_color);
+            return;
+        }
+
+        case DRAW_BLIT:
+            src = (const color_t *) command->source + (y - command->y0) * command->source_stride
+                + (tile_x - command->x0);
+            break;
+
+        case DRAW_SPRITE: {
+            const bird_frame_t *frame = command->source;
+            src = frame->pixels[y - command->source_y] + (tile_x - command->source_x);
+            break;
+        }
+    }
+
+    // Copy each run of set bits from the source
+    unsigned long long runs = bits;
+
+    while (runs) {
+        int start = __builtin_ctzll(runs);
+        int length = __builtin_ctzll(~(runs >> start));
+
+        memcpy(row + start, src + start, length * sizeof(color_t));
+        runs &= ~(((1ULL << length) - 1) << start);
+    }
+}
+
+/**
+ * Resolves the pixels of one tile into the tile buffer of the list,
+ * front to back. An opaque command only shades the pixels no command
+ * in front of it has taken, and the walk stops once every pixel is
+ * taken. Under a blend the commands behind it are resolved first, for
+ * just the pixels the blend still shows.
+ * @param surface - surface the commands were recorded on
+ * @param bin - indices of the commands touching the tile, back to front
+ * @param count - number of commands in bin
+ * @param tile_x - left of the tile
+ * @param tile_y - top of the tile
+ * @param want - pixels to resolve, one bit each per row. On return,
+ * the ones some command covered
+ * @param load_uncovered - read the pixels no command covers from the
+ * surface instead of leaving them out of want
+ * @param merge - a masked blend every pixel of want is under, or NULL.
+ * Masked blends like it are skipped, so each pixel is blended once
+*/
+void resolve_tile(const surface_t *surface, const unsigned short *bin, int count,
+    int tile_x, int tile_y, unsigned int want[TILE_HEIGHT], bool load_uncovered,
+    const draw_command_t *merge) {
+    display_list_t *list = surface->list;
+    color_t (*tile_pixels)[TILE_WIDTH] = list->tile_pixels;
+    unsigned int left[TILE_HEIGHT];
+    unsigned int any_left = 0;
+
+    for (int r = 0; r < TILE_HEIGHT; r++) {
+        left[r] = want[r];
+        any_left |= left[r];
+    }
+
+    for (int k = count - 1; k >= 0 && any_left; k--) {
+        const draw_command_t *command = &list->commands[bin[k]];
+        int r0 = clamp(command->y0 - tile_y, 0, TILE_HEIGHT);
+        int r1 = clamp(command->y1 - tile_y, -1, TILE_HEIGHT - 1);
+        int c0 = clamp(command->x0 - tile_x, 0, TILE_WIDTH);
+        int c1 = clamp(command->x1 - tile_x, -1, TILE_WIDTH - 1);
+
+        if (c0 > c1) continue;
+
+        unsigned int columns = (unsigned int)((2ULL << c1) - (1ULL << c0));
+
+        if (command->type == DRAW_BLEND) {
+            unsigned int under[TILE_HEIGHT] = { 0 };
+            unsigned int any_under = 0;
+
+            if (merge && command->source == merge->source && command->color == merge->color
+                && command->alpha == merge->alpha) continue;
+
+            for (int r = r0; r <= r1; r++) {
+                under[r] = columns & left[r];
+                if (under[r]) under[r] &= command_coverage(command, tile_x, tile_y + r);
+                any_under |= under[r];
+            }
+
+            if (!any_under) continue;
+
+            resolve_tile(surface, bin, k, tile_x, tile_y, under, true, command->source ? command : NULL);
+
+            for (int r = r0; r <= r1; r++) {
+                unsigned long long runs = under[r];
+
+                while (runs) {
+                    int start = __builtin_ctzll(runs);
+                    int length = __builtin_ctzll(~(runs >> start));
+
+                    blend_span_constant(tile_pixels[r] + start, length, command->color, command->alpha);
+                    runs &= ~(((1ULL << length) - 1) << start);
+                }
+
+                left[r] &= ~under[r];
+            }
+        } else {
+            for (int r = r0; r <= r1; r++) {
+                unsigned int bits = left[r] & columns;
+
+                if (bits) bits &= command_coverage(command, tile_x, tile_y + r);
+                if (!bits) continue;
+
+                shade_command(command, bits, tile_x, tile_y + r, tile_pixels[r]);
+                left[r] &= ~bits;
+            }
+        }
+
+        any_left = 0;
+        for (int r = 0; r < TILE_HEIGHT; r++) any_left |= left[r];
+    }
+
+    for (int r = 0; r < TILE_HEIGHT; r++) {
+        unsigned long long runs = left[r];
+
+        if (!load_uncovered) {
+            want[r] &= ~left[r];
+            continue;
+        }
+
+        while (runs) {
+            int start = __builtin_ctzll(runs);
+            int length = __builtin_ctzll(~(runs >> start));
+
+            memcpy(tile_pixels[r] + start, surface_pixel(surface, tile_x + start, tile_y + r),
+                length * sizeof(color_t));
+            runs &= ~(((1ULL << length) - 1) << start);
+        }
+    }
+}
+
+/**
+ * Draws everything recorded in the display list of a surface and
+ * empties it. Commands are binned by tile, and each tile is resolved
+ * in cache and then copied out, so every pixel some command covers is
+ * written to the surface once.
+ * @param surface
+*/
+void resolve_display_list(const surface_t *surface) {
+    display_list_t *list = surface->list;
+
+    if (list == NULL || list->count == 0) return;
+
+    int tiles_x = (surface->width + TILE_WIDTH - 1) / TILE_WIDTH;
+    int tiles_y = (surface->height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    int *bin_start = list->bin_start;
+    int next[MAX_TILES_X * MAX_TILES_Y];
+
+    // Count the commands of every tile, then place them in drawing order
+    memset(list->bin_start, 0, sizeof(list->bin_start));
+
+    for (int i = 0; i < list->count; i++) {
+        const draw_command_t *command = &list->commands[i];
+
+        for (int ty = command->y0 / TILE_HEIGHT; ty <= command->y1 / TILE_HEIGHT; ty++) {
+            for (int tx = command->x0 / TILE_WIDTH; tx <= command->x1 / TILE_WIDTH; tx++) {
+                bin_start[ty * tiles_x + tx + 1]++;
+            }
+        }
+    }
+
+    for (int t = 0; t < tiles_x * tiles_y; t++) {
+        bin_start[t + 1] += bin_start[t];
+        next[t] = bin_start[t];
+    }
+
+    for (int i = 0; i < list->count; i++) {
+        const draw_command_t *command = &list->commands[i];
+
+        for (int ty = command->y0 / TILE_HEIGHT; ty <= command->y1 / TILE_HEIGHT; ty++) {
+            for (int tx = command->x0 / TILE_WIDTH; tx <= command->x1 / TILE_WIDTH; tx++) {
+                list->bins[next[ty * tiles_x + tx]++] = i;
+            }
+        }
+    }
+
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int t = ty * tiles_x + tx;
+            int tile_x = tx * TILE_WIDTH;
+            int tile_y = ty * TILE_HEIGHT;
+            int width = clamp(surface->width - tile_x, 0, TILE_WIDTH);
+            int height = clamp(surface->height - tile_y, 0, TILE_HEIGHT);
+            unsigned int want[TILE_HEIGHT];
+
+            if (bin_start[t + 1] == bin_start[t]) continue;
+
+            for (int r = 0; r < TILE_HEIGHT; r++) {
+                want[r] = r < height ? (unsigned int)((1ULL << width) - 1) : 0;
+            }
+
+            resolve_tile(surface, &list->bins[bin_start[t]], bin_start[t + 1] - bin_start[t], tile_x, tile_y, want, false, NULL);
+
+            // Copy out what was resolved, whole rows of the tile at once
+            for (int r = 0; r < height; r++) {
+                color_t *out = surface_pixel(surface, tile_x, tile_y + r);
+                unsigned long long runs = want[r];
+
+                list->pixels_written += __builtin_popcount(want[r]);
+
+                if (runs == (1ULL << width) - 1) {
+                    memcpy(out, list->tile_pixels[r], width * sizeof(color_t));
+                    continue;
+                }
+
+                while (runs) {
+                    int start = __builtin_ctzll(runs);
+                    int length = __builtin_ctzll(~(runs >> start));
+
+                    memcpy(out + start, list->tile_pixels[r] + start, length * sizeof(color_t));
+                    runs &= ~(((1ULL << length) - 1) << start);
+                }
+            }
+        }
+
+        // A busy list takes longer to resolve than the FIFO lasts
+        update_audio();
+    }
+
+    list->count = 0;
+    list->binned = 0;
+}
+
+void draw_pipe(const surface_t *surface, const entity_store_t *store, int i) {
+    int x0 = store->x[i] - (store->width[i] / 2);
+    int x1 = store->x[i] + (store->width[i] / 2);
+
+    // Top Pipe
+    int y_screen_top = 0;
+    int y_top_pipe_edge = store->y[i] - (store->height[i] / 2);
+
+    // Bottom pipe
+    int y_bottom_pipe_edge = store->y[i] + (store->height[i] / 2);
+    int y_screen_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
+
+    // Draw top pipe body stretched down to the head, then the head
+    int y_top_head = y_top_pipe_edge - PIPE_HEAD_HEIGHT;
+    blit_rows(surface, pipe_body_slice, 0, PIPE_BODY_WIDTH, x0, y_screen_top, y_top_head - 1);
+    blit_rows(surface, pipe_head_sprite[0], PIPE_HEAD_WIDTH, PIPE_HEAD_WIDTH, x0 - 1, y_top_head, y_top_pipe_edge);
+
+    // Draw bottom pipe head, then the body down to the grass with an
+    // outline along the bottom
+    int y_bottom_head = y_bottom_pipe_edge + PIPE_HEAD_HEIGHT;
+    blit_rows(surface, pipe_head_sprite[0], PIPE_HEAD_WIDTH, PIPE_HEAD_WIDTH, x0 - 1, y_bottom_pipe_edge, y_bottom_head);
+    blit_rows(surface, pipe_body_slice, 0, PIPE_BODY_WIDTH, x0, y_bottom_head + 1, y_screen_bottom - 1);
+    draw_hline(surface, x0, x1, y_screen_bottom, BLACK);
+}
+
+/**
+ * Copies rows of pixels to a surface, clipped against its clip
+ * rectangle. Row i of src goes to line y0 + i. With a src_stride of 0
+ * the same row is stamped on every line, which stretches a one row
+ * slice into a column.
+ * @param surface - surface to draw on
+ * @param src - first pixel of the first row
+ * @param src_stride - pixels from one row of src to the next
+ * @param width - pixels per row
+ * @param x - left of the rows on the surface
+ * @param y0 - first line
+ * @param y1 - last line (inclusive)
+*/
+void blit_rows(const surface_t *surface, const color_t *src, int src_stride, int width, int x, int y0, int y1) {
+    int x0 = clamp(x, surface->clip.x0, surface->width);
+    int x1 = clamp(x + width - 1, -1, surface->clip.x1);
+    int clipped_y0 = clamp(y0, surface->clip.y0, surface->height);
+    int clipped_y1 = clamp(y1, -1, surface->clip.y1);
+
+    if (x0 > x1) return;
+
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_BLIT, x0, clipped_y0, x1, clipped_y1);
+        if (command) {
+            command->source = src + (clipped_y0 - y0) * src_stride + (x0 - x);
+            command->source_stride = src_stride;
+        }
+        return;
+    }
+
+    for (int y = clipped_y0; y <= clipped_y1; y++) {
+        const color_t *row = src + (y - y0) * src_stride + (x0 - x);
+
+        memcpy(surface_pixel(surface, x0, y), row, (x1 - x0 + 1) * sizeof(color_t));
+    }
+}
+
+void draw_entities(const surface_t *surface, const entity_store_t *store) {
+    for (int i = 0; i < store->count; i++) {
+        switch (store->kind[i]) {
+            case ENTITY_PIPE: draw_pipe(surface, store, i); break;
+        }
+    }
+}
+
+void draw_bird(const surface_t *surface, bird_t bird){
+    const bird_frame_t *frame = &bird_frames[bird_wing_frame(bird.wing_tick)][bird_angle_index(bird)];
+
+    draw_bird_frame(surface, frame, bird.x + BIRD_CANVAS_LEFT, (int) bird.y + BIRD_CANVAS_TOP);
+}
+
+/**
+ * Copies the opaque pixels of a bird frame to a surface, one span per
+ * run of opaque pixels, clipped against its clip rectangle
+ * @param surface - surface to draw on
+ * @param frame - frame to draw
+ * @param x - left of the canvas
+ * @param y - top of the canvas
+*/
+void draw_bird_frame(const surface_t *surface, const bird_frame_t *frame, int x, int y) {
+    // Canvas columns inside the clip rectangle
+    int first = clamp(surface->clip.x0 - x, 0, BIRD_CANVAS_SIZE);
+    int last = clamp(surface->clip.x1 - x, -1, BIRD_CANVAS_SIZE - 1);
+    unsigned long long columns = ((1ULL << (last + 1)) - 1) & ~((1ULL << first) - 1);
+
+    int y0 = clamp(y, surface->clip.y0, surface->height);
+    int y1 = clamp(y + BIRD_CANVAS_SIZE - 1, -1, surface->clip.y1);
+
+    if (surface->list) {
+        draw_command_t *command = record_command(surface, DRAW_SPRITE, x + first, y0, x + last, y1);
+        if (command) {
+            command->source = frame;
+            command->source_x = x;
+            command->source_y = y;
+        }
+        return;
+    }
+
+    for (int row_y = y0; row_y <= y1; row_y++) {
+        int row = row_y - y;
+        unsigned long long mask = frame->opaque[row] & columns;
+        color_t *line = surface_pixel(surface, 0, row_y);
+
+        // Copy each run of set bits as one span
+        while (mask) {
+            int start = __builtin_ctzll(mask);
+            int length = __builtin_ctzll(~(mask >> start));
+
+            memcpy(line + x + start, &frame->pixels[row][start], length * sizeof(color_t));
+            mask &= ~(((1ULL << length) - 1) << start);
+        }
+    }
+}
+
+/**
+ * Draws many ghost birds as see-through silhouettes in one pass over
+ * the scanlines. All ghosts share the same x, like every bird in the
+ * game, so the silhouettes covering a scanline can be OR-ed together
+ * from bird_mask and blended as a few spans. Ghosts at the same height
+ * merge for free, overlapping ghosts are blended once, and the cost per
+ * scanline does not grow with the number of ghosts. On a display list
+ * each ghost height is one masked blend, which the list merges the same
+ * way when it is resolved.
+ * @param surface - surface to draw on
+ * @param x - x of every ghost
+ * @param ghost_y - y of each ghost, in any order
+ * @param count - number of ghosts
+ * @param color - silhouette color
+ * @param alpha - 0 to BLEND_OPAQUE
+*/
+void draw_ghost_birds(const surface_t *surface, int x, int ghost_y[], int count, color_t color, int alpha) {
+    // Bucket ghosts by their top row. Rows start BIRD_HEIGHT - 1 above
+    // the surface so partly visible ghosts are kept
+    bool has_ghost[BIRD_HEIGHT - 1 + surface->height];
+    int first_top = surface->height;
+    int last_top = -BIRD_HEIGHT;
+
+    memset(has_ghost, 0, sizeof(has_ghost));
+
+    for (int i = 0; i < count; i++) {
+        int top = ghost_y[i];
+
+        // Entirely above or below the surface
+        if (is_out_of_bounds(top, 1 - BIRD_HEIGHT, surface->height - 1)) continue;
+
+        has_ghost[top + BIRD_HEIGHT - 1] = true;
+        if (top < first_top) first_top = top;
+        if (top > last_top) last_top = top;
+    }
+
+    int y0 = clamp(first_top, surface->clip.y0, surface->height);
+    int y1 = clamp(last_top + BIRD_HEIGHT - 1, -1, surface->clip.y1);
+    int left = x + BIRD_MASK_LEFT;
+
+    if (surface->list) {
+        int x0 = clamp(left, surface->clip.x0, surface->width);
+        int x1 = clamp(left + BIRD_WIDTH - 1, -1, surface->clip.x1);
+
+        for (int top = first_top; top <= last_top && x0 <= x1; top++) {
+            if (!has_ghost[top + BIRD_HEIGHT - 1]) continue;
+
+            draw_command_t *command = record_command(surface, DRAW_BLEND, x0, clamp(top, y0, y1 + 1),
+                x1, clamp(top + BIRD_HEIGHT - 1, y0 - 1, y1));
+
+            if (command) {
+                command->source = bird_mask;
+                command->source_x = left;
+                command->source_y = top;
+                command->color = color;
+                command->alpha = alpha;
+            }
+        }
+        return;
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        unsigned long long mask = 0;
+
+        // Every ghost whose top is at most BIRD_HEIGHT - 1 rows above
+        for (int row = 0; row < BIRD_HEIGHT; row++) {
+            if (has_ghost[y - row + BIRD_HEIGHT - 1]) mask |= bird_mask[row];
+        }
+
+        // Blend each run of set bits as one span
+        while (mask) {
+            int start = __builtin_ctzll(mask);
+            int length = __builtin_ctzll(~(mask >> start));
+
+            blend_rect(surface, left + start, y, left + start + length - 1, y, color, alpha);
+            mask &= ~(((1ULL << length) - 1) << start);
+        }
+    }
+}
+
+/**
+ * Draws one glyph and its outline, one pass over the rows of its mask
+ * @param surface - surface to draw on
+ * @param glyph - index into font_glyphs
+ * @param x - left of the glyph, the outline starts a pixel further left
+ * @param y - top of the glyph, the outline starts a pixel higher
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+*/
+void draw_glyph(const surface_t *surface, int glyph, int x, int y, int scale, color_t color, color_t outline_color) {
+    glyph_mask_t *mask = &glyph_masks[scale - 1][glyph];
+    int height = FONT_CHAR_HEIGHT * scale + 2;
+
+    if (surface->list) {
+        int x0 = clamp(x - 1, surface->clip.x0, surface->width);
+        int x1 = clamp(x + FONT_CHAR_WIDTH * scale, -1, surface->clip.x1);
+        int y0 = clamp(y - 1, surface->clip.y0, surface->height);
+        int y1 = clamp(y + height - 2, -1, surface->clip.y1);
+        draw_command_t *command = record_command(surface, DRAW_GLYPH, x0, y0, x1, y1);
+
+        if (command) {
+            command->source = mask;
+            command->source_x = x - 1;
+            command->source_y = y - 1;
+            command->color = color;
+            command->outline_color = outline_color;
+        }
+        return;
+    }
+
+    for (int row = 0; row < height; row++) {
+        int row_y = y - 1 + row;
+        unsigned int fill = mask->fill[row];
+        unsigned int outline = mask->outline[row];
+
+        // Write each run of set bits as one span
+        while (outline) {
+            int start = __builtin_ctz(outline);
+            int length = __builtin_ctz(~(outline >> start));
+
+            draw_hline(surface, x - 1 + start, x - 2 + start + length, row_y, outline_color);
+            outline &= ~(((1u << length) - 1) << start);
+        }
+
+        while (fill) {
+            int start = __builtin_ctz(fill);
+            int length = __builtin_ctz(~(fill >> start));
+
+            draw_hline(surface, x - 1 + start, x - 2 + start + length, row_y, color);
+            fill &= ~(((1u << length) - 1) << start);
+        }
+    }
+}
+
+/**
+ * Draws outlined text. Digits, capital letters and spaces are drawn,
+ * anything else leaves a blank
+ * @param surface - surface to draw on
+ * @param text - zero terminated
+ * @param x - left of the first glyph
+ * @param y - top of the glyphs
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+*/
+void draw_text(const surface_t *surface, const char *text, int x, int y, int scale, color_t color, color_t outline_color) {
+    int advance = (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) * scale;
+
+    for (; *text; text++, x += advance) {
+        int glyph = glyph_index(*text);
+
+        if (glyph >= 0) draw_glyph(surface, glyph, x, y, scale, color, outline_color);
+    }
+}
+
+/**
+ * Blends outlined text over what is already drawn, like draw_text with
+ * every pixel of the glyphs and their outlines at alpha. Each row of
+ * the text is gathered into one span so the outlines of neighbouring
+ * glyphs are blended once where they share a column
+ * @param surface - surface to draw on
+ * @param text - zero terminated, at most RESOLUTION_X pixels wide
+ * @param x - left of the first glyph
+ * @param y - top of the glyphs
+ * @param scale - 1 to FONT_MAX_SCALE
+ * @param color - glyph color
+ * @param outline_color - outline color
+ * @param alpha - 0 to BLEND_OPAQUE
+*/
+void draw_text_faded(const surface_t *surface, const char *text, int x, int y, int scale,
+    color_t color, color_t outline_color, int alpha) {
+    int advance = (FONT_CHAR_WIDTH + FONT_CHAR_SPACING) * scale;
+    int height = FONT_CHAR_HEIGHT * scale + 2;
+    int x0 = clamp(x - 1, surface->clip.x0, surface->width);
+    int x1 = clamp(x + text_width(text, scale), -1, surface->clip.x1);
+    color_t src[RESOLUTION_X];
+    unsigned char weight[RESOLUTION_X];
+
+    x1 = clamp(x1, -1, x0 + RESOLUTION_X - 1);
+    if (x0 > x1) return;
+
+    // Blending reads the pixels underneath, so they have to be drawn first
+    resolve_display_list(surface);
+
+    for (int row = 0; row < height; row++) {
+        int row_y = y - 1 + row;
+
+        if (row_y < surface->clip.y0 || row_y > surface->clip.y1) continue;
+
+        memset(src, 0, sizeof(src));
+        memset(weight, 0, sizeof(weight));
+
+        // Outlines first, so fill wins where the outline of a neighbour overlaps it
+        for (int pass = 0; pass < 2; pass++) {
+            int glyph_x = x;
+
+            for (const char *c = text; *c; c++, glyph_x += advance) {
+                int glyph = glyph_index(*c);
+
+                if (glyph < 0) continue;
+
+                const glyph_mask_t *mask = &glyph_masks[scale - 1][glyph];
+                unsigned int bits = pass ? mask->fill[row] : mask->outline[row];
+
+                while (bits) {
+                    int i = glyph_x - 1 + __builtin_ctz(bits) - x0;
+
+                    if (i >= 0 && i <= x1 - x0) {
+                        src[i] = pass ? color : outline_color;
+                        weight[i] = alpha;
+                    }
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        blend_span(surface_pixel(surface, x0, row_y), src, weight, x1 - x0 + 1);
+    }
+}
+
+/**
+ * Draws the score at x, y where x, y specifies the 
+ * top-right corner of the text to be drawn. This means text
+ * will appear to the left of x, y
+ * @param surface - surface to draw on
+ * @param score
+ * @param x
+ * @param y
+*/
+void draw_score(const surface_t *surface, int score, int x, int y) {
+    char text[12];
+
+    snprintf(text, sizeof(text), "%d", score);
+    draw_text(surface, text, x - text_width(text, SCORE_CHAR_SCALE), y, SCORE_CHAR_SCALE, WHITE, BLACK);
+}
+
+void draw_game(game_state_t *game) {
+    surface_t *screen = &screen_surface;
+
+    clear_read_FIFO();
+    game->seed = rand();
+    initialize_pipes(game);
+    initialize_bird(&game->bird);
+    replay_start(&replay, game);
+
+    while (!is_game_over(game)) {
+        redraw_background_behind_pipes(screen, game);
+        draw_entities(screen, &game->pipes);
+        draw_bird(screen, game->bird);
+        draw_score(screen, game->score, SCORE_POS_X, SCORE_POS_Y);
+
+        // The autopilot decides from the state do_game_step starts from.
+        // Keys pressed meanwhile are thrown away, or the governor would
+        // keep waking up for them and stop idling
+        bool jump;
+        if (game->autopilot) {
+            discard_keys();
+            jump = autopilot_should_jump(game);
+        } else {
+            jump = is_jump_key_pressed();
+        }
+
+        replay_record_frame(&replay, game, jump);
+
+        int score = game->score;
+
+        do_scroll_grasses(game);
+        do_game_step(game, jump);
+
+        // Sounds are played here rather than in the game logic, which
+        // the autopilot and netplay also run speculatively
+        if (jump) play_sound(&flap_clip, AUDIO_FULL_GAIN);
+        if (game->score > score) play_sound(&score_clip, AUDIO_FULL_GAIN);
+
+        next_frame();
+    }
+
+    play_sound(&hit_clip, AUDIO_FULL_GAIN);
+    game->mode = MODE_GAME_OVER;
+}
+
+void draw_game_over(game_state_t *game) {
+    surface_t *screen = &screen_surface;
+
+    int frame = 0;
+
     clear_read_FIFO();
     do_update_best_score(game);
     while (game -> mode == MODE_GAME_OVER) {
-        redraw_background(game);
+        redraw_background(screen, game);
+
+        // Dim the sky behind the panel so the text stands out
+        blend_rect(screen, 0, 0, RESOLUTION_X - 1, SKY_THICKNESS - 1, BLACK, GAME_OVER_DIM_ALPHA);
 
-        //get the outline of "GAME OVER"
-        draw_word_game_over(74, 30, BLACK);
-		draw_word_game_over(76, 30, BLACK);
-		draw_word_game_over(75, 29, BLACK);
-		draw_word_game_over(75, 31, BLACK);
         //display "GAME OVER"
-        draw_word_game_over(75, 30, WHITE);
+        char text_for_title[] = "GAME OVER";
+        int title_x = (RESOLUTION_X - text_width(text_for_title, TITLE_CHAR_SCALE)) / 2;
+        int title_alpha = clamp(frame * BLEND_OPAQUE / GAME_OVER_FADE_FRAMES, 0, BLEND_OPAQUE);
+
+        if (title_alpha < BLEND_OPAQUE) {
+            draw_text_faded(screen, text_for_title, title_x, 30, TITLE_CHAR_SCALE, WHITE, BLACK, title_alpha);
+        } else {
+            draw_text(screen, text_for_title, title_x, 30, TITLE_CHAR_SCALE, WHITE, BLACK);
+        }
 
         //display "SCORE: "
         //display "BEST: "
@@ -711,349 +3071,2472 @@ void draw_game_over(game_state_t *game) {
         char text_for_restart[] = "PRESS ENTER TO PLAY AGAIN\0";
         char text_for_menu[] = "PRESS BACKSPACE TO GO TO MENU\0";
 
-        //use character buffer
-        video_text(27, 19, text_for_score);
-        video_text(27, 27, text_for_best_score);
-        video_text(27, 35, text_for_restart);
-        video_text(25, 43, text_for_menu);
+        //use character buffer
+        video_text(27, 19, text_for_score);
+        video_text(27, 27, text_for_best_score);
+        video_text(27, 35, text_for_restart);
+        video_text(25, 43, text_for_menu);
+
+        // button shape for press enter to play again
+        // and press backspace to go to menu
+        draw_rect(screen, 70, 130, RESOLUTION_X - 70, 130 + 22, ORANGE);
+        draw_rect(screen, 70, 162, RESOLUTION_X - 70, 162 + 22, ORANGE);
+        draw_rect_outline(screen, 70, 130, RESOLUTION_X - 70, 130 + 22, BLACK);
+        draw_rect_outline(screen, 70, 162, RESOLUTION_X - 70, 162 + 22, BLACK);
+
+        //sisplay score and best score
+        draw_score(screen, game->score, 206, 67);
+        draw_score(screen, game->best_score, 206, 100);
+
+        //check whether Enter or Back has pressed
+        change_mode(game);
+        do_scroll_grasses(game);
+        next_frame();
+        frame++;
+
+        // Bots restart on their own so kiosks can be soak-tested unattended
+        if (game->autopilot && game->mode == MODE_GAME_OVER) {
+            start_mode(game, MODE_GAME);
+        }
+    }
+}
+
+/**
+ * Plays back the game recorded in replay. The arrow keys jump
+ * REPLAY_SCRUB_FRAMES frames back or ahead, and enter or backspace go
+ * back to the game over screen. The replay is played in a copy of the
+ * game so the scores of the session are left alone.
+ * @param game
+*/
+void draw_replay(game_state_t *game) {
+    surface_t *screen = &screen_surface;
+    const replay_header_t *header = &replay.header;
+    game_state_t view = *game;
+    replay_cursor_t cursor;
+    bool released = false;
+
+    clear_read_FIFO();
+
+    if (replay_seek(&replay, 0, &view, &cursor) < 0) {
+        game->mode = MODE_GAME_OVER;
+        return;
+    }
+
+    while (game->mode == MODE_REPLAY) {
+        redraw_background_behind_pipes(screen, &view);
+        draw_entities(screen, &view.pipes);
+        draw_bird(screen, view.bird);
+        draw_score(screen, view.score, SCORE_POS_X, SCORE_POS_Y);
+
+        // How far into the replay we are, along the bottom of the ground
+        int progress = cursor.frame * (RESOLUTION_X - 21) / (header->frame_count > 0 ? header->frame_count : 1);
+        draw_rect(screen, 10, RESOLUTION_Y - 8, RESOLUTION_X - 10, RESOLUTION_Y - 5, BLACK);
+        draw_rect(screen, 10, RESOLUTION_Y - 8, 10 + progress, RESOLUTION_Y - 5, YELLOW);
+
+        int PS2_data = ps2_read();
+        if (PS2_data & 0x8000) {
+            char key_data = PS2_data & 0xFF;
+
+            // Keys act when pressed; the code repeated after BREAK_CODE
+            // on release is ignored
+            if (key_data == (char)BREAK_CODE) released = true;
+            else if (released) released = false;
+            else if (key_data == (char)LEFT_KEY) replay_seek(&replay, cursor.frame - REPLAY_SCRUB_FRAMES, &view, &cursor);
+            else if (key_data == (char)RIGHT_KEY) replay_seek(&replay, cursor.frame + REPLAY_SCRUB_FRAMES, &view, &cursor);
+            else if (key_data == (char)ENTER_KEY || key_data == (char)BACK_SPACE_KEY) game->mode = MODE_GAME_OVER;
+        }
+
+        // Hold the last frame once the replay is over
+        if (cursor.frame < header->frame_count) {
+            do_scroll_grasses(&view);
+            do_game_step(&view, replay_next_input(&replay, &cursor));
+        }
+
+        next_frame();
+    }
+
+    // Nothing else redraws the ground, so paint the sand back over the
+    // progress bar in both buffers
+    for (int i = 0; i < 2; i++) {
+        draw_rect(screen, 10, RESOLUTION_Y - 8, RESOLUTION_X - 10, RESOLUTION_Y - 5, SAND);
+        next_frame();
+    }
+}
+
+/**
+ * Races the bird against the one of another kiosk. The other bird is
+ * drawn as a ghost over the local course, which is the same as its
+ * own. The game is over once both birds are dead.
+ * @param game - gets the local score
+*/
+void draw_netplay(game_state_t *game) {
+    surface_t *screen = &screen_surface;
+    netplay_session_t *session = &netplay_session;
+    netplay_t *net = &session->net;
+    game_state_t *local = &net->players[NETPLAY_LOCAL];
+    game_state_t *remote = &net->players[NETPLAY_REMOTE];
+    bool jump = false;
+    int linger = 0;
+
+    clear_read_FIFO();
+    netplay_session_start(session, &netplay_transport, NETPLAY_SEED);
+
+    while (!netplay_session_finished(session) && linger < NETPLAY_LINGER_FRAMES) {
+        int remote_y = (int) remote->bird.y;
+
+        redraw_background_behind_pipes(screen, local);
+        draw_entities(screen, &local->pipes);
+        if (net->alive[NETPLAY_REMOTE]) draw_ghost_birds(screen, remote->bird.x, &remote_y, 1, WHITE, GHOST_ALPHA);
+        draw_bird(screen, local->bird);
+        draw_score(screen, local->score, SCORE_POS_X, SCORE_POS_Y);
+
+        // A jump waits for the frame that can take it
+        if (is_jump_key_pressed() && net->alive[NETPLAY_LOCAL]) jump = true;
+
+        int score = local->score;
+        bool alive = net->alive[NETPLAY_LOCAL];
+
+        if (netplay_session_frame(session, jump)) {
+            if (jump) play_sound(&flap_clip, AUDIO_FULL_GAIN);
+            if (local->score > score) play_sound(&score_clip, AUDIO_FULL_GAIN);
+            if (alive && !net->alive[NETPLAY_LOCAL]) play_sound(&hit_clip, AUDIO_FULL_GAIN);
+            jump = false;
+        }
+
+        if (netplay_race_over(net)) linger++;
+
+        next_frame();
+    }
+
+    game->score = local->score;
+    game->mode = MODE_GAME_OVER;
+}
+
+void erase_game_over_texts(){
+    //erase "SCORE: "
+    //erase "BEST: "
+    //erase "PRESS ENTER TO RESTART"
+    //erase "PRESS BACK TO GO TO MENU"
+    char text_for_score[] = "        \0 ";
+    char text_for_best_score[] = "       \0 ";
+    char text_for_restart[] = "                         \0";
+    char text_for_menu[] = "                             \0";
+
+    //use character buffer
+    video_text(27, 19, text_for_score);
+    video_text(27, 27, text_for_best_score);
+    video_text(27, 35, text_for_restart);
+    video_text(25, 43, text_for_menu);
+}
+
+void draw_menu(game_state_t *game, bird_t bird) {
+    surface_t *screen = &screen_surface;
+
+    clear_read_FIFO();
+    game -> best_score = 0;
+    while (game -> mode == MODE_MENU) {
+        redraw_background(screen, game);
+
+        // The bird stays put on the menu, so only its wing moves
+        bird.wing_tick = animation_tick;
+        draw_bird(screen, bird);
+
+        //display "FLAPPY BIRD"
+        char text_for_title[] = "FLAPPY BIRD";
+        int title_x = (RESOLUTION_X - text_width(text_for_title, TITLE_CHAR_SCALE)) / 2;
+        draw_text(screen, text_for_title, title_x, 45, TITLE_CHAR_SCALE, WHITE, BLACK);
+        
+        //display "PRESS SPACE TO LET THE BIRD JUMP"
+        //display "PRESS ENTER TO START"
+        char text_for_instruction[] = "PRESS SPACE TO LET THE BIRD JUMP\0";
+        char text_to_display[] = "PRESS ENTER TO START\0";
+
+        //use character buffer
+        video_text(31, 30, text_for_instruction);
+        video_text(37, 44, text_to_display);
+
+        // button shape for press enter to start
+        // and press space
+        draw_rect(screen, 90, 110, RESOLUTION_X - 40, 110 + 22, ORANGE);
+        draw_rect(screen, 90, 167, RESOLUTION_X - 40, 167 + 22, ORANGE);
+        draw_rect_outline(screen, 90, 110, RESOLUTION_X - 40, 110 + 22, BLACK);
+        draw_rect_outline(screen, 90, 167, RESOLUTION_X - 40, 167 + 22, BLACK);
+
+        //check whether Enter has pressed
+        change_mode(game);
+        do_scroll_grasses(game);
+        next_frame();
+    }
+}
+
+
+void erase_menu_texts(){
+    //erase "PRESS SPACE TO LET THE BIRD JUMP"
+    //erase "PRESS ENTER TO START"
+    char text_to_erase_instruction[] = "                                 \0";
+    char text_to_erase_display[] = "                    \0";
+
+    //use character buffer
+    video_text(31, 30, text_to_erase_instruction);
+    video_text(37, 44, text_to_erase_display);
+}
+
+/**
+ * Draws the grass scrolled by grass_offset, one row copy per scanline
+ * out of grass_strip
+ * @param surface - surface to draw on
+ * @param grass_offset - 0 to GRASS_PERIOD - 1
+*/
+void draw_grasses(const surface_t *surface, int grass_offset){
+    int x0 = surface->clip.x0;
+    int x1 = surface->clip.x1;
+
+    if (x0 > x1) return;
+
+    if (surface->list) {
+        blit_rows(surface, &grass_strip[0][grass_offset], GRASS_STRIP_WIDTH, RESOLUTION_X,
+            0, GRASS_STRIP_TOP, GRASS_STRIP_TOP + GRASS_STRIP_HEIGHT - 1);
+        return;
+    }
+
+    for (int row = 0; row < GRASS_STRIP_HEIGHT; row++) {
+        int y = GRASS_STRIP_TOP + row;
+
+        if (is_out_of_bounds(y, surface->clip.y0, surface->clip.y1)) continue;
+
+        memcpy(
+            surface_pixel(surface, x0, y),
+            &grass_strip[row][grass_offset + x0],
+            (x1 - x0 + 1) * sizeof(color_t)
+        );
+    }
+}
+
+void draw_background(const surface_t *surface, game_state_t *game) {
+    // draw sky
+    blit_rows(surface, sky_img[0], RESOLUTION_X, RESOLUTION_X, 0, 0, SKY_THICKNESS - 1);
+    
+    //draw ground
+    draw_rect(surface, 0, RESOLUTION_Y - GROUND_THICKNESS + 1, RESOLUTION_X, RESOLUTION_Y, SAND);
+    //draw grass
+    draw_grasses(surface, game->grass_offset);
+}
+
+void redraw_background(const surface_t *surface, game_state_t *game){
+    // draw sky
+    blit_rows(surface, sky_img[0], RESOLUTION_X, RESOLUTION_X, 0, 0, SKY_THICKNESS - 1);
+    
+    //draw grass
+    draw_grasses(surface, game->grass_offset);
+}
+
+/**
+ * Same as redraw_background, but skips the sky pixels that the pipe
+ * bodies are about to cover. Columns under a pipe only get the rows of
+ * the void redrawn, so those pixels are written once per frame instead
+ * of twice. Only use this when draw_entities is called afterwards.
+ * A display list hides those pixels by itself.
+ * @param surface - surface to draw on
+ * @param game
+*/
+void redraw_background_behind_pipes(const surface_t *surface, game_state_t *game){
+    if (surface->list) {
+        redraw_background(surface, game);
+        return;
+    }
+
+    // Range of sky rows that is still visible in each column
+    int sky_top[RESOLUTION_X];
+    int sky_bottom[RESOLUTION_X];
+
+    for (int i = 0; i < RESOLUTION_X; i++) {
+        sky_top[i] = 0;
+        sky_bottom[i] = SKY_THICKNESS - 1;
+    }
+
+    // Pipe bodies fill x0..x1 from the top of the screen to the top
+    // edge of the void and from the bottom edge to the grass
+    const entity_store_t *pipes = &game->pipes;
+
+    for (int p = 0; p < NUM_PIPES; p++) {
+        int x0 = clamp(pipes->x[p] - (pipes->width[p] / 2), 0, RESOLUTION_X);
+        int x1 = clamp(pipes->x[p] + (pipes->width[p] / 2), -1, RESOLUTION_X - 1);
+        int void_top = pipes->y[p] - (pipes->height[p] / 2) + 1;
+        int void_bottom = pipes->y[p] + (pipes->height[p] / 2) - 1;
+
+        for (int i = x0; i <= x1; i++) {
+            if (void_top > sky_top[i]) sky_top[i] = void_top;
+            if (void_bottom < sky_bottom[i]) sky_bottom[i] = void_bottom;
+        }
+    }
+
+    // draw sky
+    for (int i = 0; i < RESOLUTION_X; i++) {
+        for (int j = sky_top[i]; j <= sky_bottom[i]; j++) {
+            draw_pixel_optim(surface, i, j, sky_img[j][i]);
+        }
+    }
+
+    //draw grass
+    draw_grasses(surface, game->grass_offset);
+}
+
+// Control bird's position
+void do_bird_velocity(bird_t* bird, const game_config_t *config){
+    //update y position
+    bird->y -= bird->y_velocity;
+
+    //update y velocity
+    bird->y_velocity -= config->bird_gravity;
+
+    bird->wing_tick = (bird->wing_tick + 1) % WING_CYCLE_TICKS;
+}
+
+void do_bird_jump(bird_t* bird, const game_config_t *config){
+    bird->y_velocity = config->bird_jump_velocity;
+}
+
+bool is_jump_key_pressed(){
+    //bird will jump when the user pressed space key
+    sample_keyboard_arrival();
+
+    int PS2_data = ps2_read(); // read the Data register in the PS/2 port
+    int RVALID = PS2_data & 0x8000; // extract the RVALID field
+    if (RVALID) {
+        char key_data = PS2_data & 0xFF;
+        unsigned int arrival_time = input_latency.arrival_time;
+        int RAVAIL = (PS2_data >> 16) & 0xFFFF; // entries left in the FIFO
+
+        // We only know when the FIFO became non-empty, so the next byte
+        // in it is timed from now at the latest
+        if (RAVAIL == 0) input_latency.arrival_valid = false;
+        else input_latency.arrival_time = read_timer();
+
+        if (key_data == (char) SPACE_KEY) {
+            record_jump_applied(arrival_time);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns a random height for the centre of a pipe void. Uses the
+ * generator stored in the game state instead of rand() so that a
+ * copy of the state produces the same pipes as the original.
+ * @param game
+*/
+int random_pipe_y(game_state_t *game) {
+    // Same constants as the C library's reference rand()
+    game->seed = game->seed * 1103515245 + 12345;
+    int r = (game->seed >> 16) & 0x7FFF;
+
+    int void_height = game->config.pipe_void_height;
+
+    return r % (RESOLUTION_Y - void_height * 2 - TOTAL_FLOOR_HEIGHT) + void_height;
+}
+
+void do_scroll_pipes(game_state_t *game) {
+    cull_pipes(game);
+    scroll_entities(&game->pipes, game->config.scroll_amount);
+}
+
+void do_scroll_grasses(game_state_t *game) {
+    game->grass_offset = (game->grass_offset + game->config.scroll_amount) % GRASS_PERIOD;
+}
+
+void do_scroll_view(game_state_t *game) {   
+    do_scroll_pipes(game);
+    do_scroll_grasses(game);
+}
+
+void do_update_score(game_state_t *game) {
+    entity_store_t *pipes = &game->pipes;
+    int bird_center_x = game->bird.x + BIRD_WIDTH / 2;
+
+    for (int i = 0; i < NUM_PIPES; i++) {
+        bool did_pipe_pass_bird = pipes->x[i] < bird_center_x;
+        bool did_score_update = pipes->flags[i] & ENTITY_SCORED;
+
+        if (did_pipe_pass_bird && !did_score_update) {
+            pipes->flags[i] |= ENTITY_SCORED;
+            game->score++;
+        }
+    }
+}
+
+// Entity systems
+/**
+ * Moves every entity left. Runs down the x column only, so it
+ * vectorizes however many entities there are.
+ * @param store
+ * @param dx - pixels to move
+*/
+void scroll_entities(entity_store_t *store, int dx) {
+    for (int i = 0; i < store->count; i++) {
+        store->x[i] -= dx;
+    }
+}
+
+/**
+ * Recycles the pipes that scrolled off the left of the screen. Each is
+ * placed to the right of the slot before it in ring order, which is the
+ * rightmost pipe, with a new height.
+ * @param game
+*/
+void cull_pipes(game_state_t *game) {
+    entity_store_t *pipes = &game->pipes;
+    int prev = NUM_PIPES - 1;
+
+    for (int i = 0; i < NUM_PIPES; prev = i, i++) {
+        if (pipes->x[i] >= -PIPE_WIDTH / 2) continue;
+
+        pipes->flags[i] &= ~ENTITY_SCORED;
+        pipes->x[i] = pipes->x[prev] + game->config.pipe_spacing;
+        pipes->y[i] = random_pipe_y(game);
+    }
+}
+
+/**
+ * Stops the step at the first pose where the bird hits a pipe. The
+ * swept test finds when the bird's hull first touches a pipe; from
+ * there the poses one pixel of motion apart are tested exactly with
+ * collide_entities. When one of them hits before the end of the step,
+ * the bird is moved back to it.
+ * @param game - bird at the end of the step, pipes at the start
+ * @param start - bird at the start of the step
+ * @param scroll - how far the pipes move this step
+ * @return how far the pipes should scroll
+*/
+int do_swept_collision(game_state_t *game, bird_t start, int scroll) {
+    double dy = game->bird.y - start.y;
+    double toi = sweep_entities(&game->pipes, start.x, start.y, BIRD_HEIGHT, scroll, dy);
+
+    if (toi > 1) return scroll;
+
+    int steps = clamp((int)(dy < 0 ? -dy : dy) + 1, scroll, RESOLUTION_Y);
+
+    // The end of the step is left to is_game_over, as without sweeping
+    for (int k = clamp((int)(toi * steps), 1, steps); k < steps; k++) {
+        entity_store_t moved = game->pipes;
+        bird_t bird = game->bird;
+        int dx = scroll * k / steps;
+
+        bird.y = start.y + dy * k / steps;
+        scroll_entities(&moved, dx);
+
+        if (collide_entities(&moved, bird) >= 0) {
+            game->bird.y = bird.y;
+            return dx;
+        }
+    }
+
+    return scroll;
+}
+
+/**
+ * Sweeps a box along a straight line against every entity. The box
+ * covers the bird's sprite and its collision box, and it is padded by
+ * a pixel so rounding a pose never hides a hit.
+ * @param store
+ * @param x - bird x at the start
+ * @param y - top of the box at the start
+ * @param height - rows in the box, BIRD_HEIGHT for a single pose
+ * @param dx - how far the box moves right relative to the entities
+ * @param dy - how far the box moves down
+ * @return time of first contact from 0 to 1, above 1 when there is none
+*/
+double sweep_entities(const entity_store_t *store, int x, double y, int height, double dx, double dy) {
+    sweep_box_t box = {x + bird_hull_left - 1, y + bird_hull_top - 1,
+        x + bird_hull_right + 1, y + height - BIRD_HEIGHT + bird_hull_bottom + 1};
+    double first = 2;
+
+    for (int i = 0; i < store->count; i++) {
+        double t = 2;
+
+        switch (store->kind[i]) {
+            case ENTITY_PIPE: t = sweep_pipe(store, i, &box, dx, dy); break;
+        }
+
+        if (t < first) first = t;
+    }
+
+    return first;
+}
+
+/**
+ * Sweeps a box against the solid parts of a pipe, where the head is
+ * wider than the body. The pipe is padded by a pixel like the box.
+ * @param store
+ * @param i - slot of the pipe
+ * @param box - box at the start
+ * @param dx - how far the box moves right relative to the pipe
+ * @param dy - how far the box moves down
+ * @return time of first contact from 0 to 1, above 1 when there is none
+*/
+double sweep_pipe(const entity_store_t *store, int i, const sweep_box_t *box, double dx, double dy) {
+    double pipe_x0 = store->x[i] - store->width[i] / 2 - PIPE_HEAD_OVERHANG;
+    double pipe_x1 = store->x[i] + store->width[i] / 2 + PIPE_HEAD_OVERHANG;
+    double void_y0 = store->y[i] - store->height[i] / 2;
+    double void_y1 = store->y[i] + store->height[i] / 2;
+    double first = 2;
+    double t0 = 0;
+    double t1 = 1;
+
+    // Times when the box overlaps the pipe's columns
+    if (!sweep_interval(box->x1 + 1 - pipe_x0, dx, &t0, &t1)) return first;
+    if (!sweep_interval(pipe_x1 + 1 - box->x0, -dx, &t0, &t1)) return first;
+
+    // Then when it reaches into the top pipe or the bottom pipe
+    double top0 = t0, top1 = t1;
+    double bottom0 = t0, bottom1 = t1;
+
+    if (sweep_interval(void_y0 + 1 - box->y0, -dy, &top0, &top1)) first = top0;
+    if (sweep_interval(box->y1 + 1 - void_y1, dy, &bottom0, &bottom1) && bottom0 < first) first = bottom0;
+
+    return first;
+}
+
+/**
+ * Narrows t0..t1 to the times when a + b * t > 0
+ * @return false when that leaves nothing
+*/
+bool sweep_interval(double a, double b, double *t0, double *t1) {
+    if (b == 0) return a > 0 && *t0 <= *t1;
+
+    double t = -a / b;
+
+    if (b > 0 && t > *t0) *t0 = t;
+    if (b < 0 && t < *t1) *t1 = t;
+
+    return *t0 <= *t1;
+}
+
+/**
+ * Finds the first entity the bird overlaps. Only entities whose
+ * columns reach the bird's mask get the full test of their kind.
+ * @param store
+ * @param bird
+ * @return slot of the entity, or -1 when there is none
+*/
+int collide_entities(const entity_store_t *store, bird_t bird) {
+    for (int i = 0; i < store->count; i++) {
+        int half_width = store->width[i] / 2 + entity_reach(store->kind[i]);
+        bool hit = false;
+
+        if (store->x[i] + half_width < bird.x + bird_hull_left) continue;
+        if (store->x[i] - half_width > bird.x + bird_hull_right) continue;
+
+        switch (store->kind[i]) {
+            case ENTITY_PIPE: hit = did_collide(bird, store, i); break;
+        }
+
+        if (hit) return i;
+    }
+
+    return -1;
+}
+
+// Pixels an entity of a kind reaches past its width on each side
+inline int entity_reach(int kind) {
+    return kind == ENTITY_PIPE ? PIPE_HEAD_OVERHANG : 0;
+}
+
+/**
+ * Advances the game by one frame without touching the screen or the
+ * keyboard. Grass is left alone since it has no effect on the outcome.
+ * @param game
+ * @param jump - whether the bird jumps this frame
+*/
+void do_game_step(game_state_t *game, bool jump) {
+    int scroll = game->config.scroll_amount;
+
+    cull_pipes(game);
+
+    bird_t start = game->bird;
+    if (jump) do_bird_jump(&game->bird, &game->config);
+    do_bird_velocity(&game->bird, &game->config);
+
+#if CONTINUOUS_COLLISION
+    scroll = do_swept_collision(game, start, scroll);
+#endif
+
+    scroll_entities(&game->pipes, scroll);
+    do_update_score(game);
+}
+
+/**
+ * Advances a game by frames frames without jumps, or until it is over.
+ * The result is the same as calling do_game_step(game, false) once per
+ * frame. The bird is still integrated frame by frame, but pipes are
+ * scrolled and collided once per stretch of frames whose whole sweep
+ * misses every pipe. Stretches end before a pipe is recycled, since
+ * that draws a new random height.
+ * @param game
+ * @param frames
+ * @return frames advanced
+*/
+int do_game_fast_forward(game_state_t *game, int frames) {
+    entity_store_t *pipes = &game->pipes;
+    int scroll = game->config.scroll_amount;
+    int done = 0;
+
+    while (done < frames && !is_game_over(game)) {
+        // Recycling is idempotent, so do_game_step below can repeat it
+        cull_pipes(game);
+
+        int leftmost = pipes->x[0];
+        for (int i = 1; i < NUM_PIPES; i++) {
+            if (pipes->x[i] < leftmost) leftmost = pipes->x[i];
+        }
+
+        // Later frames of the stretch must not recycle a pipe
+        int length = clamp((leftmost + PIPE_WIDTH / 2) / scroll + 1, 1, frames - done);
+
+        // Halve the stretch until its sweep is clear, down to one frame
+        // that goes through do_game_step
+        for (;; length /= 2) {
+            bird_t bird = game->bird;
+            double y_min = bird.y;
+            double y_max = bird.y;
+            int count = 0;
+
+            if (length == 1) {
+                do_game_step(game, false);
+                done++;
+                break;
+            }
+
+            while (count < length) {
+                do_bird_velocity(&bird, &game->config);
+                count++;
+
+                if (bird.y < y_min) y_min = bird.y;
+                if (bird.y > y_max) y_max = bird.y;
+                if (bird_in_screen(bird)) break;
+            }
+
+            // Every pose of the stretch lies in a box y_min..y_max tall
+            // that slides count * scroll pixels right of the pipes
+            int height = (int)(y_max - y_min) + BIRD_HEIGHT + 1;
+
+            if (sweep_entities(pipes, bird.x, y_min, height, count * scroll, 0) <= 1) continue;
+
+            game->bird = bird;
+            scroll_entities(pipes, count * scroll);
+            do_update_score(game);
+            done += count;
+            break;
+        }
+    }
+
+    return done;
+}
+
+void do_update_best_score(game_state_t *game){
+    if (game->score > game->best_score) {
+        game->best_score = game->score;
+    }
+}
+
+/**
+ * Color of column i of the inside of a pipe that is width pixels wide:
+ * a highlight a quarter of the way in that fades into shadow on the
+ * right, like the pipes of the original game
+*/
+color_t pipe_shade(int i, int width) {
+    int t = i * 64 / (width - 1);
+
+    if (t <= 16) return blend_pixel(PIPE_COLOR, WHITE, 2 + t * 6 / 16);
+    if (t <= 40) return blend_pixel(PIPE_COLOR, WHITE, 8 * (40 - t) / 24);
+    return blend_pixel(PIPE_COLOR, BLACK, (t - 40) * 8 / 24);
+}
+
+// Index into bird_frames of the tilt closest to the bird's velocity
+int bird_angle_index(bird_t bird) {
+    int angle = (int)(-bird.y_velocity * BIRD_DEGREES_PER_VELOCITY) - BIRD_MIN_ANGLE;
+    int index = (angle + BIRD_ANGLE_STEP / 2) / BIRD_ANGLE_STEP;
+
+    return clamp(index, 0, NUM_BIRD_ANGLES - 1);
+}
+
+// Index into bird_frames of the wing position for a bird_t wing_tick.
+// The wing goes up, level, down, level and around again
+int bird_wing_frame(unsigned int tick) {
+    int step = (tick % WING_CYCLE_TICKS) / WING_FRAME_TICKS;
+
+    return step == 3 ? 1 : step;
+}
+
+/**
+ * Returns the bits of a bird mask row that fall on screen columns
+ * x0..x1 when bit 0 of the row is screen column left
+*/
+inline unsigned long long bird_column_mask(int left, int x0, int x1) {
+    int first = x0 - left;
+    int last = x1 - left;
+
+    if (last < 0 || first > BIRD_MASK_BITS - 1) return 0;
+
+    first = clamp(first, 0, BIRD_MASK_BITS - 1);
+    last = clamp(last, 0, BIRD_MASK_BITS - 1);
+
+    return (~0ULL >> (BIRD_MASK_BITS - 1 - last)) & (~0ULL << first);
+}
+
+/**
+ * return true when the bird and pipe i of the store collide, return false when they don't collide
+*/
+bool did_collide(bird_t bird, const entity_store_t *store, int i){
+    //these four lines form a rectangle of void space between top pipe and bottom pipe
+    //pipe_void_x1 < pipe_void_x2, pipe_void_y1 < pipe_void_y2
+    int pipe_void_x1 = store->x[i] - (store->width[i] / 2);
+    int pipe_void_x2 = store->x[i] + (store->width[i] / 2);
+    int pipe_void_y1 = store->y[i] - (store->height[i] / 2);
+    int pipe_void_y2 = store->y[i] + (store->height[i] / 2);
+
+#if COLLISION_MODE == COLLISION_PIXEL
+    // The frame draw_bird shows for this bird, tilted and flapping
+    const bird_frame_t *frame = &bird_frames[bird_wing_frame(bird.wing_tick)][bird_angle_index(bird)];
+    int left = bird.x + BIRD_CANVAS_LEFT;
+
+    // Columns the pipe covers, as bits of a frame's opaque row. The
+    // pipe heads are drawn wider than the body on each side
+    unsigned long long body = bird_column_mask(left, pipe_void_x1, pipe_void_x2);
+    unsigned long long head = bird_column_mask(left, pipe_void_x1 - PIPE_HEAD_OVERHANG, pipe_void_x2 + PIPE_HEAD_OVERHANG);
+
+    if (head == 0) return false;
+
+    int top = (int) bird.y + BIRD_CANVAS_TOP;
+
+    for (int row = 0; row < BIRD_CANVAS_SIZE; row++) {
+        int y = top + row;
+        unsigned long long solid;
+
+        // Rows strictly between the two pipe edges are open
+        if (y > pipe_void_y1 && y < pipe_void_y2) continue;
+
+        if (y >= pipe_void_y1 - PIPE_HEAD_HEIGHT && y <= pipe_void_y2 + PIPE_HEAD_HEIGHT)
+            solid = head;
+        else
+            solid = body;
+
+        if (frame->opaque[row] & solid) return true;
+    }
+
+    return false;
+#endif
+
+    //check whether the bird and the pipe collides
+    //the bird hasn't reached the pipe or the bird has already passed the pipe
+    if(bird.x + BIRD_WIDTH - 1 < pipe_void_x1 || bird.x > pipe_void_x2){
+        return false;
+    }
+    //some portion of the bird is in between the top and bottom pipe
+    else{
+        //y coordinate of the bird is within the void region
+        if(bird.y >= pipe_void_y1 && bird.y + BIRD_HEIGHT - 1 <= pipe_void_y2){
+            return false;
+        }
+        //the bird and the pipe collide
+        else{
+            return true;
+        }
+    }
+}
+
+inline bool bird_in_screen(bird_t bird) {
+    return is_out_of_bounds(bird.y, 0, RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - BIRD_HEIGHT);
+}
+
+// Game logic
+inline bool is_game_over(game_state_t *game) {
+    if (collide_entities(&game->pipes, game->bird) >= 0)
+        return true;
+
+    return bird_in_screen(game->bird);
+}
+
+// Snapshots
+/**
+ * Packs the world of a game into a world_snapshot_t. Mode, best score
+ * and autopilot belong to the session and are not part of it.
+ * @param game
+ * @param snapshot
+*/
+void save_game_snapshot(const game_state_t *game, world_snapshot_t *snapshot) {
+    int head = 0;
+
+    // Pipes take the first NUM_PIPES slots and are rebuilt from the
+    // ring. Only the count and kinds of the slots are stored as they are
+    for (int i = 1; i < NUM_PIPES; i++) {
+        if (game->pipes.x[i] < game->pipes.x[head]) head = i;
+    }
+
+    snapshot->bird_y = game->bird.y;
+    snapshot->bird_y_velocity = game->bird.y_velocity;
+    snapshot->bird_wing_tick = game->bird.wing_tick % WING_CYCLE_TICKS;
+    snapshot->seed = game->seed;
+    snapshot->score = game->score;
+    snapshot->pipe_head_x = game->pipes.x[head];
+    snapshot->pipe_head = head;
+    snapshot->pipe_scored = 0;
+    snapshot->grass_offset = game->grass_offset;
+    snapshot->entity_count = game->pipes.count;
+    memcpy(snapshot->entity_kinds, game->pipes.kind, sizeof(snapshot->entity_kinds));
+
+    for (int i = 0; i < NUM_PIPES; i++) {
+        snapshot->pipe_heights[i] = game->pipes.y[i];
+
+        if (game->pipes.flags[i] & ENTITY_SCORED)
+            snapshot->pipe_scored |= 1 << i;
+    }
+}
+
+/**
+ * Rebuilds the world of a game from a snapshot. Everything derived,
+ * like pipe positions, is recomputed.
+ * @param game
+ * @param snapshot
+*/
+void restore_game_snapshot(game_state_t *game, const world_snapshot_t *snapshot) {
+    entity_store_t *pipes = &game->pipes;
+
+    pipes->count = snapshot->entity_count;
+    memcpy(pipes->kind, snapshot->entity_kinds, sizeof(pipes->kind));
+
+    for (int k = 0; k < NUM_PIPES; k++) {
+        int i = (snapshot->pipe_head + k) % NUM_PIPES;
+
+        pipes->x[i] = snapshot->pipe_head_x + k * game->config.pipe_spacing;
+        pipes->y[i] = snapshot->pipe_heights[i];
+        pipes->width[i] = PIPE_WIDTH;
+        pipes->height[i] = game->config.pipe_void_height;
+        pipes->flags[i] = (snapshot->pipe_scored >> i) & 1 ? ENTITY_SCORED : 0;
+    }
+
+    game->bird.x = BIRD_INITIAL_X;
+    game->bird.y = snapshot->bird_y;
+    game->bird.y_velocity = snapshot->bird_y_velocity;
+    game->bird.wing_tick = snapshot->bird_wing_tick;
+    game->seed = snapshot->seed;
+    game->score = snapshot->score;
+    game->grass_offset = snapshot->grass_offset;
+}
+
+// Autopilot
+/**
+ * Returns true if some sequence of jumps keeps the bird alive for the
+ * given number of frames. Jumps are only tried every
+ * AUTOPILOT_DECISION_FRAMES frames to keep the search tree small.
+ * @param game - state to search from, left untouched
+ * @param frames - how many frames the bird has to survive
+*/
+bool autopilot_can_survive(const game_state_t *game, int frames) {
+    if (frames <= 0) return true;
+
+    // Try not jumping first so the bird only flaps when it has to
+    for (int jump = 0; jump <= 1; jump++) {
+        game_state_t branch = *game;
+        bool survived = true;
+
+        for (int i = 0; i < AUTOPILOT_DECISION_FRAMES && i < frames; i++) {
+            do_game_step(&branch, jump && i == 0);
+
+            if (is_game_over(&branch)) {
+                survived = false;
+                break;
+            }
+        }
+
+        if (survived && autopilot_can_survive(&branch, frames - AUTOPILOT_DECISION_FRAMES))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Decides whether the bird should jump this frame by searching
+ * AUTOPILOT_DEPTH frames ahead. Jumps only when not jumping now
+ * leads to a death that no later jumps can avoid.
+ * @param game
+*/
+bool autopilot_should_jump(const game_state_t *game) {
+    game_state_t branch = *game;
+
+    do_game_step(&branch, false);
+
+    if (is_game_over(&branch)) return true;
+
+    return !autopilot_can_survive(&branch, AUTOPILOT_DEPTH - 1);
+}
+
+// Environments
+/**
+ * Starts a new episode with the rules the game ships with. What happens
+ * afterwards only depends on the seed and on the actions passed to
+ * env_step, so episodes can be reproduced. Never touches the screen
+ * or the keyboard.
+ * @param game
+ * @param seed
+*/
+void env_reset(game_state_t *game, unsigned int seed) {
+    env_reset_config(game, seed, &default_game_config);
+}
+
+// Like env_reset, with other rules
+void env_reset_config(game_state_t *game, unsigned int seed, const game_config_t *config) {
+    game->config = *config;
+    game->mode = MODE_GAME;
+    game->score = 0;
+    game->best_score = 0;
+    game->seed = seed;
+    game->autopilot = false;
+
+    initialize_pipes(game);
+    initialize_grasses(game);
+    initialize_bird(&game->bird);
+
+    // Collisions need the frames even when nothing is drawn
+    initialize_bird_frames();
+}
+
+void env_observe(const game_state_t *game, observation_t *observation) {
+    const entity_store_t *pipes = &game->pipes;
+    int next = -1;
+
+    // The next pipe is the leftmost one whose right edge the bird
+    // has not passed yet
+    for (int i = 0; i < NUM_PIPES; i++) {
+        if (pipes->x[i] + (pipes->width[i] / 2) < game->bird.x) continue;
+        if (next < 0 || pipes->x[i] < pipes->x[next]) next = i;
+    }
+
+    observation->bird_y = game->bird.y;
+    observation->bird_y_velocity = game->bird.y_velocity;
+
+    // With every pipe passed, the void is a screen ahead at bird height
+    if (next < 0) {
+        observation->pipe_dx = RESOLUTION_X;
+        observation->pipe_dy = 0;
+        return;
+    }
+
+    observation->pipe_dx = pipes->x[next] - game->bird.x;
+    observation->pipe_dy = pipes->y[next] - (int) game->bird.y;
+}
+
+/**
+ * Advances count independent games by one frame each. The reward is
+ * the number of pipes passed during the frame. A finished game is
+ * reset right away and its observation is the first one of the new
+ * episode. The seed for that episode comes from the game's own
+ * generator, so a pool seeded once stays reproducible.
+ * @param games
+ * @param count - number of games
+ * @param actions - whether each bird jumps
+ * @param observations - filled in for every game
+ * @param rewards - filled in for every game
+ * @param dones - true where an episode ended during this step
+*/
+void env_step(game_state_t games[], int count, const bool actions[],
+    observation_t observations[], int rewards[], bool dones[]) {
+    for (int i = 0; i < count; i++) {
+        game_state_t *game = &games[i];
+        int score = game->score;
+
+        do_game_step(game, actions[i]);
+
+        rewards[i] = game->score - score;
+        dones[i] = is_game_over(game);
+
+        if (dones[i]) {
+            game_config_t config = game->config;
+            env_reset_config(game, game->seed, &config);
+        }
+
+        env_observe(game, &observations[i]);
+    }
+}
+
+#if !defined(__arm__)
+// Steps chunks of the pool's games until none are left this step
+void env_pool_run_chunks(env_pool_t *pool) {
+    int chunks = (pool->count + ENV_POOL_CHUNK - 1) / ENV_POOL_CHUNK;
+    int chunk;
+
+    while ((chunk = __atomic_fetch_add(&pool->next_chunk, 1, __ATOMIC_RELAXED)) < chunks) {
+        int first = chunk * ENV_POOL_CHUNK;
+        int count = clamp(pool->count - first, 0, ENV_POOL_CHUNK);
+
+        env_step(pool->games + first, count, pool->actions + first,
+            pool->observations + first, pool->rewards + first, pool->dones + first);
+    }
+}
+
+void *env_pool_worker(void *argument) {
+    env_pool_t *pool = argument;
+    unsigned int seen = 0;
+
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->stopping) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        seen = pool->generation;
+        bool stopping = pool->stopping;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (stopping) return NULL;
+
+        env_pool_run_chunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->finished == pool->worker_count) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * Starts threads - 1 workers that step the games together with the
+ * thread calling env_pool_step. The games have to be reset already;
+ * env_step resets them again as episodes end.
+ * @param pool
+ * @param games
+ * @param count - number of games
+ * @param observations - filled in for every game by each step
+ * @param rewards - filled in for every game by each step
+ * @param dones - filled in for every game by each step
+ * @param threads - 1 to ENV_POOL_MAX_THREADS + 1, counting the caller
+*/
+void env_pool_start(env_pool_t *pool, game_state_t games[], int count,
+    observation_t observations[], int rewards[], bool dones[], int threads) {
+    pool->games = games;
+    pool->count = count;
+    pool->observations = observations;
+    pool->rewards = rewards;
+    pool->dones = dones;
+    pool->worker_count = clamp(threads - 1, 0, ENV_POOL_MAX_THREADS);
+    pool->generation = 0;
+    pool->finished = 0;
+    pool->stopping = false;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        pthread_create(&pool->workers[i], NULL, env_pool_worker, pool);
+    }
+}
+
+/**
+ * Same as env_step over every game of the pool, spread over its threads
+ * @param pool
+ * @param actions - whether each bird jumps
+*/
+void env_pool_step(env_pool_t *pool, const bool actions[]) {
+    pthread_mutex_lock(&pool->lock);
+    pool->actions = actions;
+    pool->next_chunk = 0;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    env_pool_run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->finished < pool->worker_count) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void env_pool_stop(env_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+}
+#endif
+
+/**
+ * Marks every cell of the observation grid that the screen rectangle
+ * touches. Coordinates are in screen pixels and inclusive, like
+ * draw_rect.
+*/
+void fill_observation_rect(unsigned char grid[OBS_HEIGHT][OBS_WIDTH],
+    int x0, int y0, int x1, int y1, unsigned char value) {
+    int cell_x0 = clamp(x0, 0, RESOLUTION_X) >> OBS_SCALE_SHIFT;
+    int cell_x1 = clamp(x1, -1, RESOLUTION_X - 1) >> OBS_SCALE_SHIFT;
+    int cell_y0 = clamp(y0, 0, RESOLUTION_Y) >> OBS_SCALE_SHIFT;
+    int cell_y1 = clamp(y1, -1, RESOLUTION_Y - 1) >> OBS_SCALE_SHIFT;
+
+    if (cell_x0 > cell_x1) return;
+
+    for (int y = cell_y0; y <= cell_y1; y++) {
+        memset(&grid[y][cell_x0], value, cell_x1 - cell_x0 + 1);
+    }
+}
+
+/**
+ * Rasterizes the floor, the pipes and the bird's collision box straight
+ * into a small grid for agents, without going through the frame buffer.
+ * Uses the same geometry as draw_pipe and bird_in_screen.
+ * @param game
+ * @param grid - OBS_HEIGHT rows of OBS_WIDTH cells
+*/
+void render_observation(const game_state_t *game, unsigned char grid[OBS_HEIGHT][OBS_WIDTH]) {
+    int sky_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
+
+    memset(grid, OBS_EMPTY, OBS_HEIGHT * OBS_WIDTH);
+
+    fill_observation_rect(grid, 0, sky_bottom + 1, RESOLUTION_X - 1, RESOLUTION_Y - 1, OBS_FLOOR);
+
+    const entity_store_t *pipes = &game->pipes;
+
+    for (int i = 0; i < NUM_PIPES; i++) {
+        int x0 = pipes->x[i] - (pipes->width[i] / 2);
+        int x1 = pipes->x[i] + (pipes->width[i] / 2);
+        int y_top_pipe_edge = pipes->y[i] - (pipes->height[i] / 2);
+        int y_bottom_pipe_edge = pipes->y[i] + (pipes->height[i] / 2);
+
+        fill_observation_rect(grid, x0, 0, x1, y_top_pipe_edge, OBS_PIPE);
+        fill_observation_rect(grid, x0, y_bottom_pipe_edge, x1, sky_bottom, OBS_PIPE);
+    }
+
+    // Drawn last so the bird is never hidden by a pipe it overlaps
+    int bird_y = (int) game->bird.y;
+    fill_observation_rect(grid, game->bird.x, bird_y,
+        game->bird.x + BIRD_WIDTH - 1, bird_y + BIRD_HEIGHT - 1, OBS_BIRD);
+}
+
+void render_observations(const game_state_t games[], int count,
+    unsigned char grids[][OBS_HEIGHT][OBS_WIDTH]) {
+    for (int i = 0; i < count; i++) {
+        render_observation(&games[i], grids[i]);
+    }
+}
+
+// Netplay
+/**
+ * Starts a race. Both kiosks have to use the same seed.
+ * @param net
+ * @param seed
+*/
+void netplay_start(netplay_t *net, unsigned int seed) {
+    for (int p = 0; p < 2; p++) {
+        env_reset(&net->players[p], seed);
+        net->alive[p] = true;
+    }
+
+    net->frame = 0;
+    net->remote_frame = 0;
+    net->remote_done = false;
+    net->rollback_frame = -1;
+    net->rollbacks = 0;
+    net->resimulated_frames = 0;
+}
+
+/**
+ * Saves the state at the start of net->frame, then simulates it with
+ * the inputs stored for that frame.
+ * @param net
+*/
+void netplay_simulate_frame(netplay_t *net) {
+    int slot = net->frame % NETPLAY_HISTORY;
+    netplay_frame_t *saved = &net->history[slot];
+
+    for (int p = 0; p < 2; p++) {
+        save_game_snapshot(&net->players[p], &saved->players[p]);
+        saved->alive[p] = net->alive[p];
+
+        if (!net->alive[p]) continue;
+
+        do_game_step(&net->players[p], net->inputs[p][slot]);
+        if (is_game_over(&net->players[p])) net->alive[p] = false;
+    }
+
+    net->frame++;
+}
+
+/**
+ * Simulates the next frame with the local input. Until the remote
+ * input for the frame arrives, the remote bird is predicted to not
+ * jump, since jumps are short taps.
+ * Returns false without simulating when we are NETPLAY_HISTORY frames
+ * ahead of the remote inputs, since a wrong prediction that old could
+ * not be rolled back anymore. Try again next frame.
+ * @param net
+ * @param local_jump
+*/
+bool netplay_advance(netplay_t *net, bool local_jump) {
+    netplay_rollback(net);
+
+    if (!net->remote_done && net->frame - net->remote_frame >= NETPLAY_HISTORY) return false;
+
+    int slot = net->frame % NETPLAY_HISTORY;
+
+    net->inputs[NETPLAY_LOCAL][slot] = local_jump;
+    if (net->frame >= net->remote_frame) net->inputs[NETPLAY_REMOTE][slot] = false;
+
+    netplay_simulate_frame(net);
+    return true;
+}
+
+/**
+ * Feeds in the remote input for a frame. Inputs have to arrive in frame
+ * order; anything else is ignored, so the sender should repeat its
+ * unacknowledged inputs in every packet. When the input differs from
+ * what was predicted for an already simulated frame, the frame is
+ * remembered and netplay_rollback simulates it again, once for a whole
+ * batch of inputs.
+ * Returns true if the input was used.
+ * @param net
+ * @param frame
+ * @param jump
+*/
+bool netplay_receive_remote_input(netplay_t *net, int frame, bool jump) {
+    if (frame != net->remote_frame) return false;
+    if (frame >= net->frame + NETPLAY_HISTORY) return false;
+
+    int slot = frame % NETPLAY_HISTORY;
+    bool mispredicted = frame < net->frame && net->inputs[NETPLAY_REMOTE][slot] != jump;
+
+    net->inputs[NETPLAY_REMOTE][slot] = jump;
+    net->remote_frame++;
+
+    // Inputs come in order, so the first misprediction is the earliest
+    if (mispredicted && net->rollback_frame < 0) net->rollback_frame = frame;
+
+    return true;
+}
+
+/**
+ * Rolls the race back to the earliest mispredicted frame, if any, and
+ * simulates it again up to the present with the inputs known now
+ * @param net
+*/
+void netplay_rollback(netplay_t *net) {
+    int frame = net->rollback_frame;
+
+    if (frame < 0) return;
+
+    int present = net->frame;
+    netplay_frame_t *saved = &net->history[frame % NETPLAY_HISTORY];
+
+    for (int p = 0; p < 2; p++) {
+        restore_game_snapshot(&net->players[p], &saved->players[p]);
+        net->alive[p] = saved->alive[p];
+    }
+
+    for (net->frame = frame; net->frame < present;) {
+        netplay_simulate_frame(net);
+    }
+
+    net->rollback_frame = -1;
+    net->rollbacks++;
+    net->resimulated_frames += present - frame;
+}
+
+// Both birds are dead and nothing the other kiosk sends can change that
+bool netplay_race_over(const netplay_t *net) {
+    if (net->alive[NETPLAY_LOCAL] || net->alive[NETPLAY_REMOTE]) return false;
+
+    return net->remote_done || net->remote_frame >= net->frame;
+}
+
+/**
+ * Starts a race over a transport. Both kiosks have to use the same
+ * seed. The race does not advance until the other kiosk answers.
+ * @param session
+ * @param transport
+ * @param seed
+*/
+void netplay_session_start(netplay_session_t *session, const netplay_transport_t *transport, unsigned int seed) {
+    netplay_start(&session->net, seed);
+    session->transport = *transport;
+    session->peer_ack = 0;
+    session->peer_finished = false;
+    session->packets_sent = 0;
+    session->packets_received = 0;
+    session->stalls = 0;
+}
+
+/**
+ * Sends every local input the other kiosk has not acknowledged, and
+ * how many of its inputs we have
+ * @param session
+*/
+void netplay_session_send(netplay_session_t *session) {
+    netplay_t *net = &session->net;
+    netplay_packet_t packet;
+
+    packet.magic = NETPLAY_MAGIC;
+    packet.first_frame = session->peer_ack;
+    packet.count = clamp(net->frame - session->peer_ack, 0, NETPLAY_PACKET_INPUTS);
+    packet.ack = net->remote_frame;
+    packet.dead = !net->alive[NETPLAY_LOCAL];
+    packet.finished = netplay_race_over(net);
+
+    for (int i = 0; i < packet.count; i++) {
+        packet.jumps[i] = session->local_inputs[(packet.first_frame + i) % NETPLAY_PACKET_INPUTS];
+    }
+
+    if (session->transport.send(session->transport.context, &packet, sizeof(packet))) {
+        session->packets_sent++;
+    }
+}
+
+/**
+ * Reads every packet that has arrived and feeds the new remote inputs
+ * into the race, then rolls back once if any were mispredicted
+ * @param session
+*/
+void netplay_session_receive(netplay_session_t *session) {
+    netplay_t *net = &session->net;
+    netplay_packet_t packet;
+
+    while (session->transport.receive(session->transport.context, &packet, sizeof(packet)) == sizeof(packet)) {
+        if (packet.magic != NETPLAY_MAGIC) continue;
+        if (packet.count < 0 || packet.count > NETPLAY_PACKET_INPUTS) continue;
+
+        session->packets_received++;
+        if (packet.ack > session->peer_ack) session->peer_ack = packet.ack;
+        if (packet.finished) session->peer_finished = true;
+
+        for (int i = 0; i < packet.count; i++) {
+            netplay_receive_remote_input(net, packet.first_frame + i, packet.jumps[i]);
+        }
+
+        // Only once every input up to the death is in
+        if (packet.dead && net->remote_frame >= packet.first_frame + packet.count) net->remote_done = true;
+    }
+
+    netplay_rollback(net);
+}
+
+/**
+ * Runs one frame of a race: takes in what the other kiosk sent,
+ * simulates the next frame with the local input and sends the local
+ * inputs back. Once the race is over only messages are exchanged.
+ * @param session
+ * @param local_jump
+ * @return false when the frame could not be simulated yet. Pass the
+ * same input again next frame
+*/
+bool netplay_session_frame(netplay_session_t *session, bool local_jump) {
+    netplay_t *net = &session->net;
+    bool advanced = false;
+
+    netplay_session_receive(session);
+
+    if (!netplay_race_over(net)) {
+        int frame = net->frame;
+
+        // Unacknowledged inputs have to fit in a packet
+        if (frame - session->peer_ack < NETPLAY_PACKET_INPUTS) advanced = netplay_advance(net, local_jump);
+
+        if (advanced) session->local_inputs[frame % NETPLAY_PACKET_INPUTS] = local_jump;
+        else session->stalls++;
+    }
+
+    netplay_session_send(session);
+    return advanced;
+}
+
+// The race is over on both kiosks
+bool netplay_session_finished(const netplay_session_t *session) {
+    return netplay_race_over(&session->net) && session->peer_finished;
+}
+
+#if !defined(__arm__)
+/**
+ * Opens a non-blocking UDP socket on a local port
+ * @param udp
+ * @param port - 0 for any free port
+ * @return the port the socket got, or -1 on failure
+*/
+int udp_transport_bind(udp_transport_t *udp, int port) {
+    struct sockaddr_in local;
+    socklen_t length = sizeof(local);
+
+    udp->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp->socket < 0) return -1;
+
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+
+    if (bind(udp->socket, (struct sockaddr *) &local, sizeof(local)) < 0) return -1;
+    if (getsockname(udp->socket, (struct sockaddr *) &local, &length) < 0) return -1;
+
+    return ntohs(local.sin_port);
+}
+
+/**
+ * Points a bound UDP socket at the other kiosk and fills in a
+ * transport that uses it
+ * @param udp
+ * @param address - IPv4 address of the other kiosk
+ * @param port
+ * @param transport
+*/
+void udp_transport_connect(udp_transport_t *udp, const char *address, int port, netplay_transport_t *transport) {
+    memset(&udp->peer, 0, sizeof(udp->peer));
+    udp->peer.sin_family = AF_INET;
+    udp->peer.sin_port = htons(port);
+    inet_pton(AF_INET, address, &udp->peer.sin_addr);
+
+    transport->send = udp_transport_send;
+    transport->receive = udp_transport_receive;
+    transport->context = udp;
+}
+
+bool udp_transport_send(void *context, const void *data, int size) {
+    udp_transport_t *udp = context;
+
+    return sendto(udp->socket, data, size, 0, (struct sockaddr *) &udp->peer, sizeof(udp->peer)) == size;
+}
+
+int udp_transport_receive(void *context, void *data, int size) {
+    udp_transport_t *udp = context;
+    int received = recv(udp->socket, data, size, MSG_DONTWAIT);
+
+    return received > 0 ? received : 0;
+}
+#endif
+
+// Replay
+/**
+ * Starts recording a game into a replay, from the state it is in now.
+ * @param replay
+ * @param game
+*/
+void replay_start(replay_t *replay, const game_state_t *game) {
+    replay_header_t *header = &replay->header;
+
+    memset(header, 0, sizeof(*header));
+    header->magic = REPLAY_MAGIC;
+    header->config = game->config;
+    header->keyframe_interval = REPLAY_KEYFRAME_FRAMES;
+}
+
+/**
+ * Records the input of the next frame, before it is simulated. Keyframes
+ * are snapshots of the state the frame starts from, indexed by frame
+ * so a seek finds one without searching.
+ * @param replay
+ * @param game - state at the start of the frame
+ * @param jump
+ * @return false once the replay is full and the frame was not recorded
+*/
+bool replay_record_frame(replay_t *replay, const game_state_t *game, bool jump) {
+    replay_header_t *header = &replay->header;
+    int frame = header->frame_count;
+
+    if (header->full) return false;
+
+    // The index is full at frame REPLAY_MAX_KEYFRAMES * interval, which
+    // is also a multiple of the doubled interval
+    if (frame % header->keyframe_interval == 0 && header->keyframe_count == REPLAY_MAX_KEYFRAMES) {
+        for (int i = 0; i < REPLAY_MAX_KEYFRAMES / 2; i++) {
+            replay->keyframes[i] = replay->keyframes[2 * i];
+        }
+
+        header->keyframe_count = REPLAY_MAX_KEYFRAMES / 2;
+        header->keyframe_interval *= 2;
+    }
+
+    if (frame % header->keyframe_interval == 0) {
+        replay_keyframe_t *keyframe = &replay->keyframes[header->keyframe_count++];
+
+        keyframe->frame = frame;
+        keyframe->input_offset = header->input_bytes;
+        keyframe->input_skip = header->idle_frames;
+        save_game_snapshot(game, &keyframe->snapshot);
+    }
+
+    if (jump) {
+        unsigned int run = header->idle_frames;
+
+        if (header->input_bytes + REPLAY_MAX_RECORD_BYTES > REPLAY_MAX_INPUT_BYTES) {
+            header->full = true;
+            return false;
+        }
+
+        while (run >= 0x80) {
+            replay->inputs[header->input_bytes++] = (run & 0x7F) | 0x80;
+            run >>= 7;
+        }
+        replay->inputs[header->input_bytes++] = run;
+        header->idle_frames = 0;
+    } else {
+        header->idle_frames++;
+    }
+
+    header->frame_count++;
+    return true;
+}
+
+/**
+ * Reads the input record at cursor->offset into cursor->idle. Past the
+ * last record the bird idles until the end of the replay.
+ * @param replay
+ * @param cursor - frame is where the run starts
+*/
+void replay_read_run(const replay_t *replay, replay_cursor_t *cursor) {
+    int idle = 0;
+    int shift = 0;
+    unsigned char byte;
+
+    if (cursor->offset >= replay->header.input_bytes) {
+        cursor->idle = replay->header.frame_count - cursor->frame;
+        return;
+    }
+
+    do {
+        byte = replay->inputs[cursor->offset++];
+        idle |= (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    cursor->idle = idle;
+}
+
+/**
+ * Returns the input of frame cursor->frame and moves the cursor to the
+ * next frame. Only call it before the end of the replay.
+ * @param replay
+ * @param cursor
+*/
+bool replay_next_input(const replay_t *replay, replay_cursor_t *cursor) {
+    cursor->frame++;
+
+    if (cursor->idle > 0) {
+        cursor->idle--;
+        return false;
+    }
+
+    replay_read_run(replay, cursor);
+    return true;
+}
+
+/**
+ * Puts a game in the state it was in at the start of a frame of a
+ * replay, and a cursor on that frame. The closest keyframe before the
+ * frame is restored and only the frames after it are simulated, with
+ * runs without jumps fast forwarded.
+ * @param replay
+ * @param frame - clamped to the length of the replay
+ * @param game - gets the config of the replay
+ * @param cursor
+ * @return the frame the game is at, or -1 if the replay is not valid
+*/
+int replay_seek(const replay_t *replay, int frame, game_state_t *game, replay_cursor_t *cursor) {
+    const replay_header_t *header = &replay->header;
+
+    if (header->magic != REPLAY_MAGIC || header->keyframe_count == 0) return -1;
+
+    frame = clamp(frame, 0, header->frame_count);
+
+    int index = frame / header->keyframe_interval;
+    const replay_keyframe_t *keyframe = &replay->keyframes[clamp(index, 0, header->keyframe_count - 1)];
+
+    game->config = header->config;
+    restore_game_snapshot(game, &keyframe->snapshot);
+
+    // The run of the keyframe started input_skip frames before it
+    cursor->frame = keyframe->frame - keyframe->input_skip;
+    cursor->offset = keyframe->input_offset;
+    replay_read_run(replay, cursor);
+    cursor->frame = keyframe->frame;
+    cursor->idle -= keyframe->input_skip;
+
+    while (cursor->frame < frame) {
+        if (cursor->idle > 0) {
+            int count = do_game_fast_forward(game, clamp(frame - cursor->frame, 1, cursor->idle));
+
+            // Only a replay from other rules ends before its last frame
+            if (count == 0) break;
+
+            cursor->frame += count;
+            cursor->idle -= count;
+        } else {
+            do_game_step(game, replay_next_input(replay, cursor));
+        }
+    }
+
+    // Grass is not simulated, but it scrolls the same every frame
+    game->grass_offset = (keyframe->snapshot.grass_offset
+        + (cursor->frame - keyframe->frame) * game->config.scroll_amount) % GRASS_PERIOD;
+
+    return cursor->frame;
+}
+
+
+void change_mode(game_state_t *game){
+    // Set by BREAK_CODE. The code after it is a key being let go, like
+    // the Enter that just left the replay, and must not act again
+    static bool released = false;
+    int PS2_data = ps2_read(); // read the Data register in the PS/2 port
+    int RVALID = PS2_data & 0x8000; // extract the RVALID field
+    if (RVALID) {
+        char key_data = PS2_data & 0xFF;
+        if (key_data == (char)BREAK_CODE) released = true;
+        else if (released) released = false;
+        //Enter has pressed when the mode is menu
+        else if((game -> mode) == MODE_MENU && key_data == (char)ENTER_KEY){
+            game->autopilot = false;
+            start_mode(game, MODE_GAME);
+        }
+        //N has pressed when the mode is menu, race another kiosk
+        else if((game -> mode) == MODE_MENU && key_data == (char)N_KEY && netplay_transport.send){
+            game->autopilot = false;
+            start_mode(game, MODE_NETPLAY);
+        }
+        //A has pressed when the mode is menu, let the autopilot play
+        else if((game -> mode) == MODE_MENU && key_data == (char)A_KEY){
+            game->autopilot = true;
+            start_mode(game, MODE_GAME);
+        }
+        else if((game -> mode) == MODE_GAME_OVER && key_data == (char)ENTER_KEY){
+            start_mode(game, MODE_GAME);
+        }
+        else if ((game -> mode) == MODE_GAME_OVER && key_data == (char)BACK_SPACE_KEY){
+            game->autopilot = false;
+            start_mode(game, MODE_MENU);
+        }
+        else if ((game -> mode) == MODE_GAME_OVER && key_data == (char)L_KEY){
+            report_input_latency();
+            report_frame_governor();
+            report_audio();
+        }
+        //R has pressed after a game played by hand. Bots restart on
+        //their own right away, so there is no replay for them
+        else if ((game -> mode) == MODE_GAME_OVER && key_data == (char)R_KEY && !game->autopilot){
+            erase_game_over_texts();
+            game->mode = MODE_REPLAY;
+        }
+    }
+}
+
+void start_mode(game_state_t *game, int mode){
+    erase_game_over_texts();
+    erase_menu_texts();
+    ps2_write(0xF4);
+    (game -> mode) = mode;
+    (game->score) = 0;
+    initialize_pipes(game);
+    initialize_grasses(game);
+    initialize_bird(&game->bird);
+}
+
+// Parameter sweep
+/**
+ * Decides whether the sweep bot jumps. It flaps whenever it is falling
+ * below the void of the next pipe, aiming a little off centre by a
+ * random amount so that it makes mistakes like a person would.
+ * @param game
+ * @param noise_seed - state of the bot's own random number generator
+*/
+bool sweep_bot_should_jump(const game_state_t *game, unsigned int *noise_seed) {
+    observation_t observation;
+
+    env_observe(game, &observation);
+
+    *noise_seed = *noise_seed * 1103515245 + 12345;
+    int noise = (int)((*noise_seed >> 16) & 0x7FFF) % (2 * SWEEP_AIM_NOISE + 1) - SWEEP_AIM_NOISE;
+    int below = BIRD_HEIGHT / 2 - observation.pipe_dy + noise;
+
+    return below > 0 && observation.bird_y_velocity < 0;
+}
+
+/**
+ * Plays games first_game to first_game + count - 1 with one config and
+ * adds them to result. Game i always uses seed i, so every config sees
+ * the same pipe heights. Ranges of games are independent and their
+ * results add up, so a sweep can be split across cores by games or
+ * by configs.
+ * @param config
+ * @param first_game
+ * @param count
+ * @param result - counts are added to, not cleared
+*/
+void sweep_config(const game_config_t *config, int first_game, int count, sweep_result_t *result) {
+    game_state_t game;
+
+    result->config = *config;
+
+    for (int i = first_game; i < first_game + count; i++) {
+        unsigned int noise_seed = i;
+        int frame = 0;
+
+        env_reset_config(&game, i, config);
+
+        for (; frame < SWEEP_MAX_FRAMES; frame++) {
+            if (frame % SWEEP_CURVE_STEP == 0) result->alive[frame / SWEEP_CURVE_STEP]++;
+
+            do_game_step(&game, sweep_bot_should_jump(&game, &noise_seed));
+            if (is_game_over(&game)) break;
+        }
+
+        if (frame == SWEEP_MAX_FRAMES) result->alive[SWEEP_CURVE_POINTS - 1]++;
+
+        result->score_histogram[clamp(game.score, 0, SWEEP_MAX_SCORE)]++;
+        result->games++;
+    }
+}
+
+// Lowest score that at least percent of the games stayed at or below
+int sweep_score_percentile(const sweep_result_t *result, int percent) {
+    int target = (result->games * percent + 99) / 100;
+    int seen = 0;
+
+    for (int score = 0; score < SWEEP_MAX_SCORE; score++) {
+        seen += result->score_histogram[score];
+        if (seen >= target) return score;
+    }
+
+    return SWEEP_MAX_SCORE;
+}
+
+/**
+ * Prints one config as CSV rows. The first column tells the tables
+ * apart: "config" has a row per config, "scores" a row per score any
+ * game ended with and "survival" a row per point of the survival curve
+ * @param index - config number, links rows of the three tables
+ * @param result
+*/
+void print_sweep_result(int index, const sweep_result_t *result) {
+    const game_config_t *config = &result->config;
+    long total = 0;
+    int max_score = 0;
+
+    for (int score = 0; score <= SWEEP_MAX_SCORE; score++) {
+        total += (long) score * result->score_histogram[score];
+        if (result->score_histogram[score]) max_score = score;
+    }
+
+    printf("config,%d,%d,%d,%.2f,%.2f,%d,%d,%.2f,%d,%d,%d\n",
+        index, config->pipe_void_height, config->pipe_spacing,
+        config->bird_gravity, config->bird_jump_velocity, config->scroll_amount,
+        result->games, (double) total / result->games,
+        sweep_score_percentile(result, 50), sweep_score_percentile(result, 90), max_score);
+
+    for (int score = 0; score <= SWEEP_MAX_SCORE; score++) {
+        if (result->score_histogram[score])
+            printf("scores,%d,%d,%d\n", index, score, result->score_histogram[score]);
+    }
+
+    for (int i = 0; i < SWEEP_CURVE_POINTS; i++) {
+        printf("survival,%d,%d,%d\n", index, i * SWEEP_CURVE_STEP, result->alive[i]);
+    }
+}
+
+/**
+ * Plays SWEEP_GAMES games for every config of the sweep grid, or for
+ * SWEEP_RANDOM_CONFIGS configs drawn from its ranges, and prints the
+ * results as they come. Runs on one core; see sweep_config for how to
+ * split the work.
+*/
+void run_parameter_sweep() {
+    int num_void_heights = sizeof(sweep_pipe_void_heights) / sizeof(int);
+    int num_spacings = sizeof(sweep_pipe_spacings) / sizeof(int);
+    int num_gravities = sizeof(sweep_bird_gravities) / sizeof(double);
+    int num_jump_velocities = sizeof(sweep_bird_jump_velocities) / sizeof(double);
+    int num_scroll_amounts = sizeof(sweep_scroll_amounts) / sizeof(int);
+    int num_configs = SWEEP_RANDOM_CONFIGS > 0 ? SWEEP_RANDOM_CONFIGS :
+        num_void_heights * num_spacings * num_gravities * num_jump_velocities * num_scroll_amounts;
+
+    printf("config,index,pipe_void_height,pipe_spacing,bird_gravity,bird_jump_velocity,"
+        "scroll_amount,games,mean_score,p50_score,p90_score,max_score\n");
+    printf("scores,index,score,games\n");
+    printf("survival,index,frame,alive\n");
+
+    for (int index = 0; index < num_configs; index++) {
+        sweep_result_t result;
+        game_config_t config;
+
+        memset(&result, 0, sizeof(result));
+
+        if (SWEEP_RANDOM_CONFIGS > 0) {
+            // Anywhere between the smallest and largest grid value
+            double t[5];
+            for (int i = 0; i < 5; i++) t[i] = (double) rand() / RAND_MAX;
+
+            config.pipe_void_height = sweep_pipe_void_heights[0] + (int)(t[0] *
+                (sweep_pipe_void_heights[num_void_heights - 1] - sweep_pipe_void_heights[0]));
+            config.pipe_spacing = sweep_pipe_spacings[0] + (int)(t[1] *
+                (sweep_pipe_spacings[num_spacings - 1] - sweep_pipe_spacings[0]));
+            config.bird_gravity = sweep_bird_gravities[0] + t[2] *
+                (sweep_bird_gravities[num_gravities - 1] - sweep_bird_gravities[0]);
+            config.bird_jump_velocity = sweep_bird_jump_velocities[0] + t[3] *
+                (sweep_bird_jump_velocities[num_jump_velocities - 1] - sweep_bird_jump_velocities[0]);
+            config.scroll_amount = sweep_scroll_amounts[0] + (int)(t[4] *
+                (sweep_scroll_amounts[num_scroll_amounts - 1] - sweep_scroll_amounts[0]) + 0.5);
+        } else {
+            // Grid index in mixed radix, last parameter fastest
+            int rest = index;
+
+            config.scroll_amount = sweep_scroll_amounts[rest % num_scroll_amounts];
+            rest /= num_scroll_amounts;
+            config.bird_jump_velocity = sweep_bird_jump_velocities[rest % num_jump_velocities];
+            rest /= num_jump_velocities;
+            config.bird_gravity = sweep_bird_gravities[rest % num_gravities];
+            rest /= num_gravities;
+            config.pipe_spacing = sweep_pipe_spacings[rest % num_spacings];
+            rest /= num_spacings;
+            config.pipe_void_height = sweep_pipe_void_heights[rest];
+        }
+
+        sweep_config(&config, 0, SWEEP_GAMES, &result);
+        print_sweep_result(index, &result);
+    }
+
+    printf("sweep of %d configs done\n", num_configs);
+}
+
+// Platform
+/**
+ * Where a buffer the devices use sits in memory. On the board that is
+ * the bus address itself; host builds keep the on-chip memory, SDRAM
+ * and character buffer in arrays.
+ * @param address - bus address
+*/
+char *board_memory(unsigned int address) {
+#if defined(__arm__)
+    return (char *)(uintptr_t) address;
+#else
+    if (address >= FPGA_CHAR_BASE) return host_char_buffer + (address - FPGA_CHAR_BASE);
+    if (address >= FPGA_ONCHIP_BASE) return host_onchip + (address - FPGA_ONCHIP_BASE);
+
+    return host_sdram + (address - SDRAM_BASE);
+#endif
+}
+
+// Pops the PS/2 data register: RVALID is bit 15 and RAVAIL, the bytes
+// still in the FIFO, is the top half
+int ps2_read() {
+#if defined(__arm__)
+    volatile int *PS2_ptr = (int *)PS2_BASE;
+
+    return *(PS2_ptr);
+#else
+    if (host_ps2.count == 0) return 0;
+
+    unsigned char data = host_ps2.fifo[host_ps2.start];
+    host_ps2.start = (host_ps2.start + 1) % PS2_FIFO_DEPTH;
+    host_ps2.count--;
+
+    return host_ps2.count << 16 | 0x8000 | data;
+#endif
+}
+
+// Sends a command byte to the keyboard. Host builds have none to tell
+void ps2_write(int command) {
+#if defined(__arm__)
+    volatile int *PS2_ptr = (int *)PS2_BASE;
+
+    *(PS2_ptr) = command;
+#else
+    (void) command;
+#endif
+}
 
-        // button shape for press enter to play again
-        // and press backspace to go to menu
-        draw_rect(70, 130, RESOLUTION_X - 70, 130 + 22, ORANGE);
-        draw_rect(70, 162, RESOLUTION_X - 70, 162 + 22, ORANGE);
-        draw_rect_outline(70, 130, RESOLUTION_X - 70, 130 + 22, BLACK);
-        draw_rect_outline(70, 162, RESOLUTION_X - 70, 162 + 22, BLACK);
+#if !defined(__arm__)
+// Queues a byte as if the keyboard sent it, dropped when the FIFO is
+// full like the port does
+void host_press_key(unsigned char code) {
+    if (host_ps2.count == PS2_FIFO_DEPTH) return;
 
-        //sisplay score and best score
-        draw_score(game->score, 200, 67);
-        draw_score(game->best_score, 200, 100);
+    host_ps2.fifo[(host_ps2.start + host_ps2.count++) % PS2_FIFO_DEPTH] = code;
+}
+#endif
+
+// Input latency
+// Time in timer ticks, counting up and wrapping every ~21 seconds.
+// Host builds count the monotonic clock in the same ticks
+unsigned int read_timer() {
+#if defined(__arm__)
+    volatile int *timer_ptr = (int *)MPCORE_PRIV_TIMER;
+    return 0xFFFFFFFF - *(timer_ptr + 1);
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned int)(((unsigned long long) now.tv_sec * 1000000000 + now.tv_nsec) * TIMER_TICKS_PER_US / 1000);
+#endif
+}
 
-        //check whether Enter or Back has pressed
-        change_mode(game);
-        do_scroll_grasses(game);
-        next_frame();
+// True while the PS/2 FIFO has data, without popping it
+bool key_pending() {
+#if defined(__arm__)
+    volatile int *PS2_ptr = (int *)PS2_BASE;
+
+    // RI is set while the FIFO has data
+    return *(PS2_ptr + 1) & 0x100;
+#else
+    return host_ps2.count > 0;
+#endif
+}
+
+/**
+ * Notes the time when the PS/2 FIFO goes from empty to non-empty. This
+ * is polled while waiting for vsync, so FIFO queueing time is part of
+ * the measured latency.
+*/
+void sample_keyboard_arrival() {
+    if (input_latency.arrival_valid) return;
+
+    if (key_pending()) {
+        input_latency.arrival_time = read_timer();
+        input_latency.arrival_valid = true;
     }
 }
 
-void erase_game_over_texts(){
-    //erase "SCORE: "
-    //erase "BEST: "
-    //erase "PRESS ENTER TO RESTART"
-    //erase "PRESS BACK TO GO TO MENU"
-    char text_for_score[] = "        \0 ";
-    char text_for_best_score[] = "       \0 ";
-    char text_for_restart[] = "                         \0";
-    char text_for_menu[] = "                             \0";
+/**
+ * Starts tracking a jump that is applied in this frame's update. The
+ * frame drawn before the update is swapped in by the next next_frame,
+ * so the jump first shows up on screen at the swap after that.
+ * @param arrival_time - when the key reached the PS/2 FIFO
+*/
+void record_jump_applied(unsigned int arrival_time) {
+    // A second press before the first shows up lands on the same swap
+    if (input_latency.swaps_until_visible > 0) return;
 
-    //use character buffer
-    video_text(27, 19, text_for_score);
-    video_text(27, 27, text_for_best_score);
-    video_text(27, 35, text_for_restart);
-    video_text(25, 43, text_for_menu);
+    input_latency.jump_time = arrival_time;
+    input_latency.swaps_until_visible = 2;
 }
 
-void draw_menu(game_state_t *game, bird_t bird) {
-    clear_read_FIFO();
-    game -> best_score = 0;
-    while (game -> mode == MODE_MENU) {
-        redraw_background(game);
-        draw_bird(bird);
-
-        //get the outline of  "FLAPPY BIRD"
-        draw_flappy_bird(85, 45, BLACK);
-        draw_flappy_bird(87, 45, BLACK);
-        draw_flappy_bird(86, 44, BLACK);
-        draw_flappy_bird(86, 46, BLACK);
-         //display "FLAPPY BIRD"
-        draw_flappy_bird(86, 45, WHITE);
-        
-        //display "PRESS SPACE TO LET THE BIRD JUMP"
-        //display "PRESS ENTER TO START"
-        char text_for_instruction[] = "PRESS SPACE TO LET THE BIRD JUMP\0";
-        char text_to_display[] = "PRESS ENTER TO START\0";
+void record_swap() {
+    if (input_latency.swaps_until_visible == 0) return;
+    if (--input_latency.swaps_until_visible > 0) return;
 
-        //use character buffer
-        video_text(31, 30, text_for_instruction);
-        video_text(37, 44, text_to_display);
+    unsigned int latency_us = (read_timer() - input_latency.jump_time) / TIMER_TICKS_PER_US;
+    int bucket = latency_us / LATENCY_BUCKET_US;
 
-        // button shape for press enter to start
-        // and press space
-        draw_rect(90, 110, RESOLUTION_X - 40, 110 + 22, ORANGE);
-        draw_rect(90, 167, RESOLUTION_X - 40, 167 + 22, ORANGE);
-        draw_rect_outline(90, 110, RESOLUTION_X - 40, 110 + 22, BLACK);
-        draw_rect_outline(90, 167, RESOLUTION_X - 40, 167 + 22, BLACK);
+    if (bucket >= LATENCY_NUM_BUCKETS) bucket = LATENCY_NUM_BUCKETS - 1;
 
-        //check whether Enter has pressed
-        change_mode(game);
-        do_scroll_grasses(game);
-        next_frame();
-    }
+    input_latency.histogram[bucket]++;
+    input_latency.count++;
 }
 
+/**
+ * Returns the latency in microseconds that the given percentage of
+ * jumps stayed under, rounded up to the histogram bucket
+ * @param percent
+*/
+unsigned int latency_percentile(int percent) {
+    unsigned int target = (input_latency.count * percent + 99) / 100;
+    unsigned int seen = 0;
 
-void erase_menu_texts(){
-    //erase "PRESS SPACE TO LET THE BIRD JUMP"
-    //erase "PRESS ENTER TO START"
-    char text_to_erase_instruction[] = "                                 \0";
-    char text_to_erase_display[] = "                    \0";
+    for (int i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+        seen += input_latency.histogram[i];
+        if (seen >= target) return (i + 1) * LATENCY_BUCKET_US;
+    }
 
-    //use character buffer
-    video_text(31, 30, text_to_erase_instruction);
-    video_text(37, 44, text_to_erase_display);
+    return LATENCY_NUM_BUCKETS * LATENCY_BUCKET_US;
 }
 
-void draw_grasses(grass_t grass[]){
-    int grass_top = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT;
-    int grass_bottom = RESOLUTION_Y - GROUND_THICKNESS;
+// Prints to the JTAG UART; press L on the game over screen
+void report_input_latency() {
+    printf("input latency over %u jumps: p50 %u us, p95 %u us, p99 %u us\n",
+        input_latency.count,
+        latency_percentile(50),
+        latency_percentile(95),
+        latency_percentile(99));
+}
 
-    // Draw grass blocks
-    for (int i = 0; i < NUM_GRASS_SQUARE; i++){
-        color_t grass_color = i % 2 == 0 ? LIGHT_GREEN : DARK_GREEN;
+// Audio
+/**
+ * Starts a clip on a free voice, or on the one that has played the
+ * longest if they are all busy
+ * @param clip
+ * @param gain - Q15
+*/
+void play_sound(const audio_clip_t *clip, short gain) {
+    audio_voice_t *voice = &audio_mixer.voices[0];
 
-        draw_slanted_rect(
-            grass[i].left_x, 
-            grass_top, 
-            grass[i].right_x, 
-            grass_bottom, 
-            grass_color
-        );
-    }
+    for (int i = 0; i < NUM_AUDIO_VOICES; i++) {
+        audio_voice_t *candidate = &audio_mixer.voices[i];
 
-    // Draw grass block outlines    
-    for (int i = 0; i < NUM_GRASS_SQUARE; i++){
-        draw_slanted_rect_outline(
-            grass[i].left_x, 
-            grass_top - 1, 
-            grass[i].right_x, 
-            grass_bottom + 1, 
-            BLACK
-        );
+        if (candidate->clip == NULL) {
+            voice = candidate;
+            break;
+        }
+        if (candidate->position > voice->position) voice = candidate;
     }
+
+    voice->clip = clip;
+    voice->position = 0;
+    voice->gain = gain;
 }
 
-void draw_background(game_state_t *game) {
-    // draw sky
-    for (int i = 0; i < RESOLUTION_X; i++) {
-        for (int j = 0; j < SKY_THICKNESS; j++) {
-            draw_pixel_optim(i, j, sky_img[j][i]);
+/**
+ * Mixes the next count samples of every active voice into out. Each
+ * sample is scaled by the voice's Q15 gain and summed with saturation.
+ * The vector kernels give bit-identical results.
+ * @param out - count samples
+ * @param count - at most AUDIO_BLOCK_SAMPLES
+*/
+void mix_audio_block(short *out, int count) {
+    memset(out, 0, count * sizeof(short));
+
+    for (int v = 0; v < NUM_AUDIO_VOICES; v++) {
+        audio_voice_t *voice = &audio_mixer.voices[v];
+
+        if (voice->clip == NULL) continue;
+
+        const short *in = voice->clip->samples + voice->position;
+        int n = clamp(voice->clip->length - voice->position, 0, count);
+        int i = 0;
+
+#if defined(__ARM_NEON)
+        int16x8_t gain = vdupq_n_s16(voice->gain);
+
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t scaled = vqdmulhq_s16(vld1q_s16(in + i), gain);
+            vst1q_s16(out + i, vqaddq_s16(vld1q_s16(out + i), scaled));
+        }
+#elif defined(__SSE2__)
+        __m128i gain = _mm_set1_epi16(voice->gain);
+
+        for (; i + 8 <= n; i += 8) {
+            __m128i s = _mm_loadu_si128((const __m128i *)(in + i));
+
+            // (s * gain) >> 15 out of the high and low halves of the product
+            __m128i hi = _mm_slli_epi16(_mm_mulhi_epi16(s, gain), 1);
+            __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(s, gain), 15);
+            __m128i scaled = _mm_or_si128(hi, lo);
+
+            __m128i *p = (__m128i *)(out + i);
+            _mm_storeu_si128(p, _mm_adds_epi16(_mm_loadu_si128(p), scaled));
+        }
+#endif
+
+        for (; i < n; i++) {
+            out[i] = clamp(out[i] + ((in[i] * voice->gain) >> 15), -32768, 32767);
         }
+
+        voice->position += n;
+        if (voice->position >= voice->clip->length) voice->clip = NULL;
     }
-    
-    //draw ground
-    draw_rect(0, RESOLUTION_Y - GROUND_THICKNESS + 1, RESOLUTION_X, RESOLUTION_Y, SAND);
-    //draw grass
-    draw_grasses(game->grasses);
 }
 
-void redraw_background(game_state_t *game){
-    // draw sky
-    for (int i = 0; i < RESOLUTION_X; i++) {
-        for (int j = 0; j < SKY_THICKNESS; j++) {
-            draw_pixel_optim(i, j, sky_img[j][i]);
-        }
+/**
+ * Tops the codec FIFO up with as many whole blocks as fit. Never waits
+ * on the codec, so it is safe to call from anywhere in a frame. Nothing
+ * is written while every voice is silent.
+*/
+void update_audio() {
+#if AUDIO_ENABLED
+    short block[AUDIO_BLOCK_SAMPLES];
+    int space = audio_fifo_space();
+
+    bool active = false;
+    for (int v = 0; v < NUM_AUDIO_VOICES; v++) {
+        if (audio_mixer.voices[v].clip != NULL) active = true;
     }
-    
-    //draw grass
-    draw_grasses(game->grasses);
+
+    // The FIFO ran dry in the middle of a sound
+    if (audio_mixer.playing && active && space == AUDIO_FIFO_DEPTH) audio_mixer.underruns++;
+
+    for (; active && space >= AUDIO_BLOCK_SAMPLES; space -= AUDIO_BLOCK_SAMPLES) {
+        mix_audio_block(block, AUDIO_BLOCK_SAMPLES);
+        audio_fifo_write(block, AUDIO_BLOCK_SAMPLES);
+    }
+
+    audio_mixer.playing = active;
+
+#if defined(__arm__)
+    // Only ask for a write interrupt while there is something to write,
+    // an empty FIFO would wake the frame governor straight away
+    volatile int *audio_ptr = (int *)AUDIO_BASE;
+    *(audio_ptr) = active ? 0b10 : 0;
+#endif
+#endif
 }
 
-// Control bird's position
-void do_bird_velocity(bird_t* bird){
-    //update y position
-    bird->y -= bird->y_velocity;
+// Samples that fit in both channels of the codec FIFO
+int audio_fifo_space() {
+#if defined(__arm__)
+    volatile int *audio_ptr = (int *)AUDIO_BASE;
+    int fifospace = *(audio_ptr + 1);
+    int right_space = (fifospace >> 16) & 0xFF;
+    int left_space = (fifospace >> 24) & 0xFF;
+
+    return clamp(right_space, 0, left_space);
+#else
+    audio_host_catch_up();
+    return AUDIO_FIFO_DEPTH - host_audio.fifo_count;
+#endif
+}
 
-    //update y velocity
-    bird->y_velocity -= BIRD_GRAVITY;
+/**
+ * Queues samples on both channels of the codec. There must be room
+ * for them, see audio_fifo_space
+ * @param block
+ * @param count
+*/
+void audio_fifo_write(const short *block, int count) {
+#if defined(__arm__)
+    volatile int *audio_ptr = (int *)AUDIO_BASE;
+
+    // The port takes 32 bit samples, 16 bit audio goes in the top half
+    for (int i = 0; i < count; i++) {
+        *(audio_ptr + 2) = (unsigned int) block[i] << 16;
+        *(audio_ptr + 3) = (unsigned int) block[i] << 16;
+    }
+#else
+    for (int i = 0; i < count; i++) {
+        int slot = (host_audio.fifo_start + host_audio.fifo_count++) % AUDIO_FIFO_DEPTH;
+
+        host_audio.fifo[slot] = block[i];
+    }
+#endif
 }
 
-void do_bird_jump(bird_t* bird){
-    //bird will jump when the user pressed space key
-    volatile int * PS2_ptr = (int *)PS2_BASE;
-    int PS2_data = *(PS2_ptr); // read the Data register in the PS/2 port
-    int RVALID = PS2_data & 0x8000; // extract the RVALID field
-    if (RVALID) {
-        char key_data = PS2_data & 0xFF;
-        if (key_data == (char) SPACE_KEY){
-            bird->y_velocity = BIRD_JUMP_VELOCITY;
+#if !defined(__arm__)
+/**
+ * Plays count samples out of the host FIFO into the WAV file, silence
+ * once it is empty. Stands in for the time passing between calls to
+ * update_audio.
+ * @param count
+*/
+void audio_host_play(int count) {
+    for (int i = 0; i < count; i++) {
+        short sample = 0;
+
+        if (host_audio.fifo_count > 0) {
+            sample = host_audio.fifo[host_audio.fifo_start];
+            host_audio.fifo_start = (host_audio.fifo_start + 1) % AUDIO_FIFO_DEPTH;
+            host_audio.fifo_count--;
+        } else {
+            host_audio.samples_dry++;
         }
+
+        if (host_audio.wav) fwrite(&sample, sizeof(sample), 1, host_audio.wav);
+        host_audio.samples_played++;
     }
 }
 
-void do_scroll_pipes(game_state_t *game) {
+// CPU time this thread has used, in ns
+unsigned long long audio_host_cpu_ns() {
+    struct timespec now;
 
-    pipe_t *prev_pipe = &game->pipes[NUM_PIPES - 1];
-    
-    // Wrap around pipes
-    for (int i = 0; i < NUM_PIPES; i++) {
-        pipe_t *curr_pipe = &game->pipes[i];
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (unsigned long long) now.tv_sec * 1000000000 + now.tv_nsec;
+}
 
-        if (curr_pipe->x < -PIPE_WIDTH / 2) {
-            // Place pipe to the right of the previous pipe
-            // since we know the previous pipe is the one that's on
-            // the very right of the screen and is offscreen
-            curr_pipe->did_score_update = false;
-            curr_pipe->x = prev_pipe->x + PIPE_SPACING;
-			
-			// We also generate a new height for y position
-			curr_pipe->y = rand() % (RESOLUTION_Y - PIPE_VOID_HEIGHT * 2 - TOTAL_FLOOR_HEIGHT) + PIPE_VOID_HEIGHT;
-        }
+// Makes the host codec play by CPU time from now on
+void audio_host_start_clock() {
+    host_audio.clocked = true;
+    host_audio.clock_start = audio_host_cpu_ns();
+    host_audio.clock_samples = 0;
+}
 
-        prev_pipe = curr_pipe;
-    }
+// Plays what the codec would have played since it was last asked
+void audio_host_catch_up() {
+    if (!host_audio.clocked) return;
 
-    // Scroll pipes
-    for (int i = 0; i < NUM_PIPES; i++) {
-        pipe_t *pipe = &game->pipes[i];
+    unsigned long long due = (audio_host_cpu_ns() - host_audio.clock_start) * AUDIO_SAMPLE_RATE / 1000000000;
 
-        pipe->x -= SCROLL_VIEW_AMOUNT;
+    audio_host_play(due - host_audio.clock_samples);
+    host_audio.clock_samples = due;
+}
+
+// RIFF header of a mono 16 bit WAV file at AUDIO_SAMPLE_RATE
+void audio_wav_header(unsigned char header[44], unsigned int samples) {
+    unsigned int fields[] = {
+        0x46464952, 36 + samples * 2, 0x45564157, 0x20746D66, 16,
+        1 | (1 << 16), AUDIO_SAMPLE_RATE, AUDIO_SAMPLE_RATE * 2, 2 | (16 << 16),
+        0x61746164, samples * 2
+    };
+
+    // Little endian whatever the host is
+    for (int i = 0; i < 44; i++) {
+        header[i] = fields[i / 4] >> (8 * (i % 4));
     }
 }
 
-void do_scroll_grasses(game_state_t *game) {
-    // Scroll grasses
-    grass_t *prev_grass = &game->grasses[NUM_GRASS_SQUARE - 1];
-    grass_t *curr_grass;
+/**
+ * Starts a WAV file that audio_host_play appends to, and empties the
+ * host FIFO
+ * @param path
+ * @return false if the file could not be created
+*/
+bool audio_wav_open(const char *path) {
+    unsigned char header[44];
 
-    // Wrap around grasses
-    for (int i = 0; i < NUM_GRASS_SQUARE; i++) {
-        curr_grass = &game->grasses[i];
+    host_audio.wav = fopen(path, "wb");
+    host_audio.fifo_start = 0;
+    host_audio.fifo_count = 0;
+    host_audio.samples_played = 0;
 
-        if (curr_grass->right_x < 0) {
-            // Place grass square to the right of the rightmost square
-            curr_grass->left_x = prev_grass->right_x;
-            curr_grass->right_x = prev_grass->right_x + GRASS_SQUARE_WIDTH;  
-        }
+    if (host_audio.wav == NULL) return false;
 
-        prev_grass = curr_grass;
-    }
+    audio_wav_header(header, 0);
+    fwrite(header, sizeof(header), 1, host_audio.wav);
+    return true;
+}
 
-    // Move all grasses
-    for (int i = 0; i < NUM_GRASS_SQUARE; i++) {
-        grass_t *grass = &game->grasses[i];
+// Fills in the sizes in the header now that they are known
+void audio_wav_close() {
+    unsigned char header[44];
 
-        grass->left_x -= SCROLL_VIEW_AMOUNT;
-        grass->right_x -= SCROLL_VIEW_AMOUNT;
-    }
+    if (host_audio.wav == NULL) return;
+
+    audio_wav_header(header, host_audio.samples_played);
+    fseek(host_audio.wav, 0, SEEK_SET);
+    fwrite(header, sizeof(header), 1, host_audio.wav);
+    fclose(host_audio.wav);
+    host_audio.wav = NULL;
 }
+#endif
 
-void do_scroll_view(game_state_t *game) {   
-    do_scroll_pipes(game);
-    do_scroll_grasses(game);
+/**
+ * Phase accumulator increment for a tone
+ * @param frequency - Hz
+*/
+int audio_phase_step(int frequency) {
+    return (int)(((unsigned long long) frequency << 32) / AUDIO_SAMPLE_RATE);
 }
 
-void do_update_score(game_state_t *game) {
-    for (int i = 0; i < NUM_PIPES; i++) {
-        pipe_t *pipe = &game->pipes[i];
+// Triangle wave of full amplitude at a phase from a phase accumulator
+short triangle_wave(unsigned int phase) {
+    int t = phase >> 16;
 
-        int bird_center_x = game->bird.x + BIRD_WIDTH / 2;
-        bool did_pipe_pass_bird = pipe->x < bird_center_x;
-        bool did_score_update = pipe->did_score_update;
+    if (t < 32768) return t * 2 - 32768;
+    return 32767 - (t - 32768) * 2;
+}
 
-        if (did_pipe_pass_bird && !did_score_update) {
-            pipe->did_score_update = true;
-            game->score++;
-        }
-    }
+// Prints to the JTAG UART; press L on the game over screen
+void report_audio() {
+    printf("audio underruns: %u\n", audio_mixer.underruns);
 }
 
-void do_update_best_score(game_state_t *game){
-    if (game->score > game->best_score) {
-        game->best_score = game->score;
+// Frame governor
+/**
+ * Sleeps until GOVERNOR_WAKE_MARGIN_US before the next swap is due. A
+ * key press ends the sleep early so its arrival time stays exact, and
+ * frames that are already late don't sleep at all.
+ * @param work_end - read_timer when the frame was done
+*/
+void governor_idle(unsigned int work_end) {
+    unsigned int budget = (FRAME_PERIOD_US - GOVERNOR_WAKE_MARGIN_US) * TIMER_TICKS_PER_US;
+
+    if (!frame_governor.started) return;
+
+    for (unsigned int now = work_end; now - frame_governor.last_swap < budget; now = read_timer()) {
+        if (key_pending()) break;
+
+        sleep_for_us((budget - (now - frame_governor.last_swap)) / TIMER_TICKS_PER_US);
+        sample_keyboard_arrival();
+        update_audio();
     }
 }
 
 /**
- * return true when the bird and the pipe collide, return false when they don't collide
+ * Arms the interval timer as a one shot and waits for an interrupt:
+ * the timer, a key, or the audio FIFO running low. Host builds have
+ * none of that and just sleep, in the browser by handing the time back
+ * to the page.
+ * @param us
 */
-bool did_collide(bird_t bird, pipe_t pipe){
-    //these four lines form a rectangle of void space between top pipe and bottom pipe
-    //pipe_void_x1 < pipe_void_x2, pipe_void_y1 < pipe_void_y2
-    int pipe_void_x1 = pipe.x - (pipe.width / 2);
-    int pipe_void_x2 = pipe.x + (pipe.width / 2);
-    int pipe_void_y1 = pipe.y - (pipe.void_height / 2);
-    int pipe_void_y2 = pipe.y + (pipe.void_height / 2);
+void sleep_for_us(unsigned int us) {
+#if defined(__arm__)
+    volatile int *timer_ptr = (int *)TIMER_BASE;
+    unsigned int ticks = us * INTERVAL_TIMER_TICKS_PER_US;
+
+    if (ticks == 0) return;
+
+    // Stop, load the period, then start with ITO set and CONT clear
+    *(timer_ptr + 1) = 0b1000;
+    *(timer_ptr) = 0;
+    *(timer_ptr + 2) = ticks & 0xFFFF;
+    *(timer_ptr + 3) = ticks >> 16;
+    *(timer_ptr + 1) = 0b0101;
+
+    __asm__ volatile ("wfi");
+
+    acknowledge_interrupt();
+#elif defined(__EMSCRIPTEN__)
+    // Needs -sASYNCIFY, see demo/build_wasm.sh
+    emscripten_sleep(us / 1000);
+#else
+    struct timespec duration = {us / 1000000, (us % 1000000) * 1000};
+
+    if (us == 0) return;
+
+    // Restarts with what is left when a signal cuts it short
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, &duration) == EINTR);
+#endif
+}
 
-    //check whether the bird and the pipe collides
-    //the bird hasn't reached the pipe or the bird has already passed the pipe
-    if(bird.x + BIRD_WIDTH - 1 < pipe_void_x1 || bird.x > pipe_void_x2){
-        return false;
-    }
-    //some portion of the bird is in between the top and bottom pipe
-    else{
-        //y coordinate of the bird is within the void region
-        if(bird.y >= pipe_void_y1 && bird.y + BIRD_HEIGHT - 1 <= pipe_void_y2){
-            return false;
-        }
-        //the bird and the pipe collide
-        else{
-            return true;
-        }
+/**
+ * Takes the pending interrupt off the GIC. The PS/2 interrupt stays
+ * asserted until its FIFO is read, so only the timer is cleared at the
+ * source.
+*/
+void acknowledge_interrupt() {
+    volatile int *cpu_interface = (int *)MPCORE_GIC_CPUIF;
+    volatile int *timer_ptr = (int *)TIMER_BASE;
+    int id = *(cpu_interface + 3) & 0x3FF;
+
+    // 1023 is the spurious ID, nothing was pending
+    if (id == 1023) return;
+
+    if (id == INTERVAL_TIMER_IRQ) *(timer_ptr) = 0;
+    *(cpu_interface + 4) = id;
+}
+
+/**
+ * Adds the frame that was just swapped in to the totals
+ * @param work_end - read_timer when the frame was done
+ * @param wake_time - read_timer after governor_idle returned
+*/
+void governor_record_swap(unsigned int work_end, unsigned int wake_time) {
+    unsigned int now = read_timer();
+
+    if (frame_governor.started) {
+        unsigned int frame = now - frame_governor.last_swap;
+
+        frame_governor.work_ticks += work_end - frame_governor.last_swap;
+        frame_governor.sleep_ticks += wake_time - work_end;
+        frame_governor.frame_ticks += frame;
+        frame_governor.frames++;
+
+        if (frame > FRAME_PERIOD_US * TIMER_TICKS_PER_US * 3 / 2) frame_governor.missed++;
     }
+
+    frame_governor.last_swap = now;
+    frame_governor.started = true;
 }
 
-inline bool bird_in_screen(bird_t bird) {
-    return is_out_of_bounds(bird.y, 0, RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - BIRD_HEIGHT);
+// Prints to the JTAG UART; press L on the game over screen
+void report_frame_governor() {
+    if (frame_governor.frame_ticks == 0) return;
+
+    printf("frames: %u, cpu busy %llu%%, asleep %llu%%, missed deadlines %u\n",
+        frame_governor.frames,
+        frame_governor.work_ticks * 100 / frame_governor.frame_ticks,
+        frame_governor.sleep_ticks * 100 / frame_governor.frame_ticks,
+        frame_governor.missed);
 }
 
-// Game logic
-inline bool is_game_over(game_state_t *game) {
-    for (int i = 0; i < NUM_PIPES; i++) {
-        if (did_collide(game->bird, game->pipes[i]))
-            return true;
+// Screen/VGA
+void next_frame() {
+    // The frame was drawn or simulated since the FIFO was last topped
+    // up, and resolving and upscaling can take longer than it lasts
+    update_audio();
+
+    // Draw what was recorded this frame before it is shown
+    resolve_display_list(&screen_surface);
+
+    // Blow the native frame up into the back buffer before swapping
+    if (output_scale > 1) {
+        output_surface.base = board_memory(*(pixel_ctrl_ptr + 1));
+        upscale_surface(&native_surface, &output_surface, output_scale);
     }
 
-    return bird_in_screen(game->bird);
-}
+    update_audio();
 
+    unsigned int work_end = read_timer();
+#if FRAME_GOVERNOR
+    governor_idle(work_end);
+#endif
+    unsigned int wake_time = read_timer();
 
-void change_mode(game_state_t *game){
-    volatile int * PS2_ptr = (int *)PS2_BASE;
-    int PS2_data = *(PS2_ptr); // read the Data register in the PS/2 port
-    int RVALID = PS2_data & 0x8000; // extract the RVALID field
-    if (RVALID) {
-        char key_data = PS2_data & 0xFF;
-        //Enter has pressed when the mode is menu
-        if((game -> mode) == MODE_MENU && key_data == (char)ENTER_KEY){
-            erase_game_over_texts();
-            erase_menu_texts();
-            *(PS2_ptr) = 0xF4;
-            (game -> mode) = MODE_GAME;
-            (game->score) = 0;
-            initialize_pipes(game->pipes);
-            initialize_grasses(game->grasses);
-            initialize_bird(&game->bird);
+    // Swap front and back buffers on vsync and update buffer pointer
+    wait_for_vsync();
+    governor_record_swap(work_end, wake_time);
+    record_swap();
+    animation_tick++;
+    if (output_scale == 1) screen_surface.base = board_memory(*(pixel_ctrl_ptr + 1));
+}
+
+/**
+ * Nearest-neighbour upscales one row. 2x and 3x write two pixels per
+ * 32 bit store; out has to be 4 byte aligned for those.
+ * @param out - first of width * scale output pixels
+ * @param in - first of width input pixels
+ * @param width - input pixels
+ * @param scale
+*/
+void upscale_row(unsigned short *out, const unsigned short *in, int width, int scale) {
+    color_pair_t *out_pair = (color_pair_t *) out;
+    int x = 0;
+
+    if (scale == 2) {
+        for (; x < width; x++) {
+            unsigned int p = in[x];
+            out_pair[x] = p | (p << 16);
         }
-        else if((game -> mode) == MODE_GAME_OVER && key_data == (char)ENTER_KEY){
-            erase_game_over_texts();
-            erase_menu_texts();
-            *(PS2_ptr) = 0xF4;
-            (game -> mode) = MODE_GAME;
-            (game->score) = 0;
-            initialize_pipes(game->pipes);
-            initialize_grasses(game->grasses);
-            initialize_bird(&game->bird);
+        return;
+    }
+
+    if (scale == 3) {
+        // Two input pixels a, b become the pairs aa ab bb
+        for (; x + 2 <= width; x += 2) {
+            unsigned int a = in[x];
+            unsigned int b = in[x + 1];
+
+            *out_pair++ = a | (a << 16);
+            *out_pair++ = a | (b << 16);
+            *out_pair++ = b | (b << 16);
         }
-        else if ((game -> mode) == MODE_GAME_OVER && key_data == (char)BACK_SPACE_KEY){
-            erase_game_over_texts();
-            erase_menu_texts();
-            *(PS2_ptr) = 0xF4;
-            (game -> mode) = MODE_MENU;
-            (game->score) = 0;
-            initialize_pipes(game->pipes);
-            initialize_grasses(game->grasses);
-            initialize_bird(&game->bird);
+    }
+
+    for (; x < width; x++) {
+        for (int i = 0; i < scale; i++) {
+            out[x * scale + i] = in[x];
         }
     }
 }
 
-// Screen/VGA
-void next_frame() {
-    // Swap front and back buffers on vsync and update buffer pointer
-    wait_for_vsync();
-    pixel_buffer_start = *(pixel_ctrl_ptr + 1);
+/**
+ * Upscales src by an integer factor into the centre of dst. Each input
+ * row is expanded once and then copied to the other scale - 1 rows.
+ * @param src
+ * @param dst - has to be at least scale times larger than src
+ * @param scale
+*/
+void upscale_surface(const surface_t *src, const surface_t *dst, int scale) {
+    int out_width = src->width * scale;
+
+    // Keep the left edge on an even pixel so pair stores stay aligned
+    int left = ((dst->width - out_width) / 2) & ~1;
+    int top = (dst->height - src->height * scale) / 2;
+
+    for (int y = 0; y < src->height; y++) {
+        const unsigned short *in = (const unsigned short *)(src->base + y * src->stride);
+        char *out = dst->base + (top + y * scale) * dst->stride + (left << 1);
+
+        upscale_row((unsigned short *) out, in, src->width, scale);
+
+        for (int i = 1; i < scale; i++) {
+            memcpy(out + i * dst->stride, out, out_width * sizeof(short int));
+        }
+
+        // A large frame takes longer to write out than the FIFO lasts
+        update_audio();
+    }
 }
 
 void wait_for_vsync() {
+#if defined(__arm__)
     volatile int *status = pixel_ctrl_ptr + 3;
 
     // Write one to buffer register to request Vsync
@@ -1063,13 +5546,26 @@ void wait_for_vsync() {
     while (true) {
         // Wait until S bit becomes zero
         if (((*status) & 1) == 0) return;
+
+        sample_keyboard_arrival();
+        update_audio();
     }
+#else
+    // Swap the buffers the way the controller does on vsync
+    int front = *pixel_ctrl_ptr;
+
+    *pixel_ctrl_ptr = *(pixel_ctrl_ptr + 1);
+    *(pixel_ctrl_ptr + 1) = front;
+
+    sample_keyboard_arrival();
+    if (host_frame_hook) host_frame_hook();
+#endif
 }
 
 //taken from https://ftp.intel.com/Public/Pub/fpgaup/pub/Intel_Material/18.1/Computer_Systems/DE1-SoC/DE1-SoC_Computer_NiosII.pdf
 void video_text(int x, int y, char * text_ptr) {
     int offset;
-    volatile char * character_buffer = (char *)FPGA_CHAR_BASE; // video character buffer
+    volatile char * character_buffer = board_memory(FPGA_CHAR_BASE); // video character buffer
     /* assume that the text string fits on one line */
     offset = (y << 7) + x;
     while (*(text_ptr)) {
@@ -1080,241 +5576,26 @@ void video_text(int x, int y, char * text_ptr) {
 }
 
 void clear_read_FIFO(){
-    volatile int * PS2_ptr = (int *)PS2_BASE;
-    *(PS2_ptr) = 0xF5; //disable keyboard input
+    ps2_write(0xF5); //disable keyboard input
     //clear read FIFO
-    int PS2_data = *(PS2_ptr); // read the Data register in the PS/2 port
+    int PS2_data = ps2_read(); // read the Data register in the PS/2 port
     int RVALID = PS2_data & 0x8000; // extract the RVALID field
     while (RVALID) {
-        PS2_data = *(PS2_ptr); // read the Data register in the PS/2 port
+        PS2_data = ps2_read(); // read the Data register in the PS/2 port
         RVALID = PS2_data & 0x8000; // extract the RVALID field
     }
-    *(PS2_ptr) = 0xF4; //enable keyboard input
-}
-
-void draw_flappy_bird(int x, int y, color_t line_color){
-    //draw F
-    draw_rect(x + 1, y, x + 3, y + 17, line_color);
-    draw_rect(x + 3, y, x + 14, y + 2, line_color);
-    draw_rect(x + 3, y + 7, x + 12, y + 9, line_color);
-    //draw L
-	draw_rect(x + 20, y, x + 22, y + 17, line_color);
-    draw_rect(x + 22, y + 15, x + 32, y + 17, line_color);
-    //draw A
-    draw_rect(x + 44, y, x + 48, y + 1, line_color); 
-    draw_rect(x + 43, y + 2, x + 45, y + 4, line_color);
-    draw_rect(x + 42, y + 5, x + 44, y + 7, line_color);
-    draw_rect(x + 41, y + 8, x + 43, y + 10, line_color);
-    draw_rect(x + 40, y + 11, x + 42, y + 13, line_color);
-    draw_rect(x + 39, y + 14, x + 41, y + 16, line_color);
-    draw_rect(x + 38, y + 17, x + 40, y + 17, line_color);
-    draw_rect(x + 47, y + 2, x + 49, y + 4, line_color);
-    draw_rect(x + 48, y + 5, x + 50, y + 7, line_color);
-    draw_rect(x + 49, y + 8, x + 51, y + 10, line_color);
-    draw_rect(x + 50, y + 11, x + 52, y + 13, line_color);
-    draw_rect(x + 51, y + 14, x + 53, y + 16, line_color);
-    draw_rect(x + 52, y + 17, x + 54, y + 17, line_color);
-    draw_rect(x + 43, y + 9, x + 49, y + 11, line_color);
-    //draw P
-    draw_rect(x + 58, y, x + 60, y + 17, line_color); 
-    draw_rect(x + 61, y, x + 66, y + 1, line_color);
-    draw_rect(x + 67, y + 1, x + 69, y + 1, line_color);
-    draw_rect(x + 67, y + 2, x + 70, y + 2, line_color);
-    draw_rect(x + 69, y + 3, x + 71, y + 3, line_color);
-    draw_rect(x + 69, y + 4, x + 71, y + 5, line_color);
-    draw_rect(x + 69, y + 6, x + 71, y + 6, line_color);
-    draw_rect(x + 67, y + 7, x + 70, y + 7, line_color);
-    draw_rect(x + 67, y + 8, x + 69, y + 8, line_color);
-    draw_rect(x + 61, y + 8, x + 66, y + 9, line_color);
-    //draw P
-    draw_rect(x + 77, y, x + 79, y + 17, line_color); 
-    draw_rect(x + 80, y, x + 85, y + 1, line_color);
-    draw_rect(x + 86, y + 1, x + 88, y + 1, line_color);
-    draw_rect(x + 86, y + 2, x + 89, y + 2, line_color);
-    draw_rect(x + 88, y + 3, x + 90, y + 3, line_color);
-    draw_rect(x + 88, y + 4, x + 90, y + 5, line_color);
-    draw_rect(x + 88, y + 6, x + 90, y + 6, line_color);
-    draw_rect(x + 86, y + 7, x + 89 , y + 7, line_color);
-    draw_rect(x + 86, y + 8, x + 88, y + 8, line_color);
-    draw_rect(x + 80, y + 8, x + 85, y + 9, line_color);
-    //draw Y
-    draw_rect(x + 95, y, x + 97, y, line_color); 
-    draw_rect(x + 96, y + 1, x + 98, y + 2, line_color);
-    draw_rect(x + 97, y + 3, x + 99, y + 3, line_color);
-    draw_rect(x + 98, y + 4, x + 100, y + 5, line_color);
-    draw_rect(x + 99, y + 6, x + 101, y + 6, line_color);
-    draw_rect(x + 100, y + 7, x + 102, y + 7, line_color);
-    draw_rect(x + 101, y + 8, x + 104, y + 8, line_color);
-    draw_rect(x + 108, y, x + 110, y, line_color);
-    draw_rect(x + 107, y + 1, x + 109, y + 2, line_color);
-    draw_rect(x + 106, y + 3, x + 108, y + 3, line_color);
-    draw_rect(x + 105, y + 4, x + 107, y + 5, line_color);
-    draw_rect(x + 104, y + 6, x + 106, y + 6, line_color);
-    draw_rect(x + 103, y + 7, x + 105, y + 7, line_color);
-    draw_rect(x + 101, y + 9, x + 104, y + 17, line_color);
-
-    //starting point of B
-    int bird_x = x + 130;
-
-    //draw B
-    draw_rect(bird_x + 1, y, bird_x + 3, y + 17, line_color); 
-    draw_rect(bird_x + 4, y, bird_x + 9, y + 1, line_color);
-    draw_rect(bird_x + 10, y + 1, bird_x + 12, y + 1, line_color);
-    draw_rect(bird_x + 10, y + 2, bird_x + 13, y + 2, line_color);
-    draw_rect(bird_x + 12, y + 3, bird_x + 14, y + 3, line_color);
-    draw_rect(bird_x + 12, y + 4, bird_x + 14, y + 5, line_color);
-    draw_rect(bird_x + 12, y + 6, bird_x + 14, y + 6, line_color);
-    draw_rect(bird_x + 10, y + 7, bird_x + 13, y + 7, line_color);
-    draw_rect(bird_x + 4, y + 8, bird_x + 12, y + 9, line_color);
-    draw_rect(bird_x + 4, y + 16, bird_x + 9, y + 17, line_color);
-    draw_rect(bird_x + 10, y + 16, bird_x + 12, y + 16, line_color);
-    draw_rect(bird_x + 10, y + 15, bird_x + 13, y + 15, line_color);
-    draw_rect(bird_x + 12, y + 14, bird_x + 14, y + 14, line_color);
-    draw_rect(bird_x + 12, y + 12, bird_x + 14, y + 13, line_color);
-    draw_rect(bird_x + 12, y + 11, bird_x + 14, y + 11, line_color);
-    draw_rect(bird_x + 10, y + 10, bird_x + 13, y + 10, line_color);
-    //draw I
-    draw_rect(bird_x + 21, y, bird_x + 30, y + 2, line_color); 
-    draw_rect(bird_x + 24, y + 2, bird_x + 27, y + 15, line_color);
-    draw_rect(bird_x + 21, y + 15, bird_x + 30, y + 17, line_color);
-    //draw R
-    draw_rect(bird_x + 37, y, bird_x + 39, y + 17, line_color); 
-    draw_rect(bird_x + 40, y, bird_x + 45, y + 1, line_color);
-    draw_rect(bird_x + 46, y + 1, bird_x + 48, y + 1, line_color);
-    draw_rect(bird_x + 46, y + 2, bird_x + 49, y + 2, line_color);
-    draw_rect(bird_x + 48, y + 3, bird_x + 50, y + 3, line_color);
-    draw_rect(bird_x + 48, y + 4, bird_x + 50, y + 5, line_color);
-    draw_rect(bird_x + 48, y + 6, bird_x + 50, y + 6, line_color);
-    draw_rect(bird_x + 46, y + 7, bird_x + 49, y + 7, line_color);
-    draw_rect(bird_x + 46, y + 8, bird_x + 48, y + 8, line_color);
-    draw_rect(bird_x + 40, y + 8, bird_x + 45, y + 9, line_color);
-    draw_rect(bird_x + 43, y + 9, bird_x + 45, y + 10, line_color);
-	draw_rect(bird_x + 44, y + 10, bird_x + 46, y + 10, line_color);
-    draw_rect(bird_x + 45, y + 11, bird_x + 47, y + 11, line_color);
-    draw_rect(bird_x + 46, y + 12, bird_x + 48, y + 13, line_color);
-    draw_rect(bird_x + 47, y + 14, bird_x + 49, y + 14, line_color);
-    draw_rect(bird_x + 48, y + 15, bird_x + 50, y + 16, line_color);
-    draw_rect(bird_x + 49, y + 17, bird_x + 51, y + 17, line_color);
-    //draw D
-    draw_rect(bird_x + 57, y, bird_x + 59, y + 17, line_color); 
-    draw_rect(bird_x + 60, y, bird_x + 63, y + 1, line_color);
-    draw_rect(bird_x + 64, y + 1, bird_x + 65, y + 2, line_color);
-    draw_rect(bird_x + 65, y + 2, bird_x + 67, y + 3, line_color); 
-    draw_rect(bird_x + 66, y + 3, bird_x + 68, y + 4, line_color);
-    draw_rect(bird_x + 67, y + 5, bird_x + 69, y + 6, line_color);
-    draw_rect(bird_x + 68, y + 7, bird_x + 70, y + 10, line_color);
-    draw_rect(bird_x + 60, y + 16, bird_x + 63, y + 17, line_color);
-    draw_rect(bird_x + 64, y + 15, bird_x + 65, y + 16, line_color);
-    draw_rect(bird_x + 65, y + 14, bird_x + 67, y + 15, line_color); 
-    draw_rect(bird_x + 66, y + 13, bird_x + 68, y + 14, line_color);
-    draw_rect(bird_x + 67, y + 11, bird_x + 69, y + 12, line_color);
-}
-
-void draw_word_game_over(int x, int y, color_t line_color){
-    //draw G 
-    draw_rect(x + 1, y + 6, x + 3, y + 11, line_color);
-    draw_rect(x + 2, y + 3, x + 4, y + 5, line_color);
-    draw_rect(x + 4, y + 1, x + 5, y + 3, line_color);
-    draw_rect(x + 6, y, x + 6, y + 2, line_color);
-    draw_rect(x + 7, y, x + 10, y + 1, line_color);  
-    draw_rect(x + 11, y, x + 11, y + 2, line_color);
-    draw_rect(x + 12, y + 1, x + 12, y + 3, line_color);
-    draw_rect(x + 13, y + 2, x + 14, y + 3, line_color);
-    draw_rect(x + 2, y + 12, x + 4, y + 14, line_color);
-    draw_rect(x + 4, y + 14, x + 5, y + 16, line_color);
-    draw_rect(x + 6, y + 15, x + 6, y + 17, line_color);
-    draw_rect(x + 7, y + 16, x + 10, y + 17, line_color);  
-    draw_rect(x + 10, y + 15, x + 11, y + 17, line_color);
-    draw_rect(x + 12, y + 14, x + 13, y + 16, line_color);
-    draw_rect(x + 14, y + 13, x + 15, y + 14, line_color);
-    draw_rect(x + 14, y + 8, x + 16, y + 12, line_color);
-    draw_rect(x + 9, y + 8, x + 14, y + 10, line_color);
-    //draw A
-    draw_rect(x + 26, y, x + 30, y + 1, line_color); 
-    draw_rect(x + 25, y + 2, x + 27, y + 4, line_color);
-    draw_rect(x + 24, y + 5, x + 26, y + 7, line_color);
-    draw_rect(x + 23, y + 8, x + 25, y + 10, line_color);
-    draw_rect(x + 22, y + 11, x + 24, y + 13, line_color);
-    draw_rect(x + 21, y + 14, x + 23, y + 16, line_color);  
-    draw_rect(x + 20, y + 17, x + 22, y + 17, line_color);
-    draw_rect(x + 29, y + 2, x + 31, y + 4, line_color);
-    draw_rect(x + 30, y + 5, x + 32, y + 7, line_color);
-    draw_rect(x + 31, y + 8, x + 33, y + 10, line_color);
-    draw_rect(x + 32, y + 11, x + 34, y + 13, line_color);
-    draw_rect(x + 33, y + 14, x + 35, y + 16, line_color);
-    draw_rect(x + 34, y + 17, x + 36, y + 17, line_color);
-    draw_rect(x + 25, y + 9, x + 31, y + 11, line_color);
-    //draw M
-    draw_rect(x + 40, y, x + 42, y + 17, line_color); 
-    draw_rect(x + 43, y, x + 43, y + 2, line_color);
-    draw_rect(x + 44, y + 1, x + 45, y + 9, line_color);
-    draw_rect(x + 45, y + 10, x + 46, y + 15, line_color);
-    draw_rect(x + 47, y + 15, x + 48, y + 17, line_color);
-    draw_rect(x + 53, y, x + 55, y + 17, line_color); 
-    draw_rect(x + 52, y, x + 52, y + 2, line_color);
-    draw_rect(x + 50, y + 1, x + 51, y + 9, line_color);
-    draw_rect(x + 49, y + 10, x + 50, y + 15, line_color);
-    //draw E
-    draw_rect(x + 60, y, x + 62, y + 17, line_color);
-    draw_rect(x + 62, y, x + 73, y + 2, line_color);
-    draw_rect(x + 62, y + 7, x + 71, y + 9, line_color);
-    draw_rect(x + 62, y + 15, x + 73, y + 17, line_color);
-
-    //starting point of O
-    int over_x = x + 94;
-
-    //draw O
-    draw_rect(over_x + 1, y + 6, over_x + 3, y + 11, line_color);
-    draw_rect(over_x + 2, y + 3, over_x + 4, y + 5, line_color);
-    draw_rect(over_x + 4, y + 1, over_x + 5, y + 3, line_color);
-    draw_rect(over_x + 6, y, over_x + 6, y + 2, line_color);
-    draw_rect(over_x + 7, y, over_x + 10, y + 1, line_color);  
-    draw_rect(over_x + 11, y, over_x + 11, y + 2, line_color);
-    draw_rect(over_x + 12, y + 1, over_x + 13, y + 3, line_color);
-    draw_rect(over_x + 13, y + 3, over_x + 15, y + 5, line_color);
-    draw_rect(over_x + 2, y + 12, over_x + 4, y + 14, line_color);
-    draw_rect(over_x + 4, y + 14, over_x + 5, y + 16, line_color);
-    draw_rect(over_x + 6, y + 15, over_x + 6, y + 17, line_color);
-    draw_rect(over_x + 7, y + 16, over_x + 10, y + 17, line_color);  
-    draw_rect(over_x + 11, y + 15, over_x + 11, y + 17, line_color);
-    draw_rect(over_x + 12, y + 14, over_x + 13, y + 16, line_color);
-    draw_rect(over_x + 13, y + 12, over_x + 15, y + 14, line_color);
-	draw_rect(over_x + 14, y + 6, over_x + 16, y + 11, line_color);
-    //draw V
-    draw_rect(over_x + 20, y, over_x + 22, y + 1, line_color);
-	draw_rect(over_x + 21, y + 1, over_x + 23, y + 2, line_color);
-	draw_rect(over_x + 22, y + 3, over_x + 24, y + 6, line_color);
-	draw_rect(over_x + 23, y + 7, over_x + 25, y + 8, line_color);
-    draw_rect(over_x + 24, y + 9, over_x + 26, y + 12, line_color);
-    draw_rect(over_x + 25, y + 13, over_x + 27, y + 14, line_color);
-    draw_rect(over_x + 26, y + 15, over_x + 29, y + 17, line_color);
-	draw_rect(over_x + 33, y, over_x + 35, y + 1, line_color);
-	draw_rect(over_x + 32, y + 1, over_x + 34, y + 2, line_color);
-	draw_rect(over_x + 31, y + 3, over_x + 33, y + 6, line_color);
-	draw_rect(over_x + 30, y + 7, over_x + 32, y + 8, line_color);
-    draw_rect(over_x + 29, y + 9, over_x + 31, y + 12, line_color);
-    draw_rect(over_x + 28, y + 13, over_x + 30, y + 14, line_color);
-    //draw E
-    draw_rect(over_x + 40, y, over_x + 42, y + 17, line_color);
-    draw_rect(over_x + 42, y, over_x + 53, y + 2, line_color);
-    draw_rect(over_x + 42, y + 7, over_x + 50, y + 9, line_color);
-    draw_rect(over_x + 42, y + 15, over_x + 53, y + 17, line_color);
-    //draw R
-    draw_rect(over_x + 59, y, over_x + 61, y + 17, line_color); 
-    draw_rect(over_x + 62, y, over_x + 67, y + 1, line_color);
-    draw_rect(over_x + 68, y + 1, over_x + 70, y + 1, line_color);
-    draw_rect(over_x + 68, y + 2, over_x + 71, y + 2, line_color);
-    draw_rect(over_x + 70, y + 3, over_x + 72, y + 3, line_color);
-    draw_rect(over_x + 70, y + 4, over_x + 72, y + 5, line_color);
-    draw_rect(over_x + 70, y + 6, over_x + 72, y + 6, line_color);
-    draw_rect(over_x + 68, y + 7, over_x + 71, y + 7, line_color);
-    draw_rect(over_x + 68, y + 8, over_x + 70, y + 8, line_color);
-    draw_rect(over_x + 62, y + 8, over_x + 67, y + 9, line_color);
-    draw_rect(over_x + 65, y + 9, over_x + 67, y + 10, line_color);
-	draw_rect(over_x + 66, y + 10, over_x + 68, y + 10, line_color);
-    draw_rect(over_x + 67, y + 11, over_x + 69, y + 11, line_color);
-    draw_rect(over_x + 68, y + 12, over_x + 70, y + 13, line_color);
-    draw_rect(over_x + 69, y + 14, over_x + 71, y + 14, line_color);
-    draw_rect(over_x + 70, y + 15, over_x + 72, y + 16, line_color);
-    draw_rect(over_x + 71, y + 17, over_x + 73, y + 17, line_color);
+    ps2_write(0xF4); //enable keyboard input
+
+    // Whatever arrived before is gone now
+    input_latency.arrival_valid = false;
+}
+
+/**
+ * Empties the PS/2 FIFO without sending the keyboard anything, so it
+ * can be called every frame
+*/
+void discard_keys(){
+    while (ps2_read() & 0x8000);
+
+    input_latency.arrival_valid = false;
 }
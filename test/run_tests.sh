@@ -0,0 +1,23 @@
+#!/bin/sh
+# Builds and runs every host test. Tests include main.c directly.
+cd "$(dirname "$0")/.." || exit 1
+mkdir -p test/bin
+
+status=0
+for source in test/test_*.c; do
+    name=$(basename "$source" .c)
+    echo "== $name"
+    if ! gcc -std=gnu11 -O2 -Wall -o "test/bin/$name" "$source" -lm -lpthread; then
+        status=1
+        continue
+    fi
+    (cd test/bin && "./$name") || status=1
+done
+
+# The browser demo is checked headless when Node is around
+if command -v node >/dev/null 2>&1; then
+    echo "== demo"
+    node demo/test.js || status=1
+fi
+
+exit $status
@@ -0,0 +1,220 @@
+/*
+ * Host test for the audio mixer. Plays a scripted run of flaps, scores
+ * and a hit through update_audio into the host codec, which writes
+ * what it plays to sounds.wav. The same script mixed with a plain
+ * scalar loop has to give the same file byte for byte. Then the script
+ * runs again with the FIFO topped up only once a frame, which has to
+ * be counted as underruns and heard as gaps.
+ *
+ * Last, frames longer than the FIFO lasts are run through next_frame
+ * against a codec that plays as CPU time passes. Their simulation and their
+ * resolve together take longer than the FIFO's 2.7 ms, and it must never run
+ * dry in between.
+ *
+ *   gcc -std=gnu11 -O2 -o test_audio test/test_audio.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define FRAMES 120
+#define FRAME_SAMPLES (AUDIO_SAMPLE_RATE / 60)
+// update_audio runs this often per frame while waiting for vsync
+#define TOP_UPS_PER_FRAME 10
+// Long frames spend this long simulating, then resolve this many full
+// screen blends
+#define LONG_FRAMES 10
+#define LONG_SIMULATION_US 1000
+#define LONG_FRAME_BLENDS 48
+#define FIFO_US (AUDIO_FIFO_DEPTH * 1000000 / AUDIO_SAMPLE_RATE)
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    failures++;
+    printf("FAIL %s\n", what);
+}
+
+// What the game plays on each frame of the script
+void play_script(int frame) {
+    if (frame == 0 || frame == 20 || frame == 40 || frame == 41) play_sound(&flap_clip, AUDIO_FULL_GAIN);
+    if (frame == 30 || frame == 70) play_sound(&score_clip, AUDIO_FULL_GAIN);
+    if (frame == 45) play_sound(&flap_clip, AUDIO_FULL_GAIN / 2);
+    if (frame == 90) play_sound(&hit_clip, AUDIO_FULL_GAIN);
+}
+
+// mix_audio_block without the vector kernels
+void scalar_mix_block(short *out, int count) {
+    memset(out, 0, count * sizeof(short));
+
+    for (int v = 0; v < NUM_AUDIO_VOICES; v++) {
+        audio_voice_t *voice = &audio_mixer.voices[v];
+
+        if (voice->clip == NULL) continue;
+
+        const short *in = voice->clip->samples + voice->position;
+        int n = clamp(voice->clip->length - voice->position, 0, count);
+
+        for (int i = 0; i < n; i++) {
+            out[i] = clamp(out[i] + ((in[i] * voice->gain) >> 15), -32768, 32767);
+        }
+
+        voice->position += n;
+        if (voice->position >= voice->clip->length) voice->clip = NULL;
+    }
+}
+
+// update_audio with scalar_mix_block
+void scalar_update_audio() {
+    short block[AUDIO_BLOCK_SAMPLES];
+    int space = audio_fifo_space();
+    bool active = false;
+
+    for (int v = 0; v < NUM_AUDIO_VOICES; v++) {
+        if (audio_mixer.voices[v].clip != NULL) active = true;
+    }
+
+    for (; active && space >= AUDIO_BLOCK_SAMPLES; space -= AUDIO_BLOCK_SAMPLES) {
+        scalar_mix_block(block, AUDIO_BLOCK_SAMPLES);
+        audio_fifo_write(block, AUDIO_BLOCK_SAMPLES);
+    }
+}
+
+// Runs the script into a WAV file, topping up the FIFO top_ups times a frame
+void render(const char *path, int top_ups, bool scalar) {
+    memset(&audio_mixer, 0, sizeof(audio_mixer));
+    check(audio_wav_open(path), "open WAV file");
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        play_script(frame);
+
+        for (int i = 0; i < top_ups; i++) {
+            if (scalar) scalar_update_audio();
+            else update_audio();
+
+            audio_host_play(FRAME_SAMPLES / top_ups);
+        }
+    }
+
+    audio_wav_close();
+}
+
+// Reads a WAV file written by the host codec and checks its header
+int read_wav(const char *path, short *samples, int max_samples) {
+    unsigned char header[44];
+    unsigned char expected[44];
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL || fread(header, sizeof(header), 1, file) != 1) {
+        check(false, "read WAV header");
+        if (file) fclose(file);
+        return 0;
+    }
+
+    int count = fread(samples, sizeof(short), max_samples, file);
+    fclose(file);
+
+    audio_wav_header(expected, count);
+    check(memcmp(header, expected, sizeof(header)) == 0, "WAV header");
+    check(memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVEfmt ", 8) == 0, "RIFF tags");
+    return count;
+}
+
+/**
+ * Runs frames that take longer than the FIFO lasts through next_frame,
+ * with the codec playing by CPU time and a sound always playing
+ * @return the longest frame's work in us, up to the swap
+*/
+unsigned int run_long_frames() {
+    game_state_t game;
+    unsigned int longest = 0;
+
+    initialize_game(&game);
+    initialize_screen(&game);
+    screen_surface.list = &display_list;
+
+    memset(&audio_mixer, 0, sizeof(audio_mixer));
+    host_audio.fifo_count = 0;
+    play_sound(&hit_clip, AUDIO_FULL_GAIN);
+    update_audio();
+    audio_host_start_clock();
+    host_audio.samples_dry = 0;
+
+    for (int frame = 0; frame < LONG_FRAMES; frame++) {
+        unsigned int start = read_timer();
+
+        // The simulation, busy the whole time
+        while (read_timer() - start < LONG_SIMULATION_US * TIMER_TICKS_PER_US);
+
+        for (int i = 0; i < LONG_FRAME_BLENDS; i++) {
+            blend_rect(&screen_surface, 0, 0, RESOLUTION_X - 1, RESOLUTION_Y - 1, (color_t)(i * 977), 1 + i % 30);
+        }
+
+        // Restarted every frame so there is always something to play
+        play_sound(&hit_clip, AUDIO_FULL_GAIN);
+
+        unsigned long long work_ticks = frame_governor.work_ticks;
+        next_frame();
+
+        // The governor only counts from the second frame on
+        unsigned int work = (frame_governor.work_ticks - work_ticks) / TIMER_TICKS_PER_US;
+        if (work > longest) longest = work;
+    }
+
+    host_audio.clocked = false;
+    return longest;
+}
+
+short mixed[FRAMES * FRAME_SAMPLES];
+short reference[FRAMES * FRAME_SAMPLES];
+short starved[FRAMES * FRAME_SAMPLES];
+
+int main(void) {
+    initialize_audio();
+
+    render("sounds.wav", TOP_UPS_PER_FRAME, false);
+    int count = read_wav("sounds.wav", mixed, FRAMES * FRAME_SAMPLES);
+    unsigned int underruns = audio_mixer.underruns;
+
+    render("sounds_scalar.wav", TOP_UPS_PER_FRAME, true);
+    int reference_count = read_wav("sounds_scalar.wav", reference, FRAMES * FRAME_SAMPLES);
+
+    check(count == FRAMES * FRAME_SAMPLES, "WAV length");
+    check(count == reference_count && memcmp(mixed, reference, count * sizeof(short)) == 0,
+        "mixer differs from the scalar mix");
+    check(underruns == 0, "underruns with the FIFO kept topped up");
+
+    // The first flap and the hit are heard
+    int loud = 0;
+    for (int i = 0; i < count; i++) loud += mixed[i] != 0;
+    check(mixed[AUDIO_BLOCK_SAMPLES] != 0, "flap at the start");
+    check(mixed[90 * FRAME_SAMPLES + HIT_CLIP_SAMPLES / 2] != 0, "hit");
+
+    // Topped up once a frame, the codec runs dry for most of each frame
+    render("sounds_starved.wav", 1, false);
+    int starved_count = read_wav("sounds_starved.wav", starved, FRAMES * FRAME_SAMPLES);
+    int longest_gap = 0;
+
+    for (int i = 90 * FRAME_SAMPLES, gap = 0; i < starved_count; i++) {
+        gap = starved[i] ? 0 : gap + 1;
+        if (gap > longest_gap && i < 90 * FRAME_SAMPLES + HIT_CLIP_SAMPLES) longest_gap = gap;
+    }
+
+    check(audio_mixer.underruns > 0, "underruns counted when starved");
+    check(longest_gap >= FRAME_SAMPLES - AUDIO_FIFO_DEPTH, "gaps heard when starved");
+    unsigned int starved_underruns = audio_mixer.underruns;
+
+    // Long frames are topped up often enough within the frame
+    unsigned int long_frame_us = run_long_frames();
+
+    check(long_frame_us > FIFO_US, "long frames shorter than the FIFO lasts");
+    check(host_audio.samples_dry == 0, "FIFO ran dry in a long frame");
+
+    printf("%d samples, %d not silent, %u underruns topped up %d times a frame, %u once a frame\n",
+        count, loud, underruns, TOP_UPS_PER_FRAME, starved_underruns);
+    printf("frames of %u us against a %d us FIFO: %u samples played dry\n",
+        long_frame_us, FIFO_US, host_audio.samples_dry);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Host test for the lookahead autopilot. At states taken from bot
+ * games, autopilot_can_survive has to agree with trying every
+ * sequence of jumps at the decision frames one by one, and leave the
+ * game it searched from untouched. Then the autopilot flies games of
+ * its own, and has to get further than the sweep bot does in total.
+ * A 30 frame lookahead still runs into voids it can't reach in time,
+ * so single games can end early.
+ *
+ *   gcc -std=gnu11 -O2 -o test_autopilot test/test_autopilot.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define GAMES 20
+#define MAX_FRAMES 2000
+#define CHECK_EVERY 9
+
+int failures = 0;
+
+void check(bool ok, const char *what, int game, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s in game %d at frame %d\n", what, game, frame);
+}
+
+// autopilot_can_survive by trying every sequence of decisions
+bool survives_any_sequence(const game_state_t *game, int frames) {
+    int decisions = (frames + AUTOPILOT_DECISION_FRAMES - 1) / AUTOPILOT_DECISION_FRAMES;
+
+    for (int jumps = 0; jumps < 1 << decisions; jumps++) {
+        game_state_t branch = *game;
+        int frame = 0;
+
+        for (; frame < frames; frame++) {
+            bool decide = frame % AUTOPILOT_DECISION_FRAMES == 0;
+
+            do_game_step(&branch, decide && (jumps >> (frame / AUTOPILOT_DECISION_FRAMES) & 1));
+            if (is_game_over(&branch)) break;
+        }
+
+        if (frame == frames) return true;
+    }
+
+    return false;
+}
+
+// Frames until a game flown by the autopilot or the sweep bot ends
+int fly(unsigned int seed, bool autopilot) {
+    game_state_t game;
+    unsigned int noise_seed = seed;
+    int frame = 0;
+
+    env_reset(&game, seed);
+
+    while (frame < MAX_FRAMES && !is_game_over(&game)) {
+        bool jump = autopilot ? autopilot_should_jump(&game) : sweep_bot_should_jump(&game, &noise_seed);
+
+        do_game_step(&game, jump);
+        frame++;
+    }
+
+    return frame;
+}
+
+int main(void) {
+    int searches = 0;
+    int doomed = 0;
+    long autopilot_frames = 0;
+    long bot_frames = 0;
+
+    for (int i = 0; i < GAMES; i++) {
+        game_state_t game;
+        unsigned int noise_seed = i;
+
+        env_reset(&game, i);
+
+        for (int frame = 0; frame < MAX_FRAMES && !is_game_over(&game); frame++) {
+            if (frame % CHECK_EVERY == 0) {
+                game_state_t before = game;
+                bool can = autopilot_can_survive(&game, AUTOPILOT_DEPTH - 1);
+
+                check(can == survives_any_sequence(&game, AUTOPILOT_DEPTH - 1), "search against every sequence", i, frame);
+                check(memcmp(&before, &game, sizeof(game)) == 0, "search leaves the game alone", i, frame);
+                searches++;
+                if (!can) doomed++;
+            }
+
+            do_game_step(&game, sweep_bot_should_jump(&game, &noise_seed));
+        }
+    }
+
+    for (int i = 0; i < GAMES; i++) {
+        autopilot_frames += fly(i, true);
+        bot_frames += fly(i, false);
+    }
+
+    check(autopilot_frames > bot_frames, "autopilot outlasts the sweep bot", GAMES, MAX_FRAMES);
+
+    printf("%d searches, %d with no way out\n", searches, doomed);
+    printf("autopilot %ld frames, sweep bot %ld frames over %d games\n", autopilot_frames, bot_frames, GAMES);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Host test for the blend kernels. blend_span_constant and blend_span
+ * run the SSE2 kernel on x86 hosts (NEON on the board) for whole groups
+ * of 8 pixels and blend_pixel for the tail; both have to give exactly
+ * what blend_pixel gives for every pixel, for every alpha, for random
+ * colors, for every count up to a few groups and for every alignment,
+ * without touching the pixels around the span. Faded text at full
+ * alpha has to come out exactly like draw_text.
+ *
+ *   gcc -std=gnu11 -O2 -o test_blend test/test_blend.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define MAX_COUNT 67
+#define GUARD 8
+#define ROUNDS 20
+
+color_t pixels[GUARD + 8 + MAX_COUNT + GUARD];
+color_t expected[GUARD + 8 + MAX_COUNT + GUARD];
+color_t sources[8 + MAX_COUNT];
+unsigned char alphas[8 + MAX_COUNT];
+color_t faded_pixels[RESOLUTION_Y][RESOLUTION_X];
+color_t text_pixels[RESOLUTION_Y][RESOLUTION_X];
+
+unsigned int seed = 1;
+
+color_t random_color() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+int main(void) {
+    int failures = 0;
+    int spans = 0;
+    color_t edges[] = {0x0000, (color_t) 0xFFFF, (color_t) 0xF800, 0x07E0, 0x001F};
+
+    // Every channel extreme over every other, where rounding is tightest
+    for (int alpha = 0; alpha <= BLEND_OPAQUE; alpha++) {
+        for (int d = 0; d < 5; d++) {
+            for (int s = 0; s < 5; s++) {
+                color_t row[16];
+
+                for (int i = 0; i < 16; i++) row[i] = edges[d];
+                blend_span_constant(row, 16, edges[s], alpha);
+
+                for (int i = 0; i < 16; i++) {
+                    if (row[i] == blend_pixel(edges[d], edges[s], alpha)) continue;
+                    if (failures++ < 10) printf("FAIL %04hx over %04hx at alpha %d\n", edges[s], edges[d], alpha);
+                }
+            }
+        }
+    }
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int alpha = 0; alpha <= BLEND_OPAQUE; alpha++) {
+            for (int offset = 0; offset < 8; offset++) {
+                for (int count = 0; count <= MAX_COUNT; count++) {
+                    color_t color = random_color();
+                    color_t *span = pixels + GUARD + offset;
+
+                    for (int i = 0; i < (int) (sizeof(pixels) / sizeof(pixels[0])); i++) {
+                        pixels[i] = expected[i] = random_color();
+                    }
+
+                    for (int i = 0; i < count; i++) {
+                        expected[GUARD + offset + i] = blend_pixel(expected[GUARD + offset + i], color, alpha);
+                    }
+
+                    blend_span_constant(span, count, color, alpha);
+                    spans++;
+
+                    if (memcmp(pixels, expected, sizeof(pixels)) == 0) continue;
+                    if (failures++ < 10) printf("FAIL alpha %d, offset %d, count %d\n", alpha, offset, count);
+                }
+            }
+        }
+    }
+
+    // A different alpha for every pixel, sources at every alignment too
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int offset = 0; offset < 8; offset++) {
+            for (int count = 0; count <= MAX_COUNT; count++) {
+                color_t *span = pixels + GUARD + offset;
+                color_t *src = sources + (offset + round) % 8;
+                unsigned char *alpha = alphas + (offset + 3 * round) % 8;
+
+                for (int i = 0; i < (int) (sizeof(pixels) / sizeof(pixels[0])); i++) {
+                    pixels[i] = expected[i] = random_color();
+                }
+
+                for (int i = 0; i < count; i++) {
+                    src[i] = random_color();
+                    alpha[i] = random_color() % (BLEND_OPAQUE + 1);
+                    expected[GUARD + offset + i] = blend_pixel(expected[GUARD + offset + i], src[i], alpha[i]);
+                }
+
+                blend_span(span, src, alpha, count);
+                spans++;
+
+                if (memcmp(pixels, expected, sizeof(pixels)) == 0) continue;
+                if (failures++ < 10) printf("FAIL per pixel alpha, offset %d, count %d\n", offset, count);
+            }
+        }
+    }
+
+    // Text over a busy background, at scale 1 where outlines of
+    // neighbouring glyphs share a column
+    for (int scale = 1; scale <= FONT_MAX_SCALE; scale++) {
+        surface_t faded;
+        surface_t text;
+
+        initialize_surface(&faded, (char *) faded_pixels, RESOLUTION_X, RESOLUTION_Y, RESOLUTION_X * sizeof(color_t));
+        initialize_surface(&text, (char *) text_pixels, RESOLUTION_X, RESOLUTION_Y, RESOLUTION_X * sizeof(color_t));
+        initialize_font();
+
+        for (int y = 0; y < RESOLUTION_Y; y++) {
+            for (int x = 0; x < RESOLUTION_X; x++) faded_pixels[y][x] = text_pixels[y][x] = random_color();
+        }
+
+        draw_text_faded(&faded, "GAME OVER 0123", -7, 3, scale, WHITE, BLACK, BLEND_OPAQUE);
+        draw_text(&text, "GAME OVER 0123", -7, 3, scale, WHITE, BLACK);
+
+        if (memcmp(faded_pixels, text_pixels, sizeof(faded_pixels)) != 0) {
+            if (failures++ < 10) printf("FAIL opaque faded text at scale %d\n", scale);
+        }
+    }
+
+#if defined(__ARM_NEON)
+    printf("checked NEON against blend_pixel on %d spans\n", spans);
+#elif defined(__SSE2__)
+    printf("checked SSE2 against blend_pixel on %d spans\n", spans);
+#else
+    printf("no vector kernel on this host, checked %d scalar spans\n", spans);
+#endif
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Host test for swept collision and fast-forwarding. Bot games at
+ * scroll speeds from 2 to 40 are stepped with do_game_step, and every
+ * frame is checked against a reference that tests each pose one pixel
+ * of motion apart with collide_entities. Then runs of frames without
+ * jumps from the same games are fast-forwarded and checked against as
+ * many do_game_step calls. Last, games played with and without the
+ * sweep are compared: the sweep can only end a game earlier.
+ *
+ *   gcc -std=gnu11 -O2 -o test_collision test/test_collision.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define MIN_SCROLL 2
+#define MAX_SCROLL 40
+#define GAMES_PER_SCROLL 20
+#define MAX_FRAMES 2000
+#define FAST_FORWARD_FRAMES 200
+#define OUTCOME_GAMES 1000
+
+int failures = 0;
+
+void check(bool ok, const char *what, int scroll, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at scroll %d, frame %d\n", what, scroll, frame);
+}
+
+// Everything a frame of the game depends on
+bool same_game(const game_state_t *a, const game_state_t *b) {
+    if (a->bird.y != b->bird.y || a->bird.y_velocity != b->bird.y_velocity) return false;
+    if (a->score != b->score || a->seed != b->seed || a->pipes.count != b->pipes.count) return false;
+
+    for (int i = 0; i < a->pipes.count; i++) {
+        if (a->pipes.x[i] != b->pipes.x[i] || a->pipes.y[i] != b->pipes.y[i]) return false;
+        if (a->pipes.flags[i] != b->pipes.flags[i]) return false;
+    }
+
+    return true;
+}
+
+// do_game_step with every pose one pixel of motion apart tested, the
+// way do_swept_collision tests them once the sweep reports contact
+void step_per_pixel(game_state_t *game, bool jump) {
+    int scroll = game->config.scroll_amount;
+
+    cull_pipes(game);
+
+    bird_t start = game->bird;
+    if (jump) do_bird_jump(&game->bird, &game->config);
+    do_bird_velocity(&game->bird, &game->config);
+
+    double dy = game->bird.y - start.y;
+    int steps = clamp((int)(dy < 0 ? -dy : dy) + 1, scroll, RESOLUTION_Y);
+
+    for (int k = 1; k < steps; k++) {
+        entity_store_t moved = game->pipes;
+        bird_t bird = game->bird;
+
+        bird.y = start.y + dy * k / steps;
+        scroll_entities(&moved, scroll * k / steps);
+
+        if (collide_entities(&moved, bird) >= 0) {
+            game->bird.y = bird.y;
+            scroll = scroll * k / steps;
+            break;
+        }
+    }
+
+    scroll_entities(&game->pipes, scroll);
+    do_update_score(game);
+}
+
+// do_game_step with only the end of the frame tested
+void step_end_only(game_state_t *game, bool jump) {
+    cull_pipes(game);
+    if (jump) do_bird_jump(&game->bird, &game->config);
+    do_bird_velocity(&game->bird, &game->config);
+    scroll_entities(&game->pipes, game->config.scroll_amount);
+    do_update_score(game);
+}
+
+// Frames until the sweep bot dies, up to MAX_FRAMES
+int play_bot(unsigned int seed, void (*step)(game_state_t *, bool)) {
+    game_state_t game;
+    unsigned int noise_seed = seed;
+    int frame = 0;
+
+    env_reset_config(&game, seed, &default_game_config);
+
+    while (frame < MAX_FRAMES && !is_game_over(&game)) {
+        step(&game, sweep_bot_should_jump(&game, &noise_seed));
+        frame++;
+    }
+
+    return frame;
+}
+
+int main(void) {
+    game_config_t config = default_game_config;
+    unsigned int random_seed = 5;
+    int stops = 0;
+    int frames = 0;
+    int fast_forwards = 0;
+
+    for (int scroll = MIN_SCROLL; scroll <= MAX_SCROLL; scroll++) {
+        config.scroll_amount = scroll;
+
+        for (int i = 0; i < GAMES_PER_SCROLL; i++) {
+            game_state_t game;
+            unsigned int noise_seed = i;
+
+            env_reset_config(&game, scroll * GAMES_PER_SCROLL + i, &config);
+
+            for (int frame = 0; frame < MAX_FRAMES && !is_game_over(&game); frame++, frames++) {
+                bool jump = sweep_bot_should_jump(&game, &noise_seed);
+                game_state_t swept = game;
+                game_state_t stepped = game;
+
+                do_game_step(&swept, jump);
+                step_per_pixel(&stepped, jump);
+                check(same_game(&swept, &stepped), "sweep against per-pixel steps", scroll, frame);
+
+                // From here the bot holds off for a while
+                if (!jump && frame % 7 == 0) {
+                    game_state_t forwarded = game;
+                    game_state_t single = game;
+                    int want;
+                    int done = 0;
+
+                    random_seed = random_seed * 1103515245 + 12345;
+                    want = 1 + (random_seed >> 8) % FAST_FORWARD_FRAMES;
+
+                    while (done < want && !is_game_over(&single)) {
+                        do_game_step(&single, false);
+                        done++;
+                    }
+
+                    check(do_game_fast_forward(&forwarded, want) == done, "fast-forwarded frames", scroll, frame);
+                    check(same_game(&forwarded, &single), "fast-forward against steps", scroll, frame);
+                    fast_forwards++;
+                }
+
+                game_state_t end = game;
+                step_end_only(&end, jump);
+                if (end.bird.y != swept.bird.y) stops++;
+
+                game = swept;
+            }
+        }
+    }
+
+    // With the default rules, some games end earlier on a pipe corner
+    // the end of the frame slipped past, and none end later
+    int earlier = 0;
+    for (unsigned int seed = 0; seed < OUTCOME_GAMES; seed++) {
+        int swept = play_bot(seed, do_game_step);
+        int end_only = play_bot(seed, step_end_only);
+
+        check(swept <= end_only, "sweep ends the game no later", default_game_config.scroll_amount, swept);
+        if (swept < end_only) earlier++;
+    }
+
+    printf("%d frames at scroll %d to %d, %d stopped by the sweep, %d fast-forwards\n", frames, MIN_SCROLL,
+        MAX_SCROLL, stops, fast_forwards);
+    printf("%d of %d games end earlier with the sweep\n", earlier, OUTCOME_GAMES);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Host test for pixel-exact collision. For every wing frame and tilt
+ * of the bird, the bird and a pipe are drawn with draw_bird and
+ * draw_pipe, and did_collide has to report a hit exactly when a pixel
+ * of the bird lands on a pixel of the pipe, with the pipe slid past
+ * the bird column by column and its void moved up and down row by
+ * row. Reports how many of the hits the old collision box would have
+ * called differently.
+ *
+ *   gcc -std=gnu11 -O2 -o test_collision_mask test/test_collision_mask.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define BIRD_Y 100
+#define PIPE_X 160
+#define SLIDE 64
+#define MAX_BIRD_PIXELS (BIRD_CANVAS_SIZE * BIRD_CANVAS_SIZE)
+
+short int canvas[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+bool pipe_pixels[RESOLUTION_Y][RESOLUTION_X];
+int bird_dx[MAX_BIRD_PIXELS];
+int bird_dy[MAX_BIRD_PIXELS];
+int bird_pixel_count;
+
+surface_t surface;
+entity_store_t store;
+int failures = 0;
+
+void check(bool ok, const char *what, int x, int y) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s with the bird at %d and the void at %d\n", what, x, y);
+}
+
+// Marks where drawing writes, by drawing over two different fills
+void draw_marks(bool marks[RESOLUTION_Y][RESOLUTION_X], void (*draw)()) {
+    memset(marks, 0, sizeof(bool) * RESOLUTION_Y * RESOLUTION_X);
+
+    for (int fill = 0; fill < 2; fill++) {
+        color_t background = fill ? 0x5A5A : 0x0101;
+
+        for (int y = 0; y < RESOLUTION_Y; y++) {
+            for (int x = 0; x < RESOLUTION_X; x++) canvas[y][x] = background;
+        }
+
+        draw();
+
+        for (int y = 0; y < RESOLUTION_Y; y++) {
+            for (int x = 0; x < RESOLUTION_X; x++) {
+                if (canvas[y][x] != background) marks[y][x] = true;
+            }
+        }
+    }
+}
+
+bird_t bird;
+bool bird_marks[RESOLUTION_Y][RESOLUTION_X];
+
+void draw_test_bird() {
+    draw_bird(&surface, bird);
+}
+
+void draw_test_pipe() {
+    draw_pipe(&surface, &store, 0);
+}
+
+// Whether the box check COLLISION_BOX uses would call it a hit
+bool box_collides(bird_t b) {
+    int x1 = store.x[0] - store.width[0] / 2;
+    int x2 = store.x[0] + store.width[0] / 2;
+    int y1 = store.y[0] - store.height[0] / 2;
+    int y2 = store.y[0] + store.height[0] / 2;
+
+    if (b.x + BIRD_WIDTH - 1 < x1 || b.x > x2) return false;
+    return !(b.y >= y1 && b.y + BIRD_HEIGHT - 1 <= y2);
+}
+
+int main(void) {
+    game_state_t game;
+    int hits = 0, poses = 0, box_differs = 0;
+
+    memset(&game, 0, sizeof(game));
+    env_reset(&game, 1);
+    initialize_pipe_sprites();
+    initialize_surface(&surface, (char *) canvas, RESOLUTION_X, RESOLUTION_Y, sizeof(canvas[0]));
+
+    store = game.pipes;
+    store.count = 1;
+    store.x[0] = PIPE_X;
+
+    for (int frame = 0; frame < NUM_WING_FRAMES; frame++) {
+        for (int angle = 0; angle < NUM_BIRD_ANGLES; angle++) {
+            // Pick a velocity that tilts the bird to this angle
+            bird.x = PIPE_X;
+            bird.y = BIRD_Y + 0.75;
+            bird.wing_tick = frame * WING_FRAME_TICKS;
+            bird.y_velocity = 12;
+            while (bird_angle_index(bird) < angle) bird.y_velocity -= 0.25;
+
+            draw_marks(bird_marks, draw_test_bird);
+            bird_pixel_count = 0;
+            for (int y = 0; y < RESOLUTION_Y; y++) {
+                for (int x = 0; x < RESOLUTION_X; x++) {
+                    if (!bird_marks[y][x]) continue;
+                    bird_dx[bird_pixel_count] = x - PIPE_X;
+                    bird_dy[bird_pixel_count++] = y - BIRD_Y;
+                }
+            }
+
+            for (int void_y = BIRD_Y - 70; void_y <= BIRD_Y + 100; void_y++) {
+                store.y[0] = void_y;
+                draw_marks(pipe_pixels, draw_test_pipe);
+
+                for (int x = PIPE_X - SLIDE; x <= PIPE_X + SLIDE; x++) {
+                    bool drawn_hit = false;
+
+                    for (int i = 0; i < bird_pixel_count && !drawn_hit; i++) {
+                        drawn_hit = pipe_pixels[BIRD_Y + bird_dy[i]][x + bird_dx[i]];
+                    }
+
+                    bird.x = x;
+                    check(did_collide(bird, &store, 0) == drawn_hit, "collision against drawn pixels", x, void_y);
+                    poses++;
+                    if (drawn_hit) hits++;
+                    if (drawn_hit != box_collides(bird)) box_differs++;
+                }
+            }
+        }
+    }
+
+    printf("%d poses, %d hits, the collision box differs on %d\n", poses, hits, box_differs);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
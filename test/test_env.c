@@ -0,0 +1,201 @@
+/*
+ * Host test and benchmark for the environment API. Checks that
+ * env_step gives the reward, done flag, auto-reset and observation a
+ * plain do_game_step loop would, that episodes replay from their seed,
+ * and that env_pool_step matches env_step, then measures how steps per
+ * second scale with the pool's threads. Past the host's cores the
+ * threads only share them, so the figure says nothing about scaling.
+ *
+ *   gcc -std=gnu11 -O2 -o test_env test/test_env.c -lpthread
+ */
+#include <time.h>
+#include <unistd.h>
+
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define POOL_GAMES 4096
+#define CHECK_STEPS 3000
+#define BENCH_STEPS 2000
+
+game_state_t games[POOL_GAMES];
+game_state_t shadows[POOL_GAMES];
+game_state_t pool_games[POOL_GAMES];
+bool actions[POOL_GAMES];
+observation_t observations[POOL_GAMES];
+observation_t pool_observations[POOL_GAMES];
+int rewards[POOL_GAMES];
+int pool_rewards[POOL_GAMES];
+bool dones[POOL_GAMES];
+bool pool_dones[POOL_GAMES];
+
+int failures = 0;
+
+double now_s() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void check(bool ok, const char *what, int step, int game) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at step %d, game %d\n", what, step, game);
+}
+
+// Roughly what an untrained agent does: flap now and then
+void random_actions(bool out[], int count, unsigned int *seed) {
+    for (int i = 0; i < count; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        out[i] = ((*seed >> 16) & 15) == 0;
+    }
+}
+
+bool same_observation(const observation_t *a, const observation_t *b) {
+    return a->bird_y == b->bird_y && a->bird_y_velocity == b->bird_y_velocity
+        && a->pipe_dx == b->pipe_dx && a->pipe_dy == b->pipe_dy;
+}
+
+// env_step against the same frames stepped by hand
+void check_semantics() {
+    int count = 256;
+    unsigned int seed = 1;
+    int episodes = 0, points = 0;
+
+    for (int i = 0; i < count; i++) {
+        env_reset(&games[i], 1000 + i);
+        shadows[i] = games[i];
+    }
+
+    for (int step = 0; step < CHECK_STEPS; step++) {
+        random_actions(actions, count, &seed);
+        env_step(games, count, actions, observations, rewards, dones);
+
+        for (int i = 0; i < count; i++) {
+            game_state_t *shadow = &shadows[i];
+            observation_t expected;
+            int score = shadow->score;
+
+            do_game_step(shadow, actions[i]);
+            check(rewards[i] == shadow->score - score, "reward", step, i);
+            check(dones[i] == is_game_over(shadow), "done", step, i);
+
+            if (is_game_over(shadow)) {
+                // The next episode starts from where the generator got to
+                env_reset(shadow, shadow->seed);
+                check(games[i].score == 0 && games[i].bird.y == BIRD_INITIAL_Y, "auto-reset", step, i);
+                episodes++;
+            }
+
+            points += rewards[i];
+            env_observe(shadow, &expected);
+            check(same_observation(&observations[i], &expected), "observation", step, i);
+            check(memcmp(&games[i].pipes, &shadow->pipes, sizeof(shadow->pipes)) == 0, "pipes", step, i);
+        }
+    }
+
+    printf("%d steps of %d games: %d episodes ended, %d pipes passed\n", CHECK_STEPS, count, episodes, points);
+    check(episodes > 0 && points > 0, "episodes and rewards happen", CHECK_STEPS, -1);
+}
+
+// The same seed and actions give the same episode
+void check_reproducible() {
+    game_state_t a, b;
+    observation_t oa, ob;
+    int ra, rb;
+    bool da, db;
+    unsigned int seed_a = 9, seed_b = 9;
+
+    env_reset(&a, 42);
+    env_reset(&b, 42);
+
+    for (int step = 0; step < 5000; step++) {
+        bool ja, jb;
+
+        random_actions(&ja, 1, &seed_a);
+        random_actions(&jb, 1, &seed_b);
+        env_step(&a, 1, &ja, &oa, &ra, &da);
+        env_step(&b, 1, &jb, &ob, &rb, &db);
+        check(same_observation(&oa, &ob) && ra == rb && da == db, "reproducible", step, 0);
+    }
+}
+
+// Once every pipe is behind the bird, the observation is the fixed one
+void check_no_pipe() {
+    game_state_t game;
+    observation_t observation;
+
+    env_reset(&game, 7);
+    for (int i = 0; i < NUM_PIPES; i++) game.pipes.x[i] = game.bird.x - game.pipes.width[i];
+
+    env_observe(&game, &observation);
+    check(observation.bird_y == game.bird.y, "bird without pipes", 0, 0);
+    check(observation.pipe_dx == RESOLUTION_X && observation.pipe_dy == 0, "no pipe", 0, 0);
+}
+
+// env_pool_step against env_step on a copy of the same games
+void check_pool(int threads) {
+    env_pool_t pool;
+    unsigned int seed = 3;
+
+    for (int i = 0; i < POOL_GAMES; i++) {
+        env_reset(&games[i], i);
+        pool_games[i] = games[i];
+    }
+
+    env_pool_start(&pool, pool_games, POOL_GAMES, pool_observations, pool_rewards, pool_dones, threads);
+
+    for (int step = 0; step < 500; step++) {
+        random_actions(actions, POOL_GAMES, &seed);
+        env_step(games, POOL_GAMES, actions, observations, rewards, dones);
+        env_pool_step(&pool, actions);
+
+        for (int i = 0; i < POOL_GAMES; i++) {
+            check(same_observation(&observations[i], &pool_observations[i])
+                && rewards[i] == pool_rewards[i] && dones[i] == pool_dones[i], "pool matches env_step", step, i);
+        }
+    }
+
+    env_pool_stop(&pool);
+}
+
+double benchmark(int threads) {
+    env_pool_t pool;
+    unsigned int seed = 5;
+
+    for (int i = 0; i < POOL_GAMES; i++) env_reset(&pool_games[i], i);
+    random_actions(actions, POOL_GAMES, &seed);
+
+    env_pool_start(&pool, pool_games, POOL_GAMES, pool_observations, pool_rewards, pool_dones, threads);
+
+    double start = now_s();
+    for (int step = 0; step < BENCH_STEPS; step++) env_pool_step(&pool, actions);
+    double seconds = now_s() - start;
+
+    env_pool_stop(&pool);
+    return (double) POOL_GAMES * BENCH_STEPS / seconds;
+}
+
+int main(void) {
+    int cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    check_semantics();
+    check_reproducible();
+    check_no_pipe();
+    check_pool(1);
+    check_pool(4);
+
+    double single = benchmark(1);
+    printf("1 thread: %.1fM steps/s on %d cores\n", single / 1e6, cores);
+
+    for (int threads = 2; threads <= 2 * cores || threads <= 4; threads *= 2) {
+        double rate = benchmark(threads);
+
+        printf("%d threads: %.1fM steps/s, %.2fx of 1 thread%s\n", threads, rate / 1e6, rate / single,
+            threads > cores ? ", more threads than cores" : "");
+    }
+
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
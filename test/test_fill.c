@@ -0,0 +1,98 @@
+/*
+ * Host test for solid fills. fill_span has to write exactly count
+ * pixels for every start pixel within a few vector stores of an
+ * aligned address, odd and even, and every count from a few negative
+ * ones up past several vector stores, leaving the pixels around it
+ * alone. draw_rect has to match setting each pixel of the rectangle
+ * inside the clip rectangle, for random rectangles and clip rectangles
+ * that reach past the surface on every side.
+ *
+ *   gcc -std=gnu11 -O2 -o test_fill test/test_fill.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define MAX_START 24
+#define MAX_COUNT 80
+#define SPAN_PIXELS (MAX_START + MAX_COUNT + 16)
+#define GUARD 0x7E7E
+#define RECTS 20000
+#define SURFACE_W 61
+#define SURFACE_H 23
+
+color_t span[SPAN_PIXELS] __attribute__((aligned(16)));
+color_t pixels[SURFACE_H][SURFACE_W + 3];
+color_t expected[SURFACE_H][SURFACE_W + 3];
+
+int failures = 0;
+unsigned int random_seed = 3;
+
+void check(bool ok, const char *what, int a, int b) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at %d, %d\n", what, a, b);
+}
+
+int random_int(int range) {
+    random_seed = random_seed * 1103515245 + 12345;
+    return (random_seed >> 8) % range;
+}
+
+void check_spans() {
+    for (int start = 0; start < MAX_START; start++) {
+        for (int count = -2; count <= MAX_COUNT; count++) {
+            color_t color = random_int(0x10000);
+            bool ok = true;
+
+            if (color == GUARD) color++;
+            for (int i = 0; i < SPAN_PIXELS; i++) span[i] = GUARD;
+
+            fill_span(span + start, count, color);
+
+            for (int i = 0; i < SPAN_PIXELS; i++) {
+                bool inside = i >= start && i < start + count;
+                if (span[i] != (inside ? color : GUARD)) ok = false;
+            }
+
+            check(ok, "span start and count", start, count);
+        }
+    }
+}
+
+void check_rects() {
+    surface_t surface;
+
+    initialize_surface(&surface, (char *) pixels, SURFACE_W, SURFACE_H, sizeof(pixels[0]));
+
+    for (int n = 0; n < RECTS; n++) {
+        int x0 = random_int(SURFACE_W + 20) - 10, x1 = x0 + random_int(SURFACE_W);
+        int y0 = random_int(SURFACE_H + 10) - 5, y1 = y0 + random_int(SURFACE_H);
+        color_t color = random_int(0x10000);
+
+        set_clip_rect(&surface, random_int(SURFACE_W) - 5, random_int(SURFACE_H) - 5,
+            random_int(SURFACE_W + 10), random_int(SURFACE_H + 10));
+
+        for (int y = 0; y < SURFACE_H; y++) {
+            for (int x = 0; x < SURFACE_W + 3; x++) pixels[y][x] = expected[y][x] = random_int(0x10000);
+        }
+
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (x < surface.clip.x0 || x > surface.clip.x1 || y < surface.clip.y0 || y > surface.clip.y1) continue;
+                expected[y][x] = color;
+            }
+        }
+
+        draw_rect(&surface, x0, y0, x1, y1, color);
+        check(memcmp(pixels, expected, sizeof(pixels)) == 0, "rect against pixels", x0, y0);
+    }
+}
+
+int main(void) {
+    check_spans();
+    check_rects();
+
+    printf("spans from %d starts up to %d pixels, %d clipped rects\n", MAX_START, MAX_COUNT, RECTS);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Host test and benchmark for ghost birds. A crowd of bots plays
+ * through env_step and every frame all of them are drawn as ghosts
+ * over the course, immediately and through a display list. Both have
+ * to match a plain reference that blends every covered pixel once.
+ * Also draws ghosts on a surface taller than the game to check they
+ * are not cut off at RESOLUTION_Y. Reports the time per ghost pass.
+ *
+ *   gcc -std=gnu11 -O2 -o test_ghosts test/test_ghosts.c -lm -lpthread
+ */
+#include <time.h>
+
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define NUM_GHOSTS 256
+#define FRAMES 300
+#define TALL_HEIGHT (2 * RESOLUTION_Y)
+
+short int immediate_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int deferred_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int reference_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int tall_frame[TALL_HEIGHT][RESOLUTION_X];
+short int tall_reference[TALL_HEIGHT][RESOLUTION_X];
+bool covered[TALL_HEIGHT][RESOLUTION_X];
+
+game_state_t ghosts[NUM_GHOSTS];
+bool actions[NUM_GHOSTS];
+observation_t observations[NUM_GHOSTS];
+int rewards[NUM_GHOSTS];
+bool dones[NUM_GHOSTS];
+int ghost_y[NUM_GHOSTS];
+
+int failures = 0;
+
+double now_ns() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Blends every pixel under at least one ghost once, one ghost at a time
+void reference_ghosts(short int *frame, int stride, int height, int x, const int y[], int count) {
+    memset(covered, 0, sizeof(covered));
+
+    for (int i = 0; i < count; i++) {
+        for (int row = 0; row < BIRD_HEIGHT; row++) {
+            for (int bit = 0; bit < BIRD_MASK_BITS; bit++) {
+                int px = x + BIRD_MASK_LEFT + bit;
+                int py = y[i] + row;
+
+                if (!(bird_mask[row] >> bit & 1)) continue;
+                if (px < 0 || px >= RESOLUTION_X || py < 0 || py >= height) continue;
+
+                covered[py][px] = true;
+            }
+        }
+    }
+
+    for (int py = 0; py < height; py++) {
+        for (int px = 0; px < RESOLUTION_X; px++) {
+            short int *pixel = &frame[py * stride + px];
+
+            if (covered[py][px]) *pixel = blend_pixel(*pixel, WHITE, GHOST_ALPHA);
+        }
+    }
+}
+
+void check(bool ok, const char *what, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at frame %d\n", what, frame);
+}
+
+void draw_course(const surface_t *screen, game_state_t *game) {
+    redraw_background(screen, game);
+    draw_entities(screen, &game->pipes);
+}
+
+int main(void) {
+    surface_t immediate, deferred, tall;
+    game_state_t game;
+    unsigned int noise_seed = 1;
+    double immediate_ns = 0, deferred_ns = 0;
+
+    memset(&game, 0, sizeof(game));
+    env_reset(&game, 5);
+    initialize_sky();
+    initialize_bird_mask();
+    initialize_bird_frames();
+    initialize_font();
+    initialize_grass_strip();
+    initialize_pipe_sprites();
+
+    for (int i = 0; i < NUM_GHOSTS; i++) env_reset(&ghosts[i], 5);
+
+    initialize_surface(&immediate, (char *) immediate_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(immediate_frame[0]));
+    initialize_surface(&deferred, (char *) deferred_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(deferred_frame[0]));
+    initialize_surface(&tall, (char *) tall_frame, RESOLUTION_X, TALL_HEIGHT, sizeof(tall_frame[0]));
+    draw_background(&immediate, &game);
+    draw_background(&deferred, &game);
+    deferred.list = &display_list;
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        for (int i = 0; i < NUM_GHOSTS; i++) {
+            actions[i] = sweep_bot_should_jump(&ghosts[i], &noise_seed);
+            ghost_y[i] = (int) ghosts[i].bird.y;
+        }
+
+        // Ghosts first over the course, then the reference the slow way
+        draw_course(&immediate, &game);
+        double t0 = now_ns();
+        draw_ghost_birds(&immediate, game.bird.x, ghost_y, NUM_GHOSTS, WHITE, GHOST_ALPHA);
+        double t1 = now_ns();
+
+        draw_course(&deferred, &game);
+        resolve_display_list(&deferred);
+        double t2 = now_ns();
+        draw_ghost_birds(&deferred, game.bird.x, ghost_y, NUM_GHOSTS, WHITE, GHOST_ALPHA);
+        resolve_display_list(&deferred);
+        double t3 = now_ns();
+
+        immediate_ns += t1 - t0;
+        deferred_ns += t3 - t2;
+
+        draw_course(&immediate, &game);
+        memcpy(reference_frame, immediate_frame, sizeof(reference_frame));
+        reference_ghosts(&reference_frame[0][0], NATIVE_STRIDE_PIXELS, RESOLUTION_Y, game.bird.x, ghost_y, NUM_GHOSTS);
+        draw_ghost_birds(&immediate, game.bird.x, ghost_y, NUM_GHOSTS, WHITE, GHOST_ALPHA);
+
+        check(memcmp(immediate_frame, reference_frame, sizeof(reference_frame)) == 0, "immediate ghosts", frame);
+        check(memcmp(deferred_frame, reference_frame, sizeof(reference_frame)) == 0, "deferred ghosts", frame);
+
+        env_step(ghosts, NUM_GHOSTS, actions, observations, rewards, dones);
+        if (!is_game_over(&game)) do_game_step(&game, autopilot_should_jump(&game));
+        animation_tick++;
+    }
+
+    // Ghosts spread down a surface twice as tall as the game
+    for (int i = 0; i < NUM_GHOSTS; i++) ghost_y[i] = (i * 7) % (TALL_HEIGHT + BIRD_HEIGHT) - BIRD_HEIGHT / 2;
+
+    for (int i = 0; i < TALL_HEIGHT * RESOLUTION_X; i++) tall_frame[i / RESOLUTION_X][i % RESOLUTION_X] = i * 2654435761u >> 16;
+    memcpy(tall_reference, tall_frame, sizeof(tall_frame));
+
+    draw_ghost_birds(&tall, 100, ghost_y, NUM_GHOSTS, WHITE, GHOST_ALPHA);
+    reference_ghosts(&tall_reference[0][0], RESOLUTION_X, TALL_HEIGHT, 100, ghost_y, NUM_GHOSTS);
+    check(memcmp(tall_frame, tall_reference, sizeof(tall_frame)) == 0, "ghosts on a tall surface", FRAMES);
+
+    printf("%d ghosts: immediate %.1f us/frame, deferred %.1f us/frame\n",
+        NUM_GHOSTS, immediate_ns / FRAMES / 1000, deferred_ns / FRAMES / 1000);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
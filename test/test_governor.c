@@ -0,0 +1,84 @@
+/*
+ * Host test for the frame governor. Frames of random amounts of work
+ * are run against a simulated swap, and governor_idle has to sleep
+ * until the wake margin before the next swap is due, not return before
+ * it and not oversleep past the swap. Late frames and a waiting key
+ * must not sleep at all. Reports how the time was split.
+ *
+ *   gcc -std=gnu11 -O2 -o test_governor test/test_governor.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define FRAMES 30
+#define BUDGET_TICKS ((FRAME_PERIOD_US - GOVERNOR_WAKE_MARGIN_US) * TIMER_TICKS_PER_US)
+#define FRAME_TICKS (FRAME_PERIOD_US * TIMER_TICKS_PER_US)
+// A sleep that wakes this much past the swap counts as late
+#define LATE_TICKS (GOVERNOR_WAKE_MARGIN_US * TIMER_TICKS_PER_US)
+
+int failures = 0;
+
+void check(bool ok, const char *what, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at frame %d\n", what, frame);
+}
+
+// Spins until ticks have passed since start, like a frame being drawn
+void work_until(unsigned int start, unsigned int ticks) {
+    while (read_timer() - start < ticks);
+}
+
+int main(void) {
+    unsigned int seed = 3;
+    int late = 0;
+
+    // Nothing to sleep towards before the first swap
+    unsigned int before = read_timer();
+    governor_idle(before);
+    check(read_timer() - before < LATE_TICKS, "idle before the first swap", -1);
+
+    governor_record_swap(read_timer(), read_timer());
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        unsigned int swap = frame_governor.last_swap;
+
+        seed = seed * 1103515245 + 12345;
+        work_until(swap, (seed >> 8) % (BUDGET_TICKS * 3 / 4));
+
+        unsigned int work_end = read_timer();
+        governor_idle(work_end);
+        unsigned int wake = read_timer();
+
+        check(wake - swap >= BUDGET_TICKS, "woke before the budget", frame);
+        if (wake - swap >= FRAME_TICKS) late++;
+
+        // The swap the governor was sleeping towards
+        work_until(swap, FRAME_TICKS);
+        governor_record_swap(work_end, wake);
+    }
+
+    // Host sleeps can overshoot now and then, but not usually
+    check(late <= FRAMES / 4, "woke after the swap", FRAMES);
+
+    // A frame that is already late goes straight to the swap
+    unsigned int swap = read_timer();
+    frame_governor.last_swap = swap;
+    work_until(swap, FRAME_TICKS + LATE_TICKS);
+    unsigned int work_end = read_timer();
+    governor_idle(work_end);
+    check(read_timer() - work_end < LATE_TICKS, "late frame slept", FRAMES);
+
+    // So does a frame with a key waiting, to time its arrival exactly
+    frame_governor.last_swap = read_timer();
+    host_press_key(SPACE_KEY);
+    work_end = read_timer();
+    governor_idle(work_end);
+    check(read_timer() - work_end < LATE_TICKS, "slept with a key waiting", FRAMES);
+    discard_keys();
+
+    report_frame_governor();
+    printf("%d of %d sleeps woke after the swap\n", late, FRAMES);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Host test for the grass strip. At every scroll offset, draw_grasses
+ * has to give exactly the band that drawing each grass square and its
+ * outline does, with the squares carried on past the right edge until
+ * the band is covered. The old per-square loop stopped one square
+ * short at some offsets; the pixels where it differs are reported and
+ * have to lie at the bottom right of the band. Clipped and deferred
+ * draws have to match the same band.
+ *
+ *   gcc -std=gnu11 -O2 -o test_grass test/test_grass.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define UNWRITTEN 0x5A5A
+
+short int strip_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int square_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int old_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+
+int failures = 0;
+
+void check(bool ok, const char *what, int offset) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at offset %d\n", what, offset);
+}
+
+void fill_frame(short int frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS], color_t color) {
+    for (int y = 0; y < RESOLUTION_Y; y++) {
+        for (int x = 0; x < NATIVE_STRIDE_PIXELS; x++) frame[y][x] = color;
+    }
+}
+
+// Draws the grass square by square like draw_grasses used to, up to
+// squares starting at last_x
+void draw_squares(const surface_t *surface, int grass_offset, int last_x) {
+    int grass_top = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT;
+    int grass_bottom = RESOLUTION_Y - GROUND_THICKNESS;
+    int first_x = -GRASS_SQUARE_WIDTH - grass_offset;
+
+    for (int left_x = first_x, i = 0; left_x <= last_x; left_x += GRASS_SQUARE_WIDTH, i++) {
+        draw_slanted_rect(surface, left_x, grass_top, left_x + GRASS_SQUARE_WIDTH, grass_bottom,
+            i % 2 == 0 ? LIGHT_GREEN : DARK_GREEN);
+    }
+
+    for (int left_x = first_x; left_x <= last_x; left_x += GRASS_SQUARE_WIDTH) {
+        draw_slanted_rect_outline(surface, left_x, grass_top - 1, left_x + GRASS_SQUARE_WIDTH, grass_bottom + 1, BLACK);
+    }
+}
+
+bool same_band(short int a[RESOLUTION_Y][NATIVE_STRIDE_PIXELS], short int b[RESOLUTION_Y][NATIVE_STRIDE_PIXELS],
+    int x0, int x1) {
+    for (int y = GRASS_STRIP_TOP; y < GRASS_STRIP_TOP + GRASS_STRIP_HEIGHT; y++) {
+        for (int x = x0; x <= x1; x++) {
+            if (a[y][x] != b[y][x]) return false;
+        }
+    }
+
+    return true;
+}
+
+int main(void) {
+    surface_t strip_surface, square_surface, old_surface;
+    int old_differs = 0;
+    int old_offsets = 0;
+    bool old_bottom_right = true;
+
+    initialize_grass_strip();
+    initialize_surface(&strip_surface, (char *) strip_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(strip_frame[0]));
+    initialize_surface(&square_surface, (char *) square_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(square_frame[0]));
+    initialize_surface(&old_surface, (char *) old_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(old_frame[0]));
+
+    for (int offset = 0; offset < GRASS_PERIOD; offset++) {
+        bool covered = true;
+        int differs = 0;
+
+        fill_frame(strip_frame, UNWRITTEN);
+        fill_frame(square_frame, UNWRITTEN);
+        fill_frame(old_frame, UNWRITTEN);
+
+        draw_grasses(&strip_surface, offset);
+        draw_squares(&square_surface, offset, RESOLUTION_X + GRASS_SQUARE_WIDTH + GRASS_THICKNESS);
+        draw_squares(&old_surface, offset, RESOLUTION_X);
+
+        for (int y = GRASS_STRIP_TOP; y < GRASS_STRIP_TOP + GRASS_STRIP_HEIGHT; y++) {
+            for (int x = 0; x < RESOLUTION_X; x++) {
+                if (square_frame[y][x] == UNWRITTEN) covered = false;
+                if (old_frame[y][x] == square_frame[y][x]) continue;
+
+                differs++;
+                // Below the slant that ends at the bottom right corner
+                if (x + y - GRASS_STRIP_TOP < RESOLUTION_X) old_bottom_right = false;
+            }
+        }
+
+        check(covered, "squares cover the band", offset);
+        check(same_band(strip_frame, square_frame, 0, RESOLUTION_X - 1), "strip against squares", offset);
+
+        if (differs) old_offsets++;
+        old_differs += differs;
+
+        // Clipped to a window inside the band
+        fill_frame(strip_frame, UNWRITTEN);
+        set_clip_rect(&strip_surface, 37 + offset, GRASS_STRIP_TOP + 3, 250 - offset, RESOLUTION_Y - 1);
+        draw_grasses(&strip_surface, offset);
+        reset_clip_rect(&strip_surface);
+
+        bool clipped_ok = true;
+        for (int y = 0; y < RESOLUTION_Y; y++) {
+            for (int x = 0; x < RESOLUTION_X; x++) {
+                bool inside = x >= 37 + offset && x <= 250 - offset && y >= GRASS_STRIP_TOP + 3
+                    && y < GRASS_STRIP_TOP + GRASS_STRIP_HEIGHT;
+                if (strip_frame[y][x] != (inside ? square_frame[y][x] : UNWRITTEN)) clipped_ok = false;
+            }
+        }
+        check(clipped_ok, "clipped strip", offset);
+
+        // Through a display list
+        fill_frame(strip_frame, UNWRITTEN);
+        strip_surface.list = &display_list;
+        draw_grasses(&strip_surface, offset);
+        resolve_display_list(&strip_surface);
+        strip_surface.list = NULL;
+        check(same_band(strip_frame, square_frame, 0, RESOLUTION_X - 1), "deferred strip against squares", offset);
+    }
+
+    check(old_bottom_right, "old loop only differs at the bottom right", GRASS_PERIOD);
+
+    printf("%d offsets, the old loop differs on %d pixels at %d of them\n", GRASS_PERIOD, old_differs, old_offsets);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
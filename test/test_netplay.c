@@ -0,0 +1,267 @@
+/*
+ * Host test for netplay. Two processes race each other over UDP on
+ * loopback, each with a bot at the controls. Their packets go through
+ * a shim that delays them by a latency with random jitter, reorders
+ * and drops them. Once the race is over both processes have to agree
+ * on both birds, and both birds have to end where an offline game with
+ * the same inputs ends. Reports rollbacks and the slowest frame.
+ *
+ *   gcc -std=gnu11 -O2 -o test_netplay test/test_netplay.c -lm -lpthread
+ */
+#include <sys/wait.h>
+#include <time.h>
+
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define SHIM_QUEUE 256
+#define TICK_US 1000
+#define MAX_TICKS 20000
+
+// Packets waiting in the shim until they are due
+typedef struct shim {
+    netplay_transport_t udp;
+    int latency_us;
+    int jitter_us;
+    int drop_percent;
+    unsigned int seed;
+    int count;
+    double due[SHIM_QUEUE];
+    netplay_packet_t packets[SHIM_QUEUE];
+} shim_t;
+
+typedef struct scenario {
+    const char *name;
+    int latency_us;
+    int jitter_us;
+    int drop_percent;
+} scenario_t;
+
+// What a process reports back once its race is over
+typedef struct race_result {
+    world_snapshot_t players[2];
+    bool finished;
+    int frames;
+    int ticks;
+    unsigned int rollbacks;
+    unsigned int resimulated_frames;
+    unsigned int stalls;
+    unsigned int packets_sent;
+    unsigned int packets_received;
+    double slowest_frame_us;
+} race_result_t;
+
+// The bots stop flapping here, so both races end at a known frame
+const int crash_frame[2] = {600, 900};
+
+int failures = 0;
+
+double now_s() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+unsigned int shim_random(shim_t *shim) {
+    shim->seed = shim->seed * 1103515245 + 12345;
+    return (shim->seed >> 16) & 0x7FFF;
+}
+
+// Sends every packet that is due, in queue order, so jitter reorders them
+void shim_flush(shim_t *shim) {
+    double now = now_s();
+    int kept = 0;
+
+    for (int i = 0; i < shim->count; i++) {
+        if (shim->due[i] <= now) {
+            shim->udp.send(shim->udp.context, &shim->packets[i], sizeof(netplay_packet_t));
+        } else {
+            shim->due[kept] = shim->due[i];
+            shim->packets[kept++] = shim->packets[i];
+        }
+    }
+
+    shim->count = kept;
+}
+
+bool shim_send(void *context, const void *data, int size) {
+    shim_t *shim = context;
+
+    shim_flush(shim);
+    if ((int) (shim_random(shim) % 100) < shim->drop_percent) return true;
+    if (shim->count == SHIM_QUEUE || size != sizeof(netplay_packet_t)) return false;
+
+    int jitter = shim->jitter_us ? (int) (shim_random(shim) % (2 * shim->jitter_us + 1)) - shim->jitter_us : 0;
+
+    shim->due[shim->count] = now_s() + (shim->latency_us + jitter) * 1e-6;
+    memcpy(&shim->packets[shim->count++], data, size);
+    return true;
+}
+
+int shim_receive(void *context, void *data, int size) {
+    shim_t *shim = context;
+
+    shim_flush(shim);
+    return shim->udp.receive(shim->udp.context, data, size);
+}
+
+bool bot_jump(const game_state_t *game, int frame, int player, unsigned int *noise_seed) {
+    bool jump = sweep_bot_should_jump(game, noise_seed);
+
+    return jump && frame < crash_frame[player];
+}
+
+// One kiosk: player is the local bird, the other one is remote
+void run_kiosk(udp_transport_t *udp, int peer_port, int player, const scenario_t *scenario, int out) {
+    static shim_t shim;
+    static netplay_session_t session;
+    netplay_t *net = &session.net;
+    netplay_transport_t transport = {shim_send, shim_receive, &shim};
+    race_result_t result;
+    unsigned int noise_seed = player;
+    bool jump = false;
+    bool decided = false;
+    int tick = 0;
+
+    memset(&result, 0, sizeof(result));
+    udp_transport_connect(udp, "127.0.0.1", peer_port, &shim.udp);
+    shim.latency_us = scenario->latency_us;
+    shim.jitter_us = scenario->jitter_us;
+    shim.drop_percent = scenario->drop_percent;
+    shim.seed = 77 + player;
+    shim.count = 0;
+
+    netplay_session_start(&session, &transport, NETPLAY_SEED);
+
+    for (; tick < MAX_TICKS && !netplay_session_finished(&session); tick++) {
+        // Decide once per simulated frame, and keep it through stalls
+        if (!decided) {
+            jump = net->alive[NETPLAY_LOCAL] && bot_jump(&net->players[NETPLAY_LOCAL], net->frame, player, &noise_seed);
+            decided = true;
+        }
+
+        double start = now_s();
+
+        if (netplay_session_frame(&session, jump)) decided = false;
+
+        double took = (now_s() - start) * 1e6;
+
+        if (took > result.slowest_frame_us) result.slowest_frame_us = took;
+        usleep(TICK_US);
+    }
+
+    // Let the shim deliver what it holds so the other kiosk can finish
+    for (int i = 0; i < 200; i++) {
+        netplay_session_send(&session);
+        usleep(TICK_US);
+    }
+
+    for (int p = 0; p < 2; p++) {
+        int slot = player == 0 ? p : 1 - p;
+
+        memset(&result.players[slot], 0, sizeof(world_snapshot_t));
+        save_game_snapshot(&net->players[p], &result.players[slot]);
+    }
+
+    result.finished = netplay_session_finished(&session);
+    result.frames = net->frame;
+    result.ticks = tick;
+    result.rollbacks = net->rollbacks;
+    result.resimulated_frames = net->resimulated_frames;
+    result.stalls = session.stalls;
+    result.packets_sent = session.packets_sent;
+    result.packets_received = session.packets_received;
+
+    write(out, &result, sizeof(result));
+}
+
+// The same bird played offline
+void reference_race(int player, world_snapshot_t *snapshot) {
+    game_state_t game;
+    unsigned int noise_seed = player;
+
+    env_reset(&game, NETPLAY_SEED);
+
+    for (int frame = 0; !is_game_over(&game); frame++) {
+        do_game_step(&game, bot_jump(&game, frame, player, &noise_seed));
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    save_game_snapshot(&game, snapshot);
+}
+
+void check(bool ok, const char *scenario, const char *what) {
+    if (ok) return;
+    failures++;
+    printf("FAIL %s: %s\n", scenario, what);
+}
+
+void run_scenario(const scenario_t *scenario) {
+    static udp_transport_t udp[2];
+    int ports[2];
+    int pipes[2][2];
+    pid_t children[2];
+    race_result_t results[2];
+    world_snapshot_t reference[2];
+
+    for (int p = 0; p < 2; p++) {
+        ports[p] = udp_transport_bind(&udp[p], 0);
+        check(ports[p] > 0, scenario->name, "bind");
+        if (ports[p] <= 0 || pipe(pipes[p]) < 0) return;
+    }
+
+    for (int p = 0; p < 2; p++) {
+        children[p] = fork();
+
+        if (children[p] == 0) {
+            close(udp[1 - p].socket);
+            run_kiosk(&udp[p], ports[1 - p], p, scenario, pipes[p][1]);
+            _exit(0);
+        }
+    }
+
+    for (int p = 0; p < 2; p++) {
+        close(udp[p].socket);
+        close(pipes[p][1]);
+
+        bool read_all = read(pipes[p][0], &results[p], sizeof(race_result_t)) == sizeof(race_result_t);
+
+        close(pipes[p][0]);
+        waitpid(children[p], NULL, 0);
+        check(read_all, scenario->name, "kiosk did not report");
+        if (!read_all) return;
+
+        reference_race(p, &reference[p]);
+    }
+
+    for (int p = 0; p < 2; p++) {
+        check(results[p].finished, scenario->name, "race did not finish on both kiosks");
+        check(memcmp(&results[0].players[p], &results[1].players[p], sizeof(world_snapshot_t)) == 0,
+            scenario->name, "kiosks disagree on a bird");
+        check(memcmp(&results[p].players[p], &reference[p], sizeof(world_snapshot_t)) == 0,
+            scenario->name, "bird differs from the offline game");
+
+        printf("%-16s kiosk %d: %4d frames in %5d ticks, %3u rollbacks (%4u frames), %3u stalls, "
+            "%4u/%4u packets, slowest frame %5.1f us, score %d\n",
+            scenario->name, p, results[p].frames, results[p].ticks, results[p].rollbacks,
+            results[p].resimulated_frames, results[p].stalls, results[p].packets_received,
+            results[p].packets_sent, results[p].slowest_frame_us, results[p].players[p].score);
+    }
+}
+
+int main() {
+    const scenario_t scenarios[] = {
+        {"loopback", 0, 0, 0},
+        {"5ms jitter 4ms", 5000, 4000, 0},
+        {"lossy 10%", 5000, 4000, 10},
+    };
+
+    for (int i = 0; i < (int) (sizeof(scenarios) / sizeof(scenarios[0])); i++) {
+        run_scenario(&scenarios[i]);
+    }
+
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
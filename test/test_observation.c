@@ -0,0 +1,115 @@
+/*
+ * Host test for observation grids. States from bot games, with pipes
+ * going off both edges, are rasterized, and so are the same states
+ * with the bird moved partly above the screen. Each is rasterized
+ * with render_observation and checked against a reference that
+ * classifies every screen pixel and gives each cell the highest value
+ * under it. render_observations has to give the same grids.
+ *
+ *   gcc -std=gnu11 -O2 -o test_observation test/test_observation.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define GAMES 16
+#define MAX_FRAMES 1500
+#define BATCH 8
+
+unsigned char grid[OBS_HEIGHT][OBS_WIDTH];
+unsigned char expected[OBS_HEIGHT][OBS_WIDTH];
+unsigned char grids[BATCH][OBS_HEIGHT][OBS_WIDTH];
+game_state_t batch[BATCH];
+
+int failures = 0;
+
+void check(bool ok, const char *what, int game, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s in game %d at frame %d\n", what, game, frame);
+}
+
+// What a screen pixel shows to an agent
+unsigned char pixel_class(const game_state_t *game, int x, int y) {
+    const entity_store_t *pipes = &game->pipes;
+    int sky_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
+    int bird_y = (int) game->bird.y;
+    unsigned char value = y > sky_bottom ? OBS_FLOOR : OBS_EMPTY;
+
+    for (int i = 0; i < NUM_PIPES; i++) {
+        if (x < pipes->x[i] - pipes->width[i] / 2 || x > pipes->x[i] + pipes->width[i] / 2) continue;
+        if (y <= pipes->y[i] - pipes->height[i] / 2) value = OBS_PIPE;
+        if (y >= pipes->y[i] + pipes->height[i] / 2 && y <= sky_bottom) value = OBS_PIPE;
+    }
+
+    if (x >= game->bird.x && x < game->bird.x + BIRD_WIDTH && y >= bird_y && y < bird_y + BIRD_HEIGHT)
+        value = OBS_BIRD;
+
+    return value;
+}
+
+void reference_observation(const game_state_t *game) {
+    memset(expected, OBS_EMPTY, sizeof(expected));
+
+    for (int y = 0; y < RESOLUTION_Y; y++) {
+        for (int x = 0; x < RESOLUTION_X; x++) {
+            unsigned char *cell = &expected[y >> OBS_SCALE_SHIFT][x >> OBS_SCALE_SHIFT];
+            unsigned char value = pixel_class(game, x, y);
+
+            if (value > *cell) *cell = value;
+        }
+    }
+}
+
+int main(void) {
+    int states = 0;
+    int off_edge = 0;
+
+    for (int g = 0; g < GAMES; g++) {
+        game_state_t game;
+        unsigned int noise_seed = g;
+        int batched = 0;
+
+        env_reset(&game, g);
+
+        for (int frame = 0; frame < MAX_FRAMES && !is_game_over(&game); frame++) {
+            do_game_step(&game, sweep_bot_should_jump(&game, &noise_seed));
+            if (frame % 5 != 0) continue;
+
+            reference_observation(&game);
+            render_observation(&game, grid);
+            check(memcmp(grid, expected, sizeof(grid)) == 0, "grid against pixels", g, frame);
+            states++;
+
+            // A game ends once the bird leaves the screen, so move it
+            game_state_t above = game;
+            above.bird.y = -(frame % BIRD_HEIGHT) - 0.5;
+            reference_observation(&above);
+            render_observation(&above, grid);
+            check(memcmp(grid, expected, sizeof(grid)) == 0, "bird above the screen", g, frame);
+
+            render_observation(&game, grid);
+            for (int i = 0; i < NUM_PIPES; i++) {
+                int half_width = game.pipes.width[i] / 2;
+                if (game.pipes.x[i] - half_width < 0 || game.pipes.x[i] + half_width >= RESOLUTION_X) off_edge++;
+            }
+
+            memcpy(grids[batched], grid, sizeof(grid));
+            batch[batched++] = game;
+
+            if (batched == BATCH) {
+                render_observations(batch, BATCH, grids);
+                for (int i = 0; i < BATCH; i++) {
+                    render_observation(&batch[i], grid);
+                    check(memcmp(grids[i], grid, sizeof(grid)) == 0, "batch against single", g, frame);
+                }
+                batched = 0;
+            }
+        }
+    }
+
+    check(off_edge > 0, "pipes cross the edges", GAMES, MAX_FRAMES);
+
+    printf("%d states, each also with the bird above the screen, %d pipes across an edge\n", states, off_edge);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
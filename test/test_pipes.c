@@ -0,0 +1,111 @@
+/*
+ * Host test for the pipe sprites. draw_pipe has to cover the same
+ * pixels the flat pipes drawn with draw_rect and draw_rect_outline
+ * did, with black in exactly the same places, for pipes sliding
+ * across both edges of the screen and voids near the top and the
+ * floor. Only the shading inside the outline may differ. Drawing
+ * through a display list has to give the same frame.
+ *
+ *   gcc -std=gnu11 -O2 -o test_pipes test/test_pipes.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define UNWRITTEN 0x5A5A
+
+short int sprite_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int flat_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int deferred_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+
+int failures = 0;
+
+void check(bool ok, const char *what, int x, int y) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s for the pipe at %d, %d\n", what, x, y);
+}
+
+void fill_frame(short int frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS]) {
+    for (int y = 0; y < RESOLUTION_Y; y++) {
+        for (int x = 0; x < NATIVE_STRIDE_PIXELS; x++) frame[y][x] = UNWRITTEN;
+    }
+}
+
+// Pipe i the way it was drawn before the sprites, in one flat color
+void draw_flat_pipe(const surface_t *surface, const entity_store_t *store, int i) {
+    int x0 = store->x[i] - (store->width[i] / 2);
+    int x1 = store->x[i] + (store->width[i] / 2);
+    int y_top_pipe_edge = store->y[i] - (store->height[i] / 2);
+    int y_bottom_pipe_edge = store->y[i] + (store->height[i] / 2);
+    int y_screen_bottom = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1;
+
+    draw_rect(surface, x0, 0, x1, y_top_pipe_edge, PIPE_COLOR);
+    draw_rect_outline(surface, x0, -1, x1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, BLACK);
+    draw_rect_outline(surface, x0 - 1, y_top_pipe_edge - PIPE_HEAD_HEIGHT, x1 + 1, y_top_pipe_edge, BLACK);
+
+    draw_rect(surface, x0, y_bottom_pipe_edge, x1, y_screen_bottom, PIPE_COLOR);
+    draw_rect_outline(surface, x0, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, x1, y_screen_bottom, BLACK);
+    draw_rect_outline(surface, x0 - 1, y_bottom_pipe_edge, x1 + 1, y_bottom_pipe_edge + PIPE_HEAD_HEIGHT, BLACK);
+}
+
+int main(void) {
+    surface_t sprite_surface, flat_surface, deferred_surface;
+    game_state_t game;
+    int pipes = 0;
+    int shaded = 0;
+
+    memset(&game, 0, sizeof(game));
+    env_reset(&game, 3);
+    initialize_pipe_sprites();
+
+    initialize_surface(&sprite_surface, (char *) sprite_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(sprite_frame[0]));
+    initialize_surface(&flat_surface, (char *) flat_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(flat_frame[0]));
+    initialize_surface(&deferred_surface, (char *) deferred_frame, RESOLUTION_X, RESOLUTION_Y,
+        sizeof(deferred_frame[0]));
+    deferred_surface.list = &display_list;
+
+    entity_store_t *store = &game.pipes;
+    int void_half = store->height[0] / 2;
+    int y_lowest = RESOLUTION_Y - TOTAL_FLOOR_HEIGHT - 1 - void_half - PIPE_HEAD_HEIGHT - 2;
+
+    for (int x = -PIPE_WIDTH; x <= RESOLUTION_X + PIPE_WIDTH; x += 7) {
+        for (int y = void_half + PIPE_HEAD_HEIGHT + 1; y <= y_lowest; y += 5) {
+            bool same_outline = true;
+            bool deferred_same = true;
+
+            store->x[0] = x;
+            store->y[0] = y;
+
+            fill_frame(sprite_frame);
+            fill_frame(flat_frame);
+            fill_frame(deferred_frame);
+
+            draw_pipe(&sprite_surface, store, 0);
+            draw_flat_pipe(&flat_surface, store, 0);
+            draw_pipe(&deferred_surface, store, 0);
+            resolve_display_list(&deferred_surface);
+
+            for (int py = 0; py < RESOLUTION_Y; py++) {
+                for (int px = 0; px < RESOLUTION_X; px++) {
+                    color_t sprite = sprite_frame[py][px];
+                    color_t flat = flat_frame[py][px];
+
+                    if ((sprite == UNWRITTEN) != (flat == UNWRITTEN)) same_outline = false;
+                    if ((sprite == BLACK) != (flat == BLACK)) same_outline = false;
+                    if (sprite != UNWRITTEN && sprite != BLACK && sprite != PIPE_COLOR) shaded++;
+                    if (deferred_frame[py][px] != sprite) deferred_same = false;
+                }
+            }
+
+            check(same_outline, "coverage and outline against flat pipes", x, y);
+            check(deferred_same, "deferred against immediate", x, y);
+            pipes++;
+        }
+    }
+
+    check(shaded > 0, "pipes are shaded", 0, 0);
+
+    printf("%d pipes, %d shaded pixels\n", pipes, shaded);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
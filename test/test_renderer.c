@@ -0,0 +1,150 @@
+/*
+ * Host test for the deferred renderer. Draws the same frames of a game,
+ * the game over screen and the menu immediately and through a display
+ * list, and checks the frames are identical and that the display list
+ * writes every pixel at most once.
+ *
+ *   gcc -std=gnu11 -O2 -o test_renderer test/test_renderer.c -lm -lpthread
+ */
+#include <time.h>
+
+#define main board_main
+#include "../main.c"
+#undef main
+
+short int immediate_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+short int deferred_frame[RESOLUTION_Y][NATIVE_STRIDE_PIXELS];
+
+double now_ns() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+bool ghosted[RESOLUTION_Y][RESOLUTION_X];
+
+// Pixels the recorded commands would write when drawn one by one. The
+// ghosts are drawn immediately as one silhouette, so a pixel under
+// several masked blends counts once
+unsigned int recorded_writes(const display_list_t *list) {
+    unsigned int total = 0;
+
+    memset(ghosted, 0, sizeof(ghosted));
+
+    for (int i = 0; i < list->count; i++) {
+        const draw_command_t *command = &list->commands[i];
+        bool masked = command->type == DRAW_BLEND && command->source;
+
+        for (int y = command->y0; y <= command->y1; y++) {
+            for (int x = command->x0; x <= command->x1; x++) {
+                int tile_x = x & ~(TILE_WIDTH - 1);
+
+                if (!((command_coverage(command, tile_x, y) >> (x - tile_x)) & 1)) continue;
+                if (masked && ghosted[y][x]) continue;
+
+                ghosted[y][x] = masked;
+                total++;
+            }
+        }
+    }
+
+    return total;
+}
+
+// One frame of each screen the game shows, picked by frame % 3
+void draw_scene(const surface_t *screen, game_state_t *game, int frame) {
+    int ghost_y[64];
+
+    if (frame % 3 == 0) {
+        redraw_background_behind_pipes(screen, game);
+        draw_entities(screen, &game->pipes);
+
+        for (int i = 0; i < 64; i++) ghost_y[i] = (int) game->bird.y + (i * 37 + frame) % 120 - 60;
+        draw_ghost_birds(screen, game->bird.x, ghost_y, 64, WHITE, GHOST_ALPHA);
+
+        draw_bird(screen, game->bird);
+        draw_score(screen, game->score, SCORE_POS_X, SCORE_POS_Y);
+    } else if (frame % 3 == 1) {
+        redraw_background(screen, game);
+        draw_entities(screen, &game->pipes);
+        blend_rect(screen, 0, 0, RESOLUTION_X - 1, SKY_THICKNESS - 1, BLACK, GAME_OVER_DIM_ALPHA);
+        draw_text(screen, "GAME OVER", 20, 30, TITLE_CHAR_SCALE, WHITE, BLACK);
+        draw_rect(screen, 70, 130, RESOLUTION_X - 70, 130 + 22, ORANGE);
+        draw_rect_outline(screen, 70, 130, RESOLUTION_X - 70, 130 + 22, BLACK);
+        blend_rect(screen, 60, 120, 200, 160, YELLOW, 20);
+        draw_score(screen, game->best_score, 206, 100);
+    } else {
+        redraw_background(screen, game);
+        draw_bird(screen, game->bird);
+        draw_text(screen, "FLAPPY BIRD", 30, 45, TITLE_CHAR_SCALE, WHITE, BLACK);
+        draw_rect(screen, 90, 110, RESOLUTION_X - 40, 110 + 22, ORANGE);
+        draw_rect_outline(screen, 90, 110, RESOLUTION_X - 40, 110 + 22, BLACK);
+    }
+}
+
+int main(void) {
+    surface_t immediate, deferred;
+    game_state_t game;
+    int failures = 0;
+    double immediate_ns = 0, deferred_ns = 0;
+    unsigned long long immediate_writes = 0, deferred_writes = 0;
+
+    memset(&game, 0, sizeof(game));
+    game.config = default_game_config;
+    game.seed = 5;
+    initialize_pipes(&game);
+    initialize_bird(&game.bird);
+    initialize_sky();
+    initialize_bird_mask();
+    initialize_bird_frames();
+    initialize_font();
+    initialize_grass_strip();
+    initialize_pipe_sprites();
+
+    initialize_surface(&immediate, (char *) immediate_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(immediate_frame[0]));
+    initialize_surface(&deferred, (char *) deferred_frame, RESOLUTION_X, RESOLUTION_Y, sizeof(deferred_frame[0]));
+    draw_background(&immediate, &game);
+    draw_background(&deferred, &game);
+    deferred.list = &display_list;
+
+    for (int frame = 0; frame < 600; frame++) {
+        double t0 = now_ns();
+        draw_scene(&immediate, &game, frame);
+        double t1 = now_ns();
+
+        display_list.pixels_written = 0;
+        draw_scene(&deferred, &game, frame);
+        double t2 = now_ns();
+
+        // Counted before the resolve empties the list
+        immediate_writes += recorded_writes(&display_list);
+
+        double t3 = now_ns();
+        resolve_display_list(&deferred);
+        double t4 = now_ns();
+
+        deferred_writes += display_list.pixels_written;
+        immediate_ns += t1 - t0;
+        deferred_ns += (t2 - t1) + (t4 - t3);
+
+        if (memcmp(immediate_frame, deferred_frame, sizeof(immediate_frame))) {
+            printf("FAIL frame %d differs\n", frame);
+            failures++;
+        }
+
+        if (display_list.pixels_written > RESOLUTION_X * RESOLUTION_Y) {
+            printf("FAIL frame %d wrote %u pixels\n", frame, display_list.pixels_written);
+            failures++;
+        }
+
+        if (!is_game_over(&game)) do_game_step(&game, autopilot_should_jump(&game));
+        game.grass_offset = (game.grass_offset + game.config.scroll_amount) % GRASS_PERIOD;
+        animation_tick++;
+    }
+
+    printf("pixels written per frame: immediate %llu, deferred %llu\n", immediate_writes / 600, deferred_writes / 600);
+    printf("immediate %.1f us/frame, deferred %.1f us/frame\n", immediate_ns / 600 / 1000, deferred_ns / 600 / 1000);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
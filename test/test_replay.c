@@ -0,0 +1,147 @@
+/*
+ * Host test for replays. Records a game long enough for the keyframe
+ * index to be thinned twice, then checks that seeking to a frame gives
+ * exactly the state that playing the recorded inputs up to that frame
+ * gives, at keyframes, next to them and in between, at both keyframe
+ * intervals the replay has used. It also checks that a snapshot keeps
+ * the entity count and the kind of every slot.
+ *
+ *   gcc -std=gnu11 -O2 -o test_replay test/test_replay.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+// Enough frames to fill the keyframe index twice over
+#define FRAMES (2 * REPLAY_MAX_KEYFRAMES * REPLAY_KEYFRAME_FRAMES + 1234)
+#define NUM_SEEKS 64
+
+replay_t recording;
+bool inputs[FRAMES];
+
+int failures = 0;
+
+void check(bool ok, const char *what, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at frame %d\n", what, frame);
+}
+
+// Everything a frame of the game depends on
+bool same_game(const game_state_t *a, const game_state_t *b) {
+    world_snapshot_t sa, sb;
+
+    memset(&sa, 0, sizeof(sa));
+    memset(&sb, 0, sizeof(sb));
+    save_game_snapshot(a, &sa);
+    save_game_snapshot(b, &sb);
+
+    if (memcmp(&sa, &sb, sizeof(sa)) != 0) return false;
+    if (a->bird.x != b->bird.x || a->bird.wing_tick != b->bird.wing_tick) return false;
+    if (a->grass_offset != b->grass_offset || a->pipes.count != b->pipes.count) return false;
+
+    for (int i = 0; i < a->pipes.count; i++) {
+        if (a->pipes.x[i] != b->pipes.x[i] || a->pipes.y[i] != b->pipes.y[i]) return false;
+        if (a->pipes.flags[i] != b->pipes.flags[i] || a->pipes.kind[i] != b->pipes.kind[i]) return false;
+    }
+
+    return true;
+}
+
+// The entity count and every slot's kind come back from a snapshot
+void check_entity_slots(const game_config_t *config) {
+    game_state_t game, restored;
+    world_snapshot_t snapshot;
+
+    memset(&game, 0, sizeof(game));
+    env_reset_config(&game, 5, config);
+    game.pipes.count = NUM_PIPES + 1;
+    game.pipes.kind[NUM_PIPES] = ENTITY_PIPE + 1;
+
+    memset(&restored, 0, sizeof(restored));
+    restored.config = *config;
+    save_game_snapshot(&game, &snapshot);
+    restore_game_snapshot(&restored, &snapshot);
+
+    check(restored.pipes.count == game.pipes.count, "entity count", 0);
+    check(memcmp(restored.pipes.kind, game.pipes.kind, sizeof(game.pipes.kind)) == 0, "entity kinds", 0);
+}
+
+int compare_ints(const void *a, const void *b) {
+    return *(const int *) a - *(const int *) b;
+}
+
+int main(void) {
+    game_config_t config = default_game_config;
+    game_state_t game, played, seeked;
+    unsigned int noise_seed = 7;
+    int seeks[NUM_SEEKS];
+    int count = 0;
+
+    // A void wide enough that the bot never dies
+    config.pipe_void_height = 90;
+    check_entity_slots(&config);
+
+    memset(&game, 0, sizeof(game));
+    env_reset_config(&game, 99, &config);
+    replay_start(&recording, &game);
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        inputs[frame] = sweep_bot_should_jump(&game, &noise_seed);
+        check(replay_record_frame(&recording, &game, inputs[frame]), "recording", frame);
+        do_scroll_grasses(&game);
+        do_game_step(&game, inputs[frame]);
+        check(!is_game_over(&game), "bot alive", frame);
+        if (failures) break;
+    }
+
+    check(recording.header.keyframe_interval == 4 * REPLAY_KEYFRAME_FRAMES, "keyframes thinned twice", FRAMES);
+
+    // Keyframes of every interval, the frames around them, the ends
+    // and a few frames in between
+    int interval = REPLAY_KEYFRAME_FRAMES;
+    for (int k = 0; k < 3; k++, interval *= 2) {
+        int at = (k + 3) * interval;
+
+        seeks[count++] = at - 1;
+        seeks[count++] = at;
+        seeks[count++] = at + 1;
+    }
+    seeks[count++] = 0;
+    seeks[count++] = 1;
+    seeks[count++] = FRAMES - 1;
+    seeks[count++] = FRAMES;
+
+    while (count < NUM_SEEKS) {
+        noise_seed = noise_seed * 1103515245 + 12345;
+        seeks[count++] = (noise_seed >> 8) % FRAMES;
+    }
+
+    qsort(seeks, NUM_SEEKS, sizeof(int), compare_ints);
+
+    // Play the inputs once from the start, stopping at every seek
+    memset(&played, 0, sizeof(played));
+    env_reset_config(&played, 99, &config);
+
+    int frame = 0;
+    for (int i = 0; i < NUM_SEEKS; i++) {
+        replay_cursor_t cursor;
+
+        for (; frame < seeks[i]; frame++) {
+            do_scroll_grasses(&played);
+            do_game_step(&played, inputs[frame]);
+        }
+
+        seeked = played;
+        check(replay_seek(&recording, seeks[i], &seeked, &cursor) == seeks[i], "seek frame", seeks[i]);
+        check(cursor.frame == seeks[i], "cursor frame", seeks[i]);
+        check(same_game(&seeked, &played), "seek against play", seeks[i]);
+
+        // The cursor goes on with the inputs that were recorded
+        if (seeks[i] < FRAMES) check(replay_next_input(&recording, &cursor) == inputs[seeks[i]], "next input", seeks[i]);
+    }
+
+    printf("%d frames, keyframes every %d frames, %d input bytes, %d seeks\n", recording.header.frame_count,
+        recording.header.keyframe_interval, recording.header.input_bytes, NUM_SEEKS);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
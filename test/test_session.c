@@ -0,0 +1,130 @@
+/*
+ * Host test that runs the board's own main through the host platform
+ * layer. It plays the same scripted session as demo/test.js: the menu,
+ * a game flown by the same bot until frame 240, the game over screen,
+ * back to the menu and into a second game. Every frame swapped in is
+ * hashed the way the demo hashes its framebuffer and checked against
+ * demo/test_hashes.json, so the port and the board code can't drift.
+ *
+ *   gcc -std=gnu11 -O2 -o test_session test/test_session.c -lm -lpthread
+ */
+// The demo's session uses the reference rand() so pipe heights match
+#define rand session_rand
+#define main board_main
+#include "../main.c"
+#undef main
+#undef rand
+
+#include <setjmp.h>
+
+#define FRAMES 400
+#define HASHES_PATH "../../demo/test_hashes.json"
+
+unsigned int session_seed = 1;
+unsigned int hashes[FRAMES];
+int frames = 0;
+bool screen_ready = false;
+int top_score = 0;
+int mode_changes = 0;
+int last_mode = -1;
+jmp_buf session_done;
+
+int session_rand(void) {
+    session_seed = session_seed * 1103515245 + 12345;
+    return (session_seed >> 16) & 0x7FFF;
+}
+
+// FNV-1a over the visible pixels, like hash_frame in the demo
+unsigned int hash_front_buffer() {
+    const char *front = board_memory(*pixel_ctrl_ptr);
+    unsigned int hash = 0x811C9DC5;
+
+    for (int y = 0; y < RESOLUTION_Y; y++) {
+        const unsigned short *row = (const unsigned short *)(front + y * NATIVE_STRIDE_PIXELS * sizeof(short int));
+
+        for (int x = 0; x < RESOLUTION_X; x++) {
+            hash = (hash ^ row[x]) * 0x01000193;
+        }
+    }
+
+    return hash;
+}
+
+// Flaps whenever the bird sinks below the middle of the next void,
+// the same bot as demo/test.js
+bool bot_should_jump(const game_state_t *game) {
+    const entity_store_t *pipes = &game->pipes;
+    int next = -1;
+
+    for (int i = 0; i < pipes->count; i++) {
+        if (pipes->x[i] + pipes->width[i] / 2 < game->bird.x) continue;
+        if (next < 0 || pipes->x[i] < pipes->x[next]) next = i;
+    }
+
+    return next >= 0 && game->bird.y_velocity < 0 && game->bird.y + 12 > pipes->y[next];
+}
+
+// Keys pressed before the frame with this index is drawn
+void press_scripted_keys(int index) {
+    if (index == 20 || index == 340) host_press_key(ENTER_KEY);
+    if (index == 310) host_press_key(BACK_SPACE_KEY);
+    if (host_game->mode == MODE_GAME && index < 240 && bot_should_jump(host_game)) host_press_key(SPACE_KEY);
+}
+
+// Runs on every swap, like next_frame in demo/test.js
+void session_frame() {
+    // The first swap is initialize_screen's, before anything is drawn
+    if (!screen_ready) {
+        screen_ready = true;
+        return;
+    }
+
+    hashes[frames] = hash_front_buffer();
+    if (host_game->score > top_score) top_score = host_game->score;
+    if (host_game->mode != last_mode) mode_changes++;
+    last_mode = host_game->mode;
+
+    if (++frames == FRAMES) longjmp(session_done, 1);
+
+    press_scripted_keys(frames);
+}
+
+// Reads the hex strings out of the demo's JSON array
+int read_expected(unsigned int *expected, int max) {
+    FILE *file = fopen(HASHES_PATH, "r");
+    int count = 0;
+    int c;
+
+    if (!file) return -1;
+
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '"' && count < max && fscanf(file, "%8x", &expected[count]) == 1) count++;
+        while (c == '"' && (c = fgetc(file)) != EOF && c != '"');
+    }
+
+    fclose(file);
+    return count;
+}
+
+int main(void) {
+    unsigned int expected[FRAMES];
+    int failures = 0;
+
+    host_frame_hook = session_frame;
+    if (!setjmp(session_done)) board_main();
+
+    int count = read_expected(expected, FRAMES);
+    if (count != FRAMES) {
+        printf("FAIL read %d hashes from %s\n", count, HASHES_PATH);
+        failures++;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (hashes[i] == expected[i]) continue;
+        if (failures++ < 10) printf("FAIL frame %d: %08x, expected %08x\n", i, hashes[i], expected[i]);
+    }
+
+    printf("%d frames, %d modes, top score %d\n", FRAMES, mode_changes, top_score);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
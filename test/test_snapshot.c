@@ -0,0 +1,98 @@
+/*
+ * Host test for world snapshots. States from bot games with a few
+ * rule sets are saved and restored into a game that has only the same
+ * config, and the restored game has to equal the original in every
+ * field a snapshot covers. Both are then played on with the same jumps
+ * and have to stay equal, and saving the restored game has to give
+ * the same bytes again.
+ *
+ *   gcc -std=gnu11 -O2 -o test_snapshot test/test_snapshot.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define GAMES 12
+#define MAX_FRAMES 1500
+#define PLAY_ON_FRAMES 120
+
+int failures = 0;
+
+void check(bool ok, const char *what, int game, int frame) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s in game %d at frame %d\n", what, game, frame);
+}
+
+// Every field of a game a snapshot covers
+bool same_world(const game_state_t *a, const game_state_t *b) {
+    if (a->bird.x != b->bird.x || a->bird.y != b->bird.y || a->bird.y_velocity != b->bird.y_velocity) return false;
+    if (a->bird.wing_tick != b->bird.wing_tick) return false;
+    if (a->seed != b->seed || a->score != b->score || a->grass_offset != b->grass_offset) return false;
+    if (a->pipes.count != b->pipes.count) return false;
+
+    for (int i = 0; i < a->pipes.count; i++) {
+        if (a->pipes.kind[i] != b->pipes.kind[i] || a->pipes.flags[i] != b->pipes.flags[i]) return false;
+        if (a->pipes.x[i] != b->pipes.x[i] || a->pipes.y[i] != b->pipes.y[i]) return false;
+        if (a->pipes.width[i] != b->pipes.width[i] || a->pipes.height[i] != b->pipes.height[i]) return false;
+    }
+
+    return true;
+}
+
+int main(void) {
+    game_config_t configs[3] = {default_game_config, default_game_config, default_game_config};
+    int round_trips = 0;
+
+    configs[1].pipe_spacing = 90;
+    configs[1].scroll_amount = 4;
+    configs[2].pipe_void_height = 100;
+    configs[2].pipe_spacing = 160;
+
+    for (int g = 0; g < GAMES; g++) {
+        const game_config_t *config = &configs[g % 3];
+        game_state_t game;
+        unsigned int noise_seed = g;
+
+        memset(&game, 0, sizeof(game));
+        env_reset_config(&game, g, config);
+
+        for (int frame = 0; frame < MAX_FRAMES && !is_game_over(&game); frame++) {
+            do_scroll_grasses(&game);
+            do_game_step(&game, sweep_bot_should_jump(&game, &noise_seed));
+            if (frame % 7 != 0) continue;
+
+            world_snapshot_t snapshot, again;
+            game_state_t restored;
+
+            memset(&snapshot, 0, sizeof(snapshot));
+            memset(&again, 0, sizeof(again));
+            memset(&restored, 0, sizeof(restored));
+            restored.config = *config;
+
+            save_game_snapshot(&game, &snapshot);
+            restore_game_snapshot(&restored, &snapshot);
+            check(same_world(&game, &restored), "restored world", g, frame);
+
+            save_game_snapshot(&restored, &again);
+            check(memcmp(&snapshot, &again, sizeof(snapshot)) == 0, "snapshot of the restored world", g, frame);
+
+            game_state_t played = game;
+            unsigned int played_noise = noise_seed;
+            unsigned int restored_noise = noise_seed;
+
+            for (int i = 0; i < PLAY_ON_FRAMES && !is_game_over(&played); i++) {
+                do_scroll_grasses(&played);
+                do_scroll_grasses(&restored);
+                do_game_step(&played, sweep_bot_should_jump(&played, &played_noise));
+                do_game_step(&restored, sweep_bot_should_jump(&restored, &restored_noise));
+            }
+
+            check(same_world(&played, &restored), "played on from the snapshot", g, frame);
+            round_trips++;
+        }
+    }
+
+    printf("%d round trips, %d bytes each\n", round_trips, (int) sizeof(world_snapshot_t));
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
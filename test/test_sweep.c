@@ -0,0 +1,163 @@
+/*
+ * Host test for the parameter sweep. sweep_config has to record the
+ * score and survival of every game the way playing the same seeds by
+ * hand does, and splitting the games into ranges, run in order or on
+ * threads, has to add up to the same result. A wider void has to give
+ * the bot a better mean score, and sweep_score_percentile is checked
+ * on a histogram with known answers.
+ *
+ *   gcc -std=gnu11 -O2 -o test_sweep test/test_sweep.c -lm -lpthread
+ */
+#include <pthread.h>
+
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define GAMES 240
+#define THREADS 4
+
+int failures = 0;
+
+void check(bool ok, const char *what, int value) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s (%d)\n", what, value);
+}
+
+bool same_result(const sweep_result_t *a, const sweep_result_t *b) {
+    return a->games == b->games
+        && memcmp(a->score_histogram, b->score_histogram, sizeof(a->score_histogram)) == 0
+        && memcmp(a->alive, b->alive, sizeof(a->alive)) == 0;
+}
+
+double mean_score(const sweep_result_t *result) {
+    long total = 0;
+
+    for (int score = 0; score <= SWEEP_MAX_SCORE; score++) total += (long) score * result->score_histogram[score];
+    return (double) total / result->games;
+}
+
+// sweep_config played out game by game
+void reference_sweep(const game_config_t *config, sweep_result_t *result) {
+    memset(result, 0, sizeof(*result));
+
+    for (int i = 0; i < GAMES; i++) {
+        game_state_t game;
+        unsigned int noise_seed = i;
+        int frames = 0;
+
+        env_reset_config(&game, i, config);
+        while (frames < SWEEP_MAX_FRAMES) {
+            do_game_step(&game, sweep_bot_should_jump(&game, &noise_seed));
+            frames++;
+            if (is_game_over(&game)) break;
+        }
+
+        // Alive at a curve point means still playing when it is reached
+        for (int point = 0; point < SWEEP_CURVE_POINTS; point++) {
+            if (point * SWEEP_CURVE_STEP < frames || (frames == SWEEP_MAX_FRAMES && !is_game_over(&game)))
+                result->alive[point]++;
+        }
+
+        result->score_histogram[clamp(game.score, 0, SWEEP_MAX_SCORE)]++;
+        result->games++;
+    }
+}
+
+typedef struct sweep_job {
+    const game_config_t *config;
+    int first_game;
+    int count;
+    sweep_result_t result;
+} sweep_job_t;
+
+void *run_job(void *arg) {
+    sweep_job_t *job = arg;
+
+    memset(&job->result, 0, sizeof(job->result));
+    sweep_config(job->config, job->first_game, job->count, &job->result);
+    return NULL;
+}
+
+void check_ranges(const game_config_t *config, const sweep_result_t *whole) {
+    sweep_result_t split;
+    sweep_job_t jobs[THREADS];
+    pthread_t threads[THREADS];
+
+    // Uneven ranges, added into one result in order
+    memset(&split, 0, sizeof(split));
+    sweep_config(config, 0, 17, &split);
+    sweep_config(config, 17, 100, &split);
+    sweep_config(config, 117, GAMES - 117, &split);
+    check(same_result(&split, whole), "ranges in order", split.games);
+
+    for (int t = 0; t < THREADS; t++) {
+        jobs[t].config = config;
+        jobs[t].first_game = t * GAMES / THREADS;
+        jobs[t].count = (t + 1) * GAMES / THREADS - jobs[t].first_game;
+        pthread_create(&threads[t], NULL, run_job, &jobs[t]);
+    }
+
+    memset(&split, 0, sizeof(split));
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+
+        split.games += jobs[t].result.games;
+        for (int s = 0; s <= SWEEP_MAX_SCORE; s++) split.score_histogram[s] += jobs[t].result.score_histogram[s];
+        for (int p = 0; p < SWEEP_CURVE_POINTS; p++) split.alive[p] += jobs[t].result.alive[p];
+    }
+    check(same_result(&split, whole), "ranges on threads", split.games);
+}
+
+void check_percentiles() {
+    sweep_result_t result;
+
+    // Scores 0, 1, 1, 2, 5 and 5 times 9
+    memset(&result, 0, sizeof(result));
+    result.score_histogram[0] = 1;
+    result.score_histogram[1] = 2;
+    result.score_histogram[2] = 1;
+    result.score_histogram[5] = 1;
+    result.score_histogram[9] = 5;
+    result.games = 10;
+
+    check(sweep_score_percentile(&result, 10) == 0, "10th percentile", sweep_score_percentile(&result, 10));
+    check(sweep_score_percentile(&result, 30) == 1, "30th percentile", sweep_score_percentile(&result, 30));
+    check(sweep_score_percentile(&result, 50) == 5, "50th percentile", sweep_score_percentile(&result, 50));
+    check(sweep_score_percentile(&result, 51) == 9, "51st percentile", sweep_score_percentile(&result, 51));
+    check(sweep_score_percentile(&result, 100) == 9, "100th percentile", sweep_score_percentile(&result, 100));
+}
+
+int main(void) {
+    game_config_t narrow = default_game_config;
+    game_config_t wide = default_game_config;
+    sweep_result_t narrow_result, wide_result, reference;
+
+    narrow.pipe_void_height = sweep_pipe_void_heights[0];
+    wide.pipe_void_height = sweep_pipe_void_heights[sizeof(sweep_pipe_void_heights) / sizeof(int) - 1];
+
+    memset(&narrow_result, 0, sizeof(narrow_result));
+    memset(&wide_result, 0, sizeof(wide_result));
+    sweep_config(&narrow, 0, GAMES, &narrow_result);
+    sweep_config(&wide, 0, GAMES, &wide_result);
+
+    reference_sweep(&narrow, &reference);
+    check(same_result(&narrow_result, &reference), "narrow void against games by hand", narrow_result.games);
+    reference_sweep(&wide, &reference);
+    check(same_result(&wide_result, &reference), "wide void against games by hand", wide_result.games);
+
+    check(narrow_result.alive[0] == GAMES, "every game alive at frame 0", narrow_result.alive[0]);
+    for (int p = 1; p < SWEEP_CURVE_POINTS; p++) {
+        check(wide_result.alive[p] <= wide_result.alive[p - 1], "survival never rises", p);
+    }
+
+    check(mean_score(&wide_result) > mean_score(&narrow_result), "wider void scores higher", wide.pipe_void_height);
+
+    check_ranges(&wide, &wide_result);
+    check_percentiles();
+
+    printf("%d games, mean score %.1f with a %d pixel void, %.1f with %d\n", GAMES,
+        mean_score(&narrow_result), narrow.pipe_void_height, mean_score(&wide_result), wide.pipe_void_height);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Host test for the upscaler. upscale_row has to repeat every input
+ * pixel scale times for scales 1 to 4 and every width up to a few
+ * pairs, without writing past the row. upscale_surface has to put
+ * every source pixel into its scale x scale block in the centre of
+ * the destination, on an even left edge, and leave the letterbox
+ * around it alone.
+ *
+ *   gcc -std=gnu11 -O2 -o test_upscale test/test_upscale.c -lm -lpthread
+ */
+#define main board_main
+#include "../main.c"
+#undef main
+
+#define MAX_SCALE 4
+#define MAX_WIDTH 21
+#define GUARD 0xDEAD
+#define SRC_W 13
+#define SRC_H 7
+#define DST_STRIDE_PIXELS 64
+#define DST_H 40
+
+// 4 byte aligned, like the rows upscale_surface hands out
+unsigned short in_row[MAX_WIDTH] __attribute__((aligned(4)));
+unsigned short out_row[MAX_WIDTH * MAX_SCALE + 8] __attribute__((aligned(4)));
+unsigned short src_pixels[SRC_H][SRC_W + 3];
+unsigned short dst_pixels[DST_H][DST_STRIDE_PIXELS] __attribute__((aligned(4)));
+
+int failures = 0;
+unsigned int random_seed = 11;
+
+void check(bool ok, const char *what, int scale, int width) {
+    if (ok) return;
+    if (failures++ < 10) printf("FAIL %s at scale %d, width %d\n", what, scale, width);
+}
+
+unsigned short random_pixel() {
+    random_seed = random_seed * 1103515245 + 12345;
+    return random_seed >> 16;
+}
+
+void check_rows() {
+    for (int scale = 1; scale <= MAX_SCALE; scale++) {
+        for (int width = 1; width <= MAX_WIDTH; width++) {
+            bool ok = true;
+
+            for (int x = 0; x < width; x++) in_row[x] = random_pixel();
+            for (int i = 0; i < MAX_WIDTH * MAX_SCALE + 8; i++) out_row[i] = GUARD;
+
+            upscale_row(out_row, in_row, width, scale);
+
+            for (int x = 0; x < width * scale; x++) {
+                if (out_row[x] != in_row[x / scale]) ok = false;
+            }
+            check(ok, "row pixels", scale, width);
+
+            for (int x = width * scale; x < MAX_WIDTH * MAX_SCALE + 8; x++) {
+                if (out_row[x] != GUARD) ok = false;
+            }
+            check(ok, "row stays in bounds", scale, width);
+        }
+    }
+}
+
+void check_surfaces() {
+    surface_t src, dst;
+
+    initialize_surface(&src, (char *) src_pixels, SRC_W, SRC_H, sizeof(src_pixels[0]));
+
+    for (int scale = 1; scale <= MAX_SCALE; scale++) {
+        // Odd margins, so the even left edge is needed
+        int width = SRC_W * scale + 7;
+        int height = SRC_H * scale + 3;
+        int left = ((width - SRC_W * scale) / 2) & ~1;
+        int top = (height - SRC_H * scale) / 2;
+        bool pixels_ok = true;
+        bool letterbox_ok = true;
+
+        for (int y = 0; y < SRC_H; y++) {
+            for (int x = 0; x < SRC_W; x++) src_pixels[y][x] = random_pixel();
+        }
+        for (int y = 0; y < DST_H; y++) {
+            for (int x = 0; x < DST_STRIDE_PIXELS; x++) dst_pixels[y][x] = GUARD;
+        }
+
+        initialize_surface(&dst, (char *) dst_pixels, width, height, sizeof(dst_pixels[0]));
+        upscale_surface(&src, &dst, scale);
+
+        for (int y = 0; y < DST_H; y++) {
+            for (int x = 0; x < DST_STRIDE_PIXELS; x++) {
+                int sx = x - left;
+                int sy = y - top;
+
+                if (sx >= 0 && sx < SRC_W * scale && sy >= 0 && sy < SRC_H * scale) {
+                    if (dst_pixels[y][x] != src_pixels[sy / scale][sx / scale]) pixels_ok = false;
+                } else if (dst_pixels[y][x] != GUARD) {
+                    letterbox_ok = false;
+                }
+            }
+        }
+
+        check(pixels_ok, "surface pixels", scale, width);
+        check(letterbox_ok, "letterbox untouched", scale, width);
+    }
+}
+
+int main(void) {
+    check_rows();
+    check_surfaces();
+
+    printf("scales 1 to %d, rows up to %d pixels, %dx%d surfaces\n", MAX_SCALE, MAX_WIDTH, SRC_W, SRC_H);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}